@@ -0,0 +1,232 @@
+/**
+ * @file   ArenaAllocator.h
+ * @brief  Simple monotonic memory arena and an allocator drawing from it
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * This library provides:
+ *
+ * * MonotonicArena: a memory pool which is only released as a whole
+ * * ArenaAllocator: a standard-conforming allocator using a `MonotonicArena`
+ *
+ * This library is header only.
+ *
+ * These classes play the role of `std::pmr::monotonic_buffer_resource` and
+ * `std::pmr::polymorphic_allocator`, which are not available in all the
+ * supported compilers.
+ *
+ */
+
+#ifndef LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_ARENAALLOCATOR_H
+#define LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_ARENAALLOCATOR_H
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t, std::max_align_t
+#include <cstdint> // std::uintptr_t
+#include <algorithm> // std::max()
+#include <memory> // std::unique_ptr<>
+#include <vector>
+#include <new> // std::bad_alloc
+
+
+namespace lar {
+  namespace example {
+
+    // BEGIN RemoveIsolatedSpacePoints group -----------------------------------
+    /// @ingroup RemoveIsolatedSpacePoints
+    /// @{
+    /**
+     * @brief A memory pool only released as a whole
+     *
+     * Memory is requested in blocks (of at least `blockSize()` bytes) from the
+     * system and then handed out sequentially, by a simple pointer increment.
+     * Memory returned to the arena is not reused until `reset()` is called,
+     * at which point all the memory served so far is considered free again.
+     * The blocks obtained from the system are kept by `reset()`: a typical
+     * pattern is to have an arena for the whole job and call `reset()` after
+     * each event, when all the objects using it have been destroyed.
+     * `release()` returns all the memory to the system instead.
+     *
+     * The arena is not thread-safe: each thread should use its own.
+     *
+     * Memory locality policies (e.g. NUMA node binding) can be enforced by
+     * creating the arena in the thread which is going to use it, since the
+     * blocks are obtained from the system on first use.
+     */
+    class MonotonicArena {
+
+        public:
+      /// Default size of the memory blocks (1 MiB)
+      static constexpr std::size_t DefaultBlockSize = 1048576;
+
+      /// Constructor: blocks will be at least `blockSize` bytes large
+      explicit MonotonicArena(std::size_t blockSize = DefaultBlockSize)
+        : minBlockSize(std::max(blockSize, sizeof(std::max_align_t)))
+        {}
+
+      // arena can't be copied, since the memory is owned
+      MonotonicArena(MonotonicArena const&) = delete;
+      MonotonicArena& operator= (MonotonicArena const&) = delete;
+
+      /// Returns `bytes` bytes of memory aligned to `alignment`
+      /// @throw std::bad_alloc if the system does not provide memory
+      void* allocate(std::size_t bytes, std::size_t alignment);
+
+      /// Memory is not returned to the arena until the next `reset()`
+      void deallocate(void*, std::size_t) {}
+
+      /// Makes all the memory available again, without releasing it
+      void reset() { current = 0; used = 0; }
+
+      /// Returns all the memory to the system
+      void release() { blocks.clear(); reset(); }
+
+      /// Returns the minimum size of the blocks requested to the system
+      std::size_t blockSize() const { return minBlockSize; }
+
+      /// Returns the total memory currently owned by the arena [bytes]
+      std::size_t capacity() const;
+
+
+        private:
+      /// A memory block obtained from the system
+      struct Block_t {
+        std::unique_ptr<char[]> memory; ///< memory of the block
+        std::size_t size; ///< size of the block [bytes]
+      }; // Block_t
+
+      std::size_t minBlockSize; ///< minimum size of a new block [bytes]
+
+      std::vector<Block_t> blocks; ///< all the memory blocks in the arena
+      std::size_t current = 0; ///< index of the block being served
+      std::size_t used = 0; ///< memory already served from current block
+
+      /// Returns memory from the current block, `nullptr` if not enough
+      void* allocateFromCurrent(std::size_t bytes, std::size_t alignment);
+
+    }; // class MonotonicArena
+
+
+    /**
+     * @brief Allocator serving memory from a `MonotonicArena`
+     * @tparam T type of the allocated object
+     *
+     * Deallocation is a no-op: the memory is recovered by resetting the arena.
+     * The arena must outlive all the containers using the allocator.
+     * All the allocators on the same arena compare equal.
+     *
+     * Example: a partition for an event
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * lar::example::MonotonicArena arena; // kept for all events
+     *
+     * // for each event:
+     * std::vector<size_t> nonIsolated = algo.removeIsolatedPoints(
+     *   points.begin(), points.end(),
+     *   lar::example::ArenaAllocator<std::array<double, 3> const*>(arena)
+     *   );
+     * arena.reset();
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     */
+    template <typename T>
+    class ArenaAllocator {
+      template <typename U> friend class ArenaAllocator;
+
+        public:
+      using value_type = T; ///< type of allocated object
+
+      /// Constructor: serves memory from the specified arena
+      ArenaAllocator(MonotonicArena& arena) noexcept: arena(&arena) {}
+
+      /// Conversion from an allocator of another type
+      template <typename U>
+      ArenaAllocator(ArenaAllocator<U> const& other) noexcept
+        : arena(other.arena)
+        {}
+
+      /// Returns memory for `n` objects of type `T`
+      T* allocate(std::size_t n)
+        { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+
+      /// Does nothing (memory is recovered when the arena is reset)
+      void deallocate(T* p, std::size_t n) noexcept
+        { arena->deallocate(p, n * sizeof(T)); }
+
+      /// Returns the arena memory is served from
+      MonotonicArena& resource() const { return *arena; }
+
+      /// Returns whether the two allocators use the same arena
+      template <typename U>
+      bool operator== (ArenaAllocator<U> const& other) const
+        { return arena == other.arena; }
+
+      /// Returns whether the two allocators use different arenas
+      template <typename U>
+      bool operator!= (ArenaAllocator<U> const& other) const
+        { return arena != other.arena; }
+
+        private:
+      MonotonicArena* arena; ///< arena memory is served from
+
+    }; // class ArenaAllocator<>
+
+
+    /// @}
+    // END RemoveIsolatedSpacePoints group -------------------------------------
+
+  } // namespace example
+} // namespace lar
+
+
+//------------------------------------------------------------------------------
+//--- inline implementation
+//------------------------------------------------------------------------------
+//--- lar::example::MonotonicArena
+//---
+inline void* lar::example::MonotonicArena::allocate
+  (std::size_t bytes, std::size_t alignment)
+{
+  // try the current block, then the next ones (left over from a reset())
+  while (current < blocks.size()) {
+    void* memory = allocateFromCurrent(bytes, alignment);
+    if (memory) return memory;
+    ++current;
+    used = 0;
+  } // while
+
+  // we need a new block, large enough for any alignment
+  std::size_t const size = std::max(minBlockSize, bytes + alignment);
+  blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+  current = blocks.size() - 1;
+  used = 0;
+  void* memory = allocateFromCurrent(bytes, alignment);
+  if (!memory) throw std::bad_alloc(); // should not happen
+  return memory;
+
+} // lar::example::MonotonicArena::allocate()
+
+
+//------------------------------------------------------------------------------
+inline std::size_t lar::example::MonotonicArena::capacity() const {
+  std::size_t total = 0;
+  for (Block_t const& block: blocks) total += block.size;
+  return total;
+} // lar::example::MonotonicArena::capacity()
+
+
+//------------------------------------------------------------------------------
+inline void* lar::example::MonotonicArena::allocateFromCurrent
+  (std::size_t bytes, std::size_t alignment)
+{
+  Block_t const& block = blocks[current];
+  std::uintptr_t const base
+    = reinterpret_cast<std::uintptr_t>(block.memory.get());
+  std::uintptr_t const start
+    = (base + used + alignment - 1) / alignment * alignment;
+  if (start + bytes > base + block.size) return nullptr;
+  used = start + bytes - base;
+  return reinterpret_cast<void*>(start);
+} // lar::example::MonotonicArena::allocateFromCurrent()
+
+
+//------------------------------------------------------------------------------
+
+#endif // LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_ARENAALLOCATOR_H
@@ -0,0 +1,343 @@
+/**
+ * @file   ClusterSpacePoints_module.cc
+ * @brief  Module grouping space points in clusters by their density
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * Provides:
+ *
+ * * `lar::example::ClusterSpacePoints` module
+ *
+ */
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointClusteringAlg.h"
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIsolationAlg.h" // PositionExtractor<recob::SpacePoint>
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndexService.h"
+#include "lardataobj/RecoBase/SpacePoint.h"
+#include "lardataobj/RecoBase/PFParticle.h"
+
+// framework libraries
+#include "art/Framework/Core/SharedProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h" // art::ValidHandle
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Persistency/Common/PtrMaker.h"
+#include "canvas/Persistency/Common/Assns.h"
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Utilities/InputTag.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "fhiclcpp/types/Atom.h"
+#include "cetlib/pow.h" // cet::square()
+
+// C/C++ standard libraries
+#include <vector>
+#include <algorithm> // std::min(), std::max()
+#include <limits> // std::numeric_limits<>
+#include <memory> // std::make_unique()
+
+
+namespace lar {
+  namespace example {
+
+    /**
+     * @brief _art_ module: groups space points into clusters.
+     * @see @ref RemoveIsolatedSpacePoints "RemoveIsolatedSpacePoints example overview"
+     * @ingroup RemoveIsolatedSpacePoints
+     *
+     * The space points are grouped by the DBSCAN algorithm implemented in
+     * `PointClusteringAlg`: a space point with at least `minPoints` space
+     * points within a distance `epsilon` (itself included) is a core point,
+     * and clusters are made of core points within `epsilon` of each other,
+     * plus the other points within `epsilon` of them. The remaining space
+     * points (noise) are not in any cluster.
+     * With `minPoints` set to `2`, the noise points are the same that
+     * `RemoveIsolatedSpacePoints` would remove with an isolation radius equal
+     * to `epsilon`.
+     *
+     * This is a shared module: several events may be processed at the same
+     * time, since a new algorithm object is created for each event.
+     * This holds also when `useSharedIndex` is set, since
+     * `SpacePointIndexService` keeps the indices of each event separate.
+     *
+     * Input
+     * ------
+     *
+     * A collection of `recob::SpacePoint` is required.
+     *
+     *
+     * Output
+     * ------
+     *
+     * The grouping is stored in the LArSoft way for three-dimensional
+     * objects:
+     *
+     * * a collection of `recob::PFParticle`, one per cluster, with no parent
+     *   nor daughters and PDG ID `0` (unknown);
+     * * an association of each `recob::PFParticle` with all the space points
+     *   in its cluster, in the order they have in the input collection.
+     *
+     * The clusters are in order of their first core point.
+     *
+     *
+     * Configuration parameters
+     * =========================
+     *
+     * * *spacePoints* (input tag, _mandatory_): label of the data product with
+     *   input space points
+     * * *epsilon* (real, _mandatory_): radius of the neighbourhood of a space
+     *   point [cm]
+     * * *minPoints* (integer, default: `2`): number of space points within
+     *   `epsilon` (itself included) making a space point a core point
+     * * *useSharedIndex* (boolean, default: `false`): instead of partitioning
+     *   the space points on its own, the algorithm uses the index from
+     *   `SpacePointIndexService`, which is built only once per event for all
+     *   the modules using it (the service must be configured); the index
+     *   cells should be no larger than `epsilon` divided by @f$ \sqrt{3} @f$
+     *   for the best performance
+     *
+     */
+    class ClusterSpacePoints: public art::SharedProducer {
+
+        public:
+
+      /// Module configuration data
+      struct Config {
+
+        using Name    = fhicl::Name;
+        using Comment = fhicl::Comment;
+
+        fhicl::Atom<art::InputTag> spacePoints{
+          Name("spacePoints"),
+          Comment("the space points to be clustered")
+          };
+
+        fhicl::Atom<double> epsilon{
+          Name("epsilon"),
+          Comment("radius of the neighbourhood of a space point [cm]")
+          };
+
+        fhicl::Atom<unsigned int> minPoints{
+          Name("minPoints"),
+          Comment("space points in the neighbourhood of a core point"),
+          2U
+          };
+
+        fhicl::Atom<bool> useSharedIndex{
+          Name("useSharedIndex"),
+          Comment("use the space point index from SpacePointIndexService"),
+          false
+          };
+
+      }; // Config
+
+      /// Standard _art_ alias for module configuration table
+      using Parameters = art::SharedProducer::Table<Config>;
+
+      /// Constructor; see the class documentation for the configuration
+      explicit ClusterSpacePoints
+        (Parameters const& config, art::ProcessingFrame const&);
+
+
+      virtual void produce
+        (art::Event& event, art::ProcessingFrame const&) override;
+
+
+        private:
+      /// Type of the clustering algorithm
+      using ClusteringAlg_t = PointClusteringAlg<double>;
+
+      art::InputTag spacePointsLabel; ///< label of the input data product
+
+      double epsilon; ///< neighbourhood radius [cm]
+      unsigned int minPoints; ///< number of neighbours of core points
+      bool useSharedIndex; ///< whether to use the shared index
+
+      /// Returns the labels of the clusters of the specified space points
+      std::vector<ClusteringAlg_t::ClusterLabel_t> clusterSpacePoints
+        (std::vector<recob::SpacePoint> const& spacePoints) const;
+
+      /// Returns the labels of the clusters of the points in the index
+      std::vector<ClusteringAlg_t::ClusterLabel_t> clusterSpacePoints
+        (SpacePointIndex const& index) const;
+
+      /// Returns the algorithm configuration for the specified volume
+      ClusteringAlg_t::Configuration_t makeConfiguration(
+        ClusteringAlg_t::Range_t const& rangeX,
+        ClusteringAlg_t::Range_t const& rangeY,
+        ClusteringAlg_t::Range_t const& rangeZ
+        ) const;
+
+    }; // class ClusterSpacePoints
+
+
+  } // namespace example
+} // namespace lar
+
+
+
+//------------------------------------------------------------------------------
+//--- ClusterSpacePoints
+//---
+lar::example::ClusterSpacePoints::ClusterSpacePoints
+  (Parameters const& config, art::ProcessingFrame const&)
+  : SharedProducer{config}
+  , spacePointsLabel(config().spacePoints())
+  , epsilon(config().epsilon())
+  , minPoints(config().minPoints())
+  , useSharedIndex(config().useSharedIndex())
+{
+  consumes<std::vector<recob::SpacePoint>>(spacePointsLabel);
+  produces<std::vector<recob::PFParticle>>();
+  produces<art::Assns<recob::PFParticle, recob::SpacePoint>>();
+
+  // the shared index service is also safe for concurrent events
+  async<art::InEvent>();
+
+} // lar::example::ClusterSpacePoints::ClusterSpacePoints()
+
+
+//------------------------------------------------------------------------------
+void lar::example::ClusterSpacePoints::produce
+  (art::Event& event, art::ProcessingFrame const&)
+{
+
+  //
+  // read the input
+  //
+  auto spacePointHandle
+    = event.getValidHandle<std::vector<recob::SpacePoint>>(spacePointsLabel);
+  auto const& spacePoints = *spacePointHandle;
+
+  //
+  // run the algorithm
+  //
+  std::vector<ClusteringAlg_t::ClusterLabel_t> labels;
+  if (useSharedIndex) {
+    art::ServiceHandle<SpacePointIndexService> indexService;
+    labels = clusterSpacePoints(indexService->index(event, spacePointsLabel));
+  }
+  else labels = clusterSpacePoints(spacePoints);
+  size_t const nClusters = ClusteringAlg_t::countClusters(labels);
+
+  //
+  // prepare the output structures
+  //
+  auto clusters = std::make_unique<std::vector<recob::PFParticle>>();
+  auto clusterToPoints = std::make_unique
+    <art::Assns<recob::PFParticle, recob::SpacePoint>>();
+
+  art::PtrMaker<recob::SpacePoint> makePointPtr
+    (event, spacePointHandle.id());
+  art::PtrMaker<recob::PFParticle> makeClusterPtr(event);
+
+  clusters->reserve(nClusters);
+  for (size_t iCluster = 0; iCluster < nClusters; ++iCluster) {
+    clusters->emplace_back(
+      0, iCluster, recob::PFParticle::kPFParticlePrimary,
+      std::vector<size_t>()
+      );
+  } // for
+
+  //
+  // create the associations
+  //
+  size_t nNoise = 0;
+  for (size_t iPoint = 0; iPoint < labels.size(); ++iPoint) {
+    if (labels[iPoint] == ClusteringAlg_t::NoiseLabel) {
+      ++nNoise;
+      continue;
+    }
+    clusterToPoints->addSingle
+      (makeClusterPtr(labels[iPoint]), makePointPtr(iPoint));
+  } // for
+
+  //
+  // store the data products into the event (and print a short summary)
+  //
+  mf::LogInfo("ClusterSpacePoints")
+    << "Found " << nClusters << " clusters in " << spacePoints.size()
+    << " space points from '" << spacePointsLabel.encode() << "' ("
+    << nNoise << " not clustered)";
+
+  event.put(std::move(clusters));
+  event.put(std::move(clusterToPoints));
+
+} // lar::example::ClusterSpacePoints::produce()
+
+
+//------------------------------------------------------------------------------
+auto lar::example::ClusterSpacePoints::clusterSpacePoints
+  (std::vector<recob::SpacePoint> const& spacePoints) const
+  -> std::vector<ClusteringAlg_t::ClusterLabel_t>
+{
+  if (spacePoints.empty()) return {};
+
+  //
+  // the volume is the one covered by the space points, with some margin so
+  // that the last points are not on the border
+  //
+  constexpr double max = std::numeric_limits<double>::max();
+  double lower[3] = { max, max, max };
+  double upper[3] = { -max, -max, -max };
+  for (recob::SpacePoint const& spacePoint: spacePoints) {
+    auto const* xyz = spacePoint.XYZ();
+    for (unsigned int i = 0; i < 3U; ++i) {
+      lower[i] = std::min(lower[i], double(xyz[i]));
+      upper[i] = std::max(upper[i], double(xyz[i]));
+    } // for
+  } // for
+
+  ClusteringAlg_t::Configuration_t const config = makeConfiguration(
+    { lower[0], upper[0] + epsilon },
+    { lower[1], upper[1] + epsilon },
+    { lower[2], upper[2] + epsilon }
+    );
+
+  return ClusteringAlg_t(config).clusterPoints(spacePoints);
+} // lar::example::ClusterSpacePoints::clusterSpacePoints()
+
+
+//------------------------------------------------------------------------------
+auto lar::example::ClusterSpacePoints::clusterSpacePoints
+  (SpacePointIndex const& index) const
+  -> std::vector<ClusteringAlg_t::ClusterLabel_t>
+{
+  // the volume is the one covered by the index
+  auto const& ranges = index.partition().ranges();
+  ClusteringAlg_t::Configuration_t const config = makeConfiguration(
+    { ranges[0].lower, ranges[0].upper },
+    { ranges[1].lower, ranges[1].upper },
+    { ranges[2].lower, ranges[2].upper }
+    );
+
+  return ClusteringAlg_t(config)
+    .clusterPoints(index.partition(), index.begin(), index.end());
+} // lar::example::ClusterSpacePoints::clusterSpacePoints(SpacePointIndex)
+
+
+//------------------------------------------------------------------------------
+auto lar::example::ClusterSpacePoints::makeConfiguration(
+  ClusteringAlg_t::Range_t const& rangeX,
+  ClusteringAlg_t::Range_t const& rangeY,
+  ClusteringAlg_t::Range_t const& rangeZ
+) const -> ClusteringAlg_t::Configuration_t
+{
+  ClusteringAlg_t::Configuration_t config;
+  config.rangeX = rangeX;
+  config.rangeY = rangeY;
+  config.rangeZ = rangeZ;
+  config.epsilon2 = cet::square(epsilon);
+  config.minPoints = minPoints;
+
+  ClusteringAlg_t::validateConfiguration(config);
+
+  return config;
+} // lar::example::ClusterSpacePoints::makeConfiguration()
+
+
+//------------------------------------------------------------------------------
+DEFINE_ART_MODULE(lar::example::ClusterSpacePoints)
+
+
+//------------------------------------------------------------------------------
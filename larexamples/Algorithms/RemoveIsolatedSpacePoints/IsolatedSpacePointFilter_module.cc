@@ -0,0 +1,318 @@
+/**
+ * @file   IsolatedSpacePointFilter_module.cc
+ * @brief  Filter rejecting events with too many isolated space points
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * Provides:
+ *
+ * * `lar::example::IsolatedSpacePointFilter` module
+ *
+ */
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIsolationAlg.h"
+#include "lardataobj/RecoBase/SpacePoint.h"
+#include "larcore/Geometry/Geometry.h"
+
+// framework libraries
+#include "art/Framework/Core/SharedFilter.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "canvas/Utilities/InputTag.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Table.h"
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <vector>
+#include <random>
+#include <numeric> // std::iota()
+#include <algorithm> // std::shuffle()
+#include <cmath> // std::sqrt(), std::abs()
+
+
+namespace lar {
+  namespace example {
+
+    /**
+     * @brief _art_ module: rejects events with too many isolated space points.
+     * @see @ref RemoveIsolatedSpacePoints "RemoveIsolatedSpacePoints example overview"
+     * @ingroup RemoveIsolatedSpacePoints
+     *
+     * Events dominated by noise have most of their space points isolated.
+     * This filter estimates the fraction of isolated space points in the
+     * event, and rejects the event if that fraction is larger than
+     * `maxIsolatedFraction`. Isolation is determined by the
+     * `SpacePointIsolationAlg` algorithm, as in `RemoveIsolatedSpacePoints`.
+     *
+     * The space points are tested one by one in random order, and the test
+     * stops as soon as the outcome is decided:
+     *
+     * * exactly, when enough points are isolated (or not isolated) that the
+     *   outcome would not change even if all the remaining points were not
+     *   isolated (or isolated);
+     * * statistically, after at least `minSample` points are tested, when the
+     *   fraction of isolated points in the sample differs from the threshold
+     *   by more than `significance` times its standard deviation (as expected
+     *   from a sample of that size, without replacement, from a collection
+     *   with the fraction of isolated points at the threshold).
+     *
+     * The statistical criterion can be disabled by setting `significance` to
+     * `0`. Either way, the decision is exact when all the points are tested.
+     * The random order is seeded from `seed` and the event ID, so that the
+     * decision on an event is reproducible.
+     * Events with no space points are accepted.
+     *
+     *
+     * Input
+     * ------
+     *
+     * A collection of `recob::SpacePoint` is required.
+     *
+     *
+     * Output
+     * ------
+     *
+     * No data product is produced.
+     *
+     *
+     * Configuration parameters
+     * =========================
+     *
+     * * *spacePoints* (input tag, _mandatory_): label of the data product with
+     *   input space points
+     * * *isolation* (parameter set, _mandatory_): configuration for the
+     *   isolation algorithm, as in `RemoveIsolatedSpacePoints`; per-point
+     *   radii (`errorScale`) are not supported
+     * * *maxIsolatedFraction* (real, _mandatory_): events with a larger
+     *   fraction of isolated space points are rejected
+     * * *significance* (real, default: `3`): number of standard deviations
+     *   from the threshold that decides the outcome from a sample; `0` uses
+     *   only exact decisions
+     * * *minSample* (integer, default: `100`): minimum number of points tested
+     *   before a statistical decision
+     * * *seed* (integer, default: `0`): seed for the random order of the test
+     *
+     */
+    class IsolatedSpacePointFilter: public art::SharedFilter {
+
+        public:
+
+      /// Module configuration data
+      struct Config {
+
+        using Name    = fhicl::Name;
+        using Comment = fhicl::Comment;
+
+        fhicl::Atom<art::InputTag> spacePoints{
+          Name("spacePoints"),
+          Comment("the space points to be tested")
+          };
+
+        fhicl::Table<SpacePointIsolationAlg::Config> isolation{
+          Name("isolation"),
+          Comment("settings for the isolation algorithm")
+          };
+
+        fhicl::Atom<double> maxIsolatedFraction{
+          Name("maxIsolatedFraction"),
+          Comment("events with a larger fraction of isolated points fail")
+          };
+
+        fhicl::Atom<double> significance{
+          Name("significance"),
+          Comment("standard deviations deciding from a sample (0: exact)"),
+          3.0
+          };
+
+        fhicl::Atom<unsigned int> minSample{
+          Name("minSample"),
+          Comment("points tested before a statistical decision"),
+          100U
+          };
+
+        fhicl::Atom<unsigned int> seed{
+          Name("seed"),
+          Comment("seed for the random order of the test"),
+          0U
+          };
+
+      }; // Config
+
+      /// Standard _art_ alias for module configuration table
+      using Parameters = art::SharedFilter::Table<Config>;
+
+      /// Constructor; see the class documentation for the configuration
+      explicit IsolatedSpacePointFilter
+        (Parameters const& config, art::ProcessingFrame const&);
+
+
+      virtual bool beginRun
+        (art::Run& run, art::ProcessingFrame const&) override;
+
+      virtual bool filter
+        (art::Event& event, art::ProcessingFrame const&) override;
+
+
+        private:
+      art::InputTag spacePointsLabel; ///< label of the input data product
+
+      double maxIsolatedFraction; ///< largest isolated fraction of passing events
+      double significance; ///< standard deviations for a sample decision
+      unsigned int minSample; ///< points before a statistical decision
+      unsigned int seed; ///< seed for the order of the test
+
+      SpacePointIsolationAlg isolAlg; ///< instance of the algorithm
+
+      /// Returns whether the outcome of the test is decided by `count`,
+      /// out of `nPoints` points
+      bool isDecided(
+        SpacePointIsolationAlg::IsolationCount_t const& count,
+        size_t nPoints
+        ) const;
+
+    }; // class IsolatedSpacePointFilter
+
+
+  } // namespace example
+} // namespace lar
+
+
+
+//------------------------------------------------------------------------------
+//--- IsolatedSpacePointFilter
+//---
+lar::example::IsolatedSpacePointFilter::IsolatedSpacePointFilter
+  (Parameters const& config, art::ProcessingFrame const&)
+  : SharedFilter{config}
+  , spacePointsLabel(config().spacePoints())
+  , maxIsolatedFraction(config().maxIsolatedFraction())
+  , significance(config().significance())
+  , minSample(config().minSample())
+  , seed(config().seed())
+  , isolAlg(config().isolation())
+{
+  if ((maxIsolatedFraction < 0.0) || (maxIsolatedFraction > 1.0)) {
+    throw cet::exception("IsolatedSpacePointFilter")
+      << "The maximum isolated fraction ("
+      << config().maxIsolatedFraction.name() << ": " << maxIsolatedFraction
+      << ") must be in [ 0, 1 ] range\n";
+  }
+  if (significance < 0.0) {
+    throw cet::exception("IsolatedSpacePointFilter")
+      << "The significance (" << config().significance.name() << ": "
+      << significance << ") can't be negative\n";
+  }
+  if (config().isolation().errorScale() > 0.0) {
+    throw cet::exception("IsolatedSpacePointFilter")
+      << "Per-point isolation radii (errorScale: "
+      << config().isolation().errorScale() << ") are not supported\n";
+  }
+
+  consumes<std::vector<recob::SpacePoint>>(spacePointsLabel);
+
+  // the algorithm is not modified while processing events
+  async<art::InEvent>();
+
+} // lar::example::IsolatedSpacePointFilter::IsolatedSpacePointFilter()
+
+
+//------------------------------------------------------------------------------
+bool lar::example::IsolatedSpacePointFilter::beginRun
+  (art::Run&, art::ProcessingFrame const&)
+{
+
+  //
+  // set up the algorithm (the geometry may change only between runs)
+  //
+  auto const* geom = lar::providerFrom<geo::Geometry>();
+  isolAlg.setup(*geom);
+
+  return true;
+} // lar::example::IsolatedSpacePointFilter::beginRun()
+
+
+//------------------------------------------------------------------------------
+bool lar::example::IsolatedSpacePointFilter::filter
+  (art::Event& event, art::ProcessingFrame const&)
+{
+
+  //
+  // read the input
+  //
+  auto const& spacePoints
+    = *(event.getValidHandle<std::vector<recob::SpacePoint>>(spacePointsLabel));
+  size_t const nPoints = spacePoints.size();
+  if (nPoints == 0) return true;
+
+  //
+  // the points are tested in an order random but reproducible
+  //
+  std::vector<size_t> order(nPoints);
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::seed_seq seeds{
+    seed, event.run(), event.subRun(), event.event()
+    };
+  std::mt19937_64 engine(seeds);
+  std::shuffle(order.begin(), order.end(), engine);
+
+  //
+  // run the algorithm
+  //
+  SpacePointIsolationAlg::IsolationCount_t const count
+    = isolAlg.countIsolatedPoints(
+      spacePoints, order.cbegin(), order.cend(),
+      [this, nPoints](SpacePointIsolationAlg::IsolationCount_t const& count)
+        { return isDecided(count, nPoints); }
+      );
+
+  double const isolatedFraction = double(count.isolated) / count.tested;
+  bool const pass = (isolatedFraction <= maxIsolatedFraction);
+
+  mf::LogInfo("IsolatedSpacePointFilter")
+    << "Found " << count.isolated << "/" << count.tested
+    << " isolated space points in a sample of the " << nPoints
+    << " from '" << spacePointsLabel.encode() << "': event "
+    << (pass? "passed": "rejected");
+
+  return pass;
+} // lar::example::IsolatedSpacePointFilter::filter()
+
+
+//------------------------------------------------------------------------------
+bool lar::example::IsolatedSpacePointFilter::isDecided(
+  SpacePointIsolationAlg::IsolationCount_t const& count,
+  size_t nPoints
+) const
+{
+  //
+  // exact decision: the remaining points can't change the outcome
+  //
+  double const maxIsolated = maxIsolatedFraction * nPoints;
+  if (count.isolated > maxIsolated) return true;
+  if (count.isolated + (nPoints - count.tested) <= maxIsolated) return true;
+
+  //
+  // statistical decision: the fraction in the sample is too far from the
+  // threshold to have been drawn from a collection at the threshold
+  //
+  if ((significance <= 0.0) || (count.tested < minSample)) return false;
+  if (count.tested >= nPoints) return true;
+
+  double const fraction = double(count.isolated) / count.tested;
+  double const variance
+    = maxIsolatedFraction * (1.0 - maxIsolatedFraction) / count.tested
+    * double(nPoints - count.tested) / (nPoints - 1);
+  return std::abs(fraction - maxIsolatedFraction)
+    > significance * std::sqrt(variance);
+
+} // lar::example::IsolatedSpacePointFilter::isDecided()
+
+
+//------------------------------------------------------------------------------
+DEFINE_ART_MODULE(lar::example::IsolatedSpacePointFilter)
+
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,739 @@
+/**
+ * @file   PointClusteringAlg.h
+ * @brief  Density-based clustering of points in space (DBSCAN)
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * This library contains only template classes and it is header only.
+ *
+ */
+
+#ifndef LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_POINTCLUSTERINGALG_H
+#define LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_POINTCLUSTERINGALG_H
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointIsolationAlg.h" // details::IsolationVolume
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePartition.h"
+
+// infrastructure and utilities
+#include "cetlib/pow.h" // cet::square()
+
+// C/C++ standard libraries
+#include <cassert> // assert()
+#include <cmath> // std::sqrt(), std::ceil()
+#include <algorithm> // std::min(), std::max()
+#include <numeric> // std::iota()
+#include <vector>
+#include <array>
+#include <string>
+#include <memory> // std::allocator
+#include <utility> // std::index_sequence
+#include <iterator> // std::cbegin(), std::cend(), std::distance()
+#include <stdexcept> // std::runtime_error
+
+
+namespace lar {
+  namespace example {
+
+    // BEGIN RemoveIsolatedSpacePoints group -----------------------------------
+    /// @ingroup RemoveIsolatedSpacePoints
+    /// @{
+    /**
+     * @brief Algorithm clustering points by their density (DBSCAN)
+     * @tparam Coord type of the coordinate
+     * @tparam Dims number of dimensions of the space (`3` or `2`)
+     * @see @ref RemoveIsolatedSpacePoints "RemoveIsolatedSpacePoints example overview"
+     *
+     * This algorithm assigns each of the input points to a cluster, or marks
+     * it as noise, following the DBSCAN prescription with a radius
+     * @f$ \epsilon @f$ and a minimum number of points @f$ m @f$:
+     *
+     * * the neighbours of a point are all the points not farther than
+     *   @f$ \epsilon @f$ from it, the point itself included;
+     * * a point with at least @f$ m @f$ neighbours is a "core" point;
+     * * two core points which are neighbours belong to the same cluster, and a
+     *   cluster is made of all the core points connected this way;
+     * * a point which is not a core point, but has core points among its
+     *   neighbours, is a "border" point and it joins the cluster of its
+     *   closest core neighbour (or the one with the lowest index, on ties);
+     * * all the other points are noise.
+     *
+     * With @f$ m = 2 @f$, the noise points are exactly the isolated points
+     * of `PointIsolationAlg` with isolation radius @f$ R = \epsilon @f$.
+     *
+     * The result is a label for each input point: noise points have label
+     * `NoiseLabel`, while the clusters are numbered from `0` on, in order of
+     * the lowest index among their core points. The result does not depend on
+     * the order the points are processed in.
+     *
+     * The configuration (`Configuration_t`) defines the volume the points
+     * span, the square of @f$ \epsilon @f$ and @f$ m @f$. As in
+     * `PointIsolationAlg`, the volume is not checked: if input points lie
+     * outside it, the result is undefined.
+     *
+     * The algorithm can be run on any collection of points, as long as the
+     * point class supports the `PositionExtractor` class.
+     *
+     *
+     * Description of the algorithm
+     * -----------------------------
+     *
+     * The points are grouped into the cells of a `SpacePartition`, of the same
+     * size as the ones of `PointIsolationAlg` (unless the maximum memory
+     * requires larger cells): the cell diagonal is not larger than
+     * @f$ \epsilon @f$, so that all the points in the same cell are
+     * neighbours of each other. The neighbourhood of a cell includes all the
+     * cells within @f$ \epsilon @f$ on each dimension, and it is explored
+     * via the occupancy map of the partition
+     * (`SpacePartition::forEachOccupiedNeighbor()`).
+     *
+     * 1. Core points: all the points of a cell with at least @f$ m @f$
+     *    points are core points; in the other cells, the neighbours of each
+     *    point are counted, until @f$ m @f$ are found.
+     * 2. Clusters: the core points are joined with a union-find structure.
+     *    All the core points in the same cell are joined at once; then the
+     *    core points of each pair of neighbouring cells are compared, until
+     *    the two cells are found to belong to the same cluster.
+     * 3. Border points: each non-core point looks for its closest core point
+     *    in its neighbourhood.
+     *
+     */
+    template <typename Coord = double, unsigned int Dims = 3U>
+    class PointClusteringAlg {
+
+        public:
+      /// Type of coordinate
+      using Coord_t = Coord;
+      using Range_t = CoordRange<Coord_t>;
+
+      /// Type of the label of the cluster of a point
+      using ClusterLabel_t = int;
+
+      /// Label of the points not belonging to any cluster
+      static constexpr ClusterLabel_t NoiseLabel = -1;
+
+      /// Returns the number of dimensions of the space
+      static constexpr unsigned int dims() { return Dims; }
+
+      /// Type containing all configuration parameters of the algorithm
+      /// (`rangeX`, `rangeY` and, in 3D, `rangeZ` are inherited)
+      struct Configuration_t: public details::IsolationVolume<Range_t, Dims> {
+        Coord_t epsilon2; ///< square of the neighbourhood radius [cm^2]
+        unsigned int minPoints = 2;
+                          ///< neighbours making a core point (itself included)
+        size_t maxMemory = 100 * 1048576;
+                          ///< grid smaller than this number of bytes (100 MiB)
+      }; // Configuration_t
+
+
+      /// @{
+      /// @name Configuration
+
+      /// Constructor (no validation is performed on the configuration)
+      PointClusteringAlg(Configuration_t const& first_config)
+        : config(first_config)
+        {}
+
+      /// Reconfigures the algorithm with the specified configuration
+      /// (no validation is performed)
+      /// @see configuration()
+      void reconfigure(Configuration_t const& new_config)
+        { config = new_config; }
+
+      /// Returns a constant reference to the current configuration
+      /// @see reconfigure()
+      Configuration_t const& configuration() const { return config; }
+
+      /// @}
+
+
+      /**
+       * @brief Returns the cluster label of each point
+       * @tparam PointIter random access iterator to a point type
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @return the cluster label of each point, in the input order
+       *
+       * The label of the point at `begin + i` is the element `i` of the
+       * returned collection. Points not in any cluster have `NoiseLabel`.
+       */
+      template <typename PointIter>
+      std::vector<ClusterLabel_t> clusterPoints
+        (PointIter begin, PointIter end) const;
+
+      /**
+       * @brief Returns the cluster label of each point
+       * @tparam PointIter random access iterator to a point type
+       * @tparam Alloc type of allocator of the partition
+       * @param partition space partition already filled with the points
+       * @param begin iterator to the first point in the partition
+       * @param end iterator after the last point in the partition
+       * @return the cluster label of each point, in the input order
+       * @see clusterPoints(PointIter begin, PointIter end) const
+       *
+       * This method is equivalent to `clusterPoints(PointIter, PointIter)`,
+       * but it uses an existing partition (e.g. one shared with
+       * `PointIsolationAlg`). The partition can have any cell size, but the
+       * shortcuts on the points of the same cell are applied only if the cell
+       * diagonal is not larger than @f$ \epsilon @f$.
+       */
+      template <typename PointIter, typename Alloc>
+      std::vector<ClusterLabel_t> clusterPoints(
+        SpacePartition<PointIter, Alloc, Dims> const& partition,
+        PointIter begin, PointIter end
+        ) const;
+
+      /**
+       * @brief Returns the cluster label of each point
+       * @param points list of the points
+       * @return the cluster label of each point, in the input order
+       * @see clusterPoints(PointIter begin, PointIter end) const
+       */
+      template <typename Cont>
+      std::vector<ClusterLabel_t> clusterPoints(Cont const& points) const
+        { return clusterPoints(std::cbegin(points), std::cend(points)); }
+
+
+      /**
+       * @brief Brute-force reference algorithm
+       * @tparam PointIter random access iterator to a point type
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @return the cluster label of each point, in the input order
+       * @see clusterPoints
+       *
+       * This algorithm executes the task in a @f$ N^{2} @f$ way, slow and
+       * supposedly reliable, with the same result as `clusterPoints()`.
+       * Use this only for tests.
+       */
+      template <typename PointIter>
+      std::vector<ClusterLabel_t> bruteClusterPoints
+        (PointIter begin, PointIter end) const;
+
+
+      /// Returns the number of clusters in the specified labels
+      static size_t countClusters(std::vector<ClusterLabel_t> const& labels);
+
+
+      /// @{
+      /// @name Configuration
+
+      /// Throws an exception if the configuration is invalid
+      /// @throw std::runtime_error if configuration is invalid
+      static void validateConfiguration(Configuration_t const& config);
+
+      /// @}
+
+
+      /// Returns the largest cell size with all the points of a cell being
+      /// neighbours of each other
+      static Coord_t maximumOptimalCellSize(Coord_t epsilon)
+        { return PointIsolationAlg<Coord_t, Dims>::maximumOptimalCellSize(epsilon); }
+
+
+        private:
+      /// type managing cell indices
+      using Indexer_t = details::GridIndexer_t<Dims>; // same in SpacePartition
+
+      /// type of cell index
+      using CellIndex_t = typename Indexer_t::CellIndex_t;
+
+      /// type of list of non-empty cells in a neighbourhood
+      using NeighborCells_t = std::vector<CellIndex_t>;
+
+      template <typename PointIter, typename Alloc = std::allocator<PointIter>>
+      using Partition_t = SpacePartition<PointIter, Alloc, Dims>;
+
+      /// type of the ranges of the partition on all the dimensions
+      using CellRanges_t = std::array<CoordRangeCells<Coord_t>, Dims>;
+
+
+      Configuration_t config; ///< all configuration data
+
+
+      /// Computes the cell size to be used
+      template <typename PointIter>
+      Coord_t computeCellSize() const;
+
+      /// Returns the ranges of the partition with the specified cell size
+      CellRanges_t cellRanges(Coord_t cellSize) const;
+
+      /// Returns the ranges of the partition with the specified cell size
+      template <std::size_t... Dim>
+      CellRanges_t cellRanges
+        (Coord_t cellSize, std::index_sequence<Dim...>) const;
+
+      /// Fills `neighbors` with the non-empty cells around `cellIndex`
+      template <typename PointIter, typename Alloc>
+      static void collectNeighbors(
+        Partition_t<PointIter, Alloc> const& partition,
+        CellIndex_t cellIndex, unsigned int extent,
+        NeighborCells_t& neighbors
+        );
+
+      /// Returns the number of neighbours of `point` in `neighbors` cells,
+      /// stopping counting at the minimum number of points
+      template <typename PointIter, typename Alloc>
+      unsigned int countNeighbors(
+        Partition_t<PointIter, Alloc> const& partition,
+        decltype(*PointIter()) point,
+        NeighborCells_t const& neighbors
+        ) const;
+
+      /// Returns the index of the closest core point to `point` within the
+      /// radius (ties: lowest index), or the number of points if none
+      template <typename PointIter, typename Alloc>
+      size_t closestCorePoint(
+        Partition_t<PointIter, Alloc> const& partition,
+        PointIter begin, PointIter point,
+        NeighborCells_t const& neighbors,
+        std::vector<char> const& core
+        ) const;
+
+      /// Assigns the labels of all the points, given their core flags and the
+      /// union-find structure of the core points (`findRoot()`)
+      static std::vector<ClusterLabel_t> assignCoreLabels
+        (std::vector<char> const& core, std::vector<size_t>& parents);
+
+      /// Returns the root of the set of `i`, compressing the path to it
+      static size_t findRoot(std::vector<size_t>& parents, size_t i);
+
+      /// Joins the sets of `i` and `j`; the root is the lowest index
+      static void joinSets(std::vector<size_t>& parents, size_t i, size_t j);
+
+      /// Returns whether A and B are within the radius from each other
+      template <typename Point>
+      bool closeEnough(Point const& A, Point const& B) const
+        {
+          return distance2(A, B, std::make_index_sequence<Dims>())
+            <= config.epsilon2;
+        }
+
+      /// Returns the square of the distance between A and B
+      template <typename Point, std::size_t... Dim>
+      static auto distance2
+        (Point const& A, Point const& B, std::index_sequence<Dim...>);
+
+    }; // class PointClusteringAlg
+
+
+    //--------------------------------------------------------------------------
+    /// @}
+    // END RemoveIsolatedSpacePoints group -------------------------------------
+
+  } // namespace example
+} // namespace lar
+
+
+
+//------------------------------------------------------------------------------
+//--- template implementation
+//------------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+auto lar::example::PointClusteringAlg<Coord, Dims>::clusterPoints
+  (PointIter begin, PointIter end) const -> std::vector<ClusterLabel_t>
+{
+  Coord_t const cellSize = computeCellSize<PointIter>();
+  assert(cellSize > 0);
+  Partition_t<PointIter> partition(cellRanges(cellSize));
+  partition.fill(begin, end);
+
+  return clusterPoints(partition, begin, end);
+} // lar::example::PointClusteringAlg::clusterPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+auto lar::example::PointClusteringAlg<Coord, Dims>::clusterPoints(
+  SpacePartition<PointIter, Alloc, Dims> const& partition,
+  PointIter begin, PointIter end
+) const -> std::vector<ClusterLabel_t>
+{
+  size_t const nPoints = std::distance(begin, end);
+  if ((nPoints == 0) || (partition.indexManager().size() == 0))
+    return std::vector<ClusterLabel_t>(nPoints, NoiseLabel);
+
+  //
+  // the smallest side of the cells decides how many cells the neighbourhood
+  // needs to span, the diagonal whether all the points of a cell are
+  // neighbours of each other
+  //
+  Coord_t minCellSize = partition.ranges()[0].cellSize;
+  Coord_t cellDiagonal2 = Coord_t(0);
+  for (auto const& range: partition.ranges()) {
+    minCellSize = std::min(minCellSize, range.cellSize);
+    cellDiagonal2 += cet::square(range.cellSize);
+  } // for
+  assert(minCellSize > 0);
+  bool const cellContained = (cellDiagonal2 <= config.epsilon2);
+  unsigned int const extent
+    = (unsigned int) std::ceil(std::sqrt(config.epsilon2) / minCellSize);
+
+  auto const indexOf
+    = [begin](PointIter it){ return size_t(std::distance(begin, it)); };
+
+  std::vector<CellIndex_t> occupiedCells;
+  partition.forEachOccupied(0, partition.indexManager().size() - 1,
+    [&occupiedCells](CellIndex_t index){ occupiedCells.push_back(index); }
+    );
+
+  NeighborCells_t neighbors;
+
+  //
+  // 1. core points
+  //
+  std::vector<char> core(nPoints, 0);
+  for (CellIndex_t cellIndex: occupiedCells) {
+    auto const& cell = partition[cellIndex];
+
+    // all the points in a crowded cell have enough neighbours in it
+    if (cellContained && (cell.size() >= config.minPoints)) {
+      for (PointIter it: cell) core[indexOf(it)] = 1;
+      continue;
+    }
+
+    collectNeighbors(partition, cellIndex, extent, neighbors);
+    for (PointIter it: cell) {
+      if (countNeighbors(partition, *it, neighbors) >= config.minPoints)
+        core[indexOf(it)] = 1;
+    } // for points in cell
+  } // for cells
+
+  //
+  // 2. clusters of core points
+  //
+  std::vector<size_t> parents(nPoints);
+  std::iota(parents.begin(), parents.end(), size_t(0));
+
+  std::vector<PointIter> cellCore, neighCore;
+  for (CellIndex_t cellIndex: occupiedCells) {
+    cellCore.clear();
+    for (PointIter it: partition[cellIndex])
+      if (core[indexOf(it)]) cellCore.push_back(it);
+    if (cellCore.empty()) continue;
+
+    if (cellContained) {
+      size_t const first = indexOf(cellCore.front());
+      for (PointIter it: cellCore) joinSets(parents, first, indexOf(it));
+    }
+
+    // each pair of cells is compared only once, from the lower index
+    collectNeighbors(partition, cellIndex, extent, neighbors);
+    for (CellIndex_t neighIndex: neighbors) {
+      if (neighIndex < cellIndex) continue;
+      if ((neighIndex == cellIndex) && cellContained) continue;
+
+      neighCore.clear();
+      for (PointIter it: partition[neighIndex])
+        if (core[indexOf(it)]) neighCore.push_back(it);
+
+      for (PointIter it: cellCore) {
+        size_t const i = indexOf(it);
+        for (PointIter other: neighCore) {
+          size_t const j = indexOf(other);
+          if (findRoot(parents, i) == findRoot(parents, j)) continue;
+          if (closeEnough(*it, *other)) joinSets(parents, i, j);
+        } // for core points in neighbour cell
+      } // for core points in cell
+    } // for neighbour cells
+  } // for cells
+
+  std::vector<ClusterLabel_t> labels = assignCoreLabels(core, parents);
+
+  //
+  // 3. border points
+  //
+  for (CellIndex_t cellIndex: occupiedCells) {
+    auto const& cell = partition[cellIndex];
+    bool hasBorder = false;
+    for (PointIter it: cell) {
+      if (!core[indexOf(it)]) {
+        hasBorder = true;
+        break;
+      }
+    } // for
+    if (!hasBorder) continue;
+
+    collectNeighbors(partition, cellIndex, extent, neighbors);
+    for (PointIter it: cell) {
+      size_t const i = indexOf(it);
+      if (core[i]) continue;
+      size_t const closest
+        = closestCorePoint(partition, begin, it, neighbors, core);
+      if (closest < nPoints) labels[i] = labels[closest];
+    } // for points in cell
+  } // for cells
+
+  return labels;
+} // lar::example::PointClusteringAlg::clusterPoints(SpacePartition)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+auto lar::example::PointClusteringAlg<Coord, Dims>::bruteClusterPoints
+  (PointIter begin, PointIter end) const -> std::vector<ClusterLabel_t>
+{
+  size_t const nPoints = std::distance(begin, end);
+
+  // core points
+  std::vector<char> core(nPoints, 0);
+  for (size_t i = 0; i < nPoints; ++i) {
+    unsigned int nNeighbors = 0;
+    for (size_t j = 0; j < nPoints; ++j)
+      if (closeEnough(begin[i], begin[j])) ++nNeighbors;
+    core[i] = (nNeighbors >= config.minPoints);
+  } // for
+
+  // clusters of core points
+  std::vector<size_t> parents(nPoints);
+  std::iota(parents.begin(), parents.end(), size_t(0));
+  for (size_t i = 0; i < nPoints; ++i) {
+    if (!core[i]) continue;
+    for (size_t j = i + 1; j < nPoints; ++j) {
+      if (core[j] && closeEnough(begin[i], begin[j]))
+        joinSets(parents, i, j);
+    } // for
+  } // for
+
+  std::vector<ClusterLabel_t> labels = assignCoreLabels(core, parents);
+
+  // border points
+  for (size_t i = 0; i < nPoints; ++i) {
+    if (core[i]) continue;
+    size_t closest = nPoints;
+    auto closestDist2 = config.epsilon2;
+    for (size_t j = 0; j < nPoints; ++j) {
+      if (!core[j]) continue;
+      auto const d2
+        = distance2(begin[i], begin[j], std::make_index_sequence<Dims>());
+      if ((d2 < closestDist2) || ((d2 == closestDist2) && (j < closest))) {
+        closest = j;
+        closestDist2 = d2;
+      }
+    } // for
+    if (closest < nPoints) labels[i] = labels[closest];
+  } // for
+
+  return labels;
+} // lar::example::PointClusteringAlg::bruteClusterPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+size_t lar::example::PointClusteringAlg<Coord, Dims>::countClusters
+  (std::vector<ClusterLabel_t> const& labels)
+{
+  // clusters are numbered consecutively from 0
+  ClusterLabel_t maxLabel = NoiseLabel;
+  for (ClusterLabel_t label: labels) maxLabel = std::max(maxLabel, label);
+  return size_t(maxLabel + 1);
+} // lar::example::PointClusteringAlg::countClusters()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+void lar::example::PointClusteringAlg<Coord, Dims>::validateConfiguration
+  (Configuration_t const& config)
+{
+  std::vector<std::string> errors;
+  if (config.epsilon2 <= Coord_t(0)) {
+    errors.push_back
+      ("invalid radius squared (" + std::to_string(config.epsilon2) + ")");
+  }
+  if (config.minPoints == 0) {
+    errors.push_back("invalid minimum number of points (0)");
+  }
+  auto const ranges = config.ranges();
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    if (ranges[i].valid()) continue;
+    errors.push_back(std::string("invalid ") + "xyz"[i] + " range ("
+      + std::to_string(ranges[i].lower) + " to "
+      + std::to_string(ranges[i].upper) + ")"
+      );
+  } // for
+
+  if (errors.empty()) return;
+
+  // compose the full error message as concatenation:
+  std::string message
+    (std::to_string(errors.size()) + " configuration errors found:");
+
+  for (auto const& error: errors) message += "\n * " + error;
+  throw std::runtime_error(message);
+
+} // lar::example::PointClusteringAlg::validateConfiguration()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+Coord lar::example::PointClusteringAlg<Coord, Dims>::computeCellSize() const {
+
+  // all the points in a cell are neighbours if the diagonal is within epsilon
+  Coord_t cellSize = maximumOptimalCellSize(std::sqrt(config.epsilon2));
+
+  if (config.maxMemory > 0) do {
+    std::array<size_t, Dims> const partition
+      = details::diceVolume(cellRanges(cellSize));
+
+    size_t nCells = 1;
+    for (size_t n: partition) nCells *= n;
+    if (nCells <= 1) break; // we can't reduce it any further
+
+    // is memory low enough?
+    size_t const memory
+      = nCells * sizeof(typename Partition_t<PointIter>::Cell_t);
+    if (memory < config.maxMemory) break;
+
+    cellSize *= 2;
+  } while (true);
+
+  return cellSize;
+} // lar::example::PointClusteringAlg<Coord, Dims>::computeCellSize()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+auto lar::example::PointClusteringAlg<Coord, Dims>::cellRanges
+  (Coord_t cellSize) const -> CellRanges_t
+  { return cellRanges(cellSize, std::make_index_sequence<Dims>()); }
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <std::size_t... Dim>
+auto lar::example::PointClusteringAlg<Coord, Dims>::cellRanges
+  (Coord_t cellSize, std::index_sequence<Dim...>) const -> CellRanges_t
+{
+  auto const ranges = config.ranges();
+  return {{ CoordRangeCells<Coord_t>{ ranges[Dim], cellSize }... }};
+} // lar::example::PointClusteringAlg<Coord, Dims>::cellRanges()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+void lar::example::PointClusteringAlg<Coord, Dims>::collectNeighbors(
+  Partition_t<PointIter, Alloc> const& partition,
+  CellIndex_t cellIndex, unsigned int extent,
+  NeighborCells_t& neighbors
+) {
+  neighbors.clear();
+  partition.forEachOccupiedNeighbor(
+    partition.pointCellID(*(partition[cellIndex].front())), extent,
+    [&neighbors](CellIndex_t index){ neighbors.push_back(index); }
+    );
+} // lar::example::PointClusteringAlg<Coord, Dims>::collectNeighbors()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+unsigned int lar::example::PointClusteringAlg<Coord, Dims>::countNeighbors(
+  Partition_t<PointIter, Alloc> const& partition,
+  decltype(*PointIter()) point,
+  NeighborCells_t const& neighbors
+) const {
+  unsigned int nNeighbors = 0;
+  for (CellIndex_t neighIndex: neighbors) {
+    for (PointIter other: partition[neighIndex]) {
+      if (!closeEnough(point, *other)) continue;
+      if (++nNeighbors >= config.minPoints) return nNeighbors;
+    } // for points in neighbour cell
+  } // for neighbour cells
+  return nNeighbors;
+} // lar::example::PointClusteringAlg<Coord, Dims>::countNeighbors()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+size_t lar::example::PointClusteringAlg<Coord, Dims>::closestCorePoint(
+  Partition_t<PointIter, Alloc> const& partition,
+  PointIter begin, PointIter point,
+  NeighborCells_t const& neighbors,
+  std::vector<char> const& core
+) const {
+  size_t closest = core.size();
+  auto closestDist2 = config.epsilon2;
+  for (CellIndex_t neighIndex: neighbors) {
+    for (PointIter other: partition[neighIndex]) {
+      size_t const j = std::distance(begin, other);
+      if (!core[j]) continue;
+      auto const d2
+        = distance2(*point, *other, std::make_index_sequence<Dims>());
+      if ((d2 < closestDist2) || ((d2 == closestDist2) && (j < closest))) {
+        closest = j;
+        closestDist2 = d2;
+      }
+    } // for points in neighbour cell
+  } // for neighbour cells
+  return closest;
+} // lar::example::PointClusteringAlg<Coord, Dims>::closestCorePoint()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+auto lar::example::PointClusteringAlg<Coord, Dims>::assignCoreLabels
+  (std::vector<char> const& core, std::vector<size_t>& parents)
+  -> std::vector<ClusterLabel_t>
+{
+  //
+  // the root of each set is its lowest index, which is visited first:
+  // clusters are numbered in order of their lowest core point index
+  //
+  std::vector<ClusterLabel_t> labels(core.size(), NoiseLabel);
+  ClusterLabel_t nextLabel = 0;
+  for (size_t i = 0; i < core.size(); ++i) {
+    if (!core[i]) continue;
+    size_t const root = findRoot(parents, i);
+    labels[i] = (root == i)? nextLabel++: labels[root];
+  } // for
+  return labels;
+} // lar::example::PointClusteringAlg<Coord, Dims>::assignCoreLabels()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+size_t lar::example::PointClusteringAlg<Coord, Dims>::findRoot
+  (std::vector<size_t>& parents, size_t i)
+{
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]]; // path halving
+    i = parents[i];
+  } // while
+  return i;
+} // lar::example::PointClusteringAlg<Coord, Dims>::findRoot()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+void lar::example::PointClusteringAlg<Coord, Dims>::joinSets
+  (std::vector<size_t>& parents, size_t i, size_t j)
+{
+  size_t const rootI = findRoot(parents, i);
+  size_t const rootJ = findRoot(parents, j);
+  if (rootI < rootJ) parents[rootJ] = rootI;
+  else if (rootJ < rootI) parents[rootI] = rootJ;
+} // lar::example::PointClusteringAlg<Coord, Dims>::joinSets()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Point, std::size_t... Dim>
+auto lar::example::PointClusteringAlg<Coord, Dims>::distance2
+  (Point const& A, Point const& B, std::index_sequence<Dim...>)
+{
+  return (
+    cet::square
+      (details::extractPosition<Dim>(A) - details::extractPosition<Dim>(B))
+    + ...
+    );
+} // lar::example::PointClusteringAlg<Coord, Dims>::distance2()
+
+
+//--------------------------------------------------------------------------
+
+#endif // LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_POINTCLUSTERINGALG_H
@@ -0,0 +1,35 @@
+/**
+ * @file   PointIsolationAlg.cxx
+ * @brief  Precompiled instantiations of the point isolation algorithm
+ * @see    PointIsolationAlg.h
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * The instantiations compiled here are declared `extern` in
+ * `PointIsolationAlg.h`.
+ */
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointIsolationAlg.h"
+
+// C/C++ standard libraries
+#include <vector>
+#include <array>
+
+
+//------------------------------------------------------------------------------
+//--- lar::example::PointIsolationAlg
+//---
+template class lar::example::PointIsolationAlg<float>;
+template class lar::example::PointIsolationAlg<double>;
+
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(, float,
+  std::vector<lar::example::details::FloatPoint3D_t>::const_iterator);
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(, double,
+  std::vector<lar::example::details::DoublePoint3D_t>::const_iterator);
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(, float,
+  lar::example::details::FloatPoint3D_t const*);
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(, double,
+  lar::example::details::DoublePoint3D_t const*);
+
+
+//------------------------------------------------------------------------------
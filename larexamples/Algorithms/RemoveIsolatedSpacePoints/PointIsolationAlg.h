@@ -6,6 +6,8 @@
  * @ingroup RemoveIsolatedSpacePoints
  *
  * This library contains only template classes and it is header only.
+ * The most common instantiations are also precompiled in
+ * `PointIsolationAlg.cxx`: see `LAREXAMPLES_POINTISOLATIONALG_HEADERONLY`.
  *
  */
 
@@ -16,27 +18,67 @@
 #include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePartition.h"
 
 // infrastructure and utilities
-#include "cetlib/pow.h" // cet::sum_squares()
+#include "cetlib/pow.h" // cet::square()
 
 // C/C++ standard libraries
 #include <cassert> // assert()
-#include <cmath> // std::sqrt()
+#include <cstdint> // std::int64_t
+#include <cmath> // std::sqrt(), std::ceil(), std::floor()
+#include <algorithm> // std::min(), std::max(), std::copy(), std::fill(), ...
 #include <vector>
 #include <array>
 #include <string>
+#include <memory> // std::allocator, std::allocator_traits
+#include <utility> // std::index_sequence, std::pair
 #include <iterator> // std::cbegin(), std::cend(), std::distance()
 #include <stdexcept> // std::runtime_error
+#include <thread>
+#include <atomic>
+#include <exception> // std::exception_ptr, std::rethrow_exception()
 
 
 namespace lar {
   namespace example {
 
+    namespace details {
+
+      /// Volume covered by `PointIsolationAlg`, one range per dimension
+      template <typename Range, unsigned int Dims>
+      struct IsolationVolume;
+
+      /// Volume covered by `PointIsolationAlg` in three dimensions
+      template <typename Range>
+      struct IsolationVolume<Range, 3U> {
+        Range rangeX;   ///< range in X of the covered volume
+        Range rangeY;   ///< range in Y of the covered volume
+        Range rangeZ;   ///< range in Z of the covered volume
+
+        /// Returns all the ranges, in order
+        std::array<Range, 3U> ranges() const
+          { return {{ rangeX, rangeY, rangeZ }}; }
+      }; // IsolationVolume<3>
+
+      /// Area covered by `PointIsolationAlg` in two dimensions
+      template <typename Range>
+      struct IsolationVolume<Range, 2U> {
+        Range rangeX;   ///< range in X of the covered area
+        Range rangeY;   ///< range in Y of the covered area
+
+        /// Returns all the ranges, in order
+        std::array<Range, 2U> ranges() const
+          { return {{ rangeX, rangeY }}; }
+      }; // IsolationVolume<2>
+
+    } // namespace details
+
+
     // BEGIN RemoveIsolatedSpacePoints group -----------------------------------
     /// @ingroup RemoveIsolatedSpacePoints
     /// @{
     /**
      * @brief Algorithm to detect isolated space points
      * @tparam Coord type of the coordinate
+     * @tparam Dims number of dimensions of the space (`3` or `2`)
      * @see @ref RemoveIsolatedSpacePoints "RemoveIsolatedSpacePoints example overview"
      *
      * This algorithm returns a selection of the input points which are not
@@ -58,6 +100,11 @@ namespace lar {
      *
      * The algorithm can be run on any collection of points, as long as the
      * point class supports the `PositionExtractor` class.
+     * If the coordinates of the points are stored in one array per dimension,
+     * `BulkPositionExtractor` can be specialised for the point iterator: the
+     * partition is then filled, and the exact isolation test and the brute
+     * force algorithms are run, reading the arrays directly, with the same
+     * results.
      * A typical cycle of use is:
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
      *     // creation and configuration
@@ -99,6 +146,21 @@ namespace lar {
      * Validation of the configuration is optional, and needs to be explicitly
      * called if desired (`validateConfiguration()`).
      *
+     * To work only on some of the points of a collection (e.g. the ones in a
+     * single TPC), the collection can be passed together with the indices of
+     * those points, or with a mask selecting them:
+     * `removeIsolatedPoints(points, indices)`. The returned indices are still
+     * positions in the whole collection, and no point is copied.
+     *
+     * When only the fraction of isolated points is needed (e.g. to recognise
+     * noisy events), `countIsolatedPoints()` tests the points of a sample one
+     * by one, and stops as soon as the caller has enough of them.
+     *
+     *
+     * The algorithm can also work in two dimensions (`Dims` set to `2`), in
+     * which case the configuration has no `rangeZ` and only the `x()` and
+     * `y()` coordinates of the points (from `PositionExtractor`) are used.
+     *
      *
      * Description of the algorithm
      * -----------------------------
@@ -113,17 +175,68 @@ namespace lar {
      * structure, that can become huge. The maximum memory parameter keeps this
      * sane.
      *
+     * The neighbourhood of a cell is explored using the occupancy map of the
+     * partition, one row of cells (along the last dimension) at a time, so
+     * that empty neighbour cells are skipped without being accessed: this is
+     * most useful with sparse data, where most of the cells are empty.
+     * For the same reason, the scan skips the cells in empty super-cells.
+     * The cells whose neighbourhood is entirely within the grid ("interior"
+     * cells, most of them) use precomputed row offsets without any bound
+     * check, while the ones close to the border of the grid use a
+     * neighbourhood clipped to the grid.
+     *
+     * The cells are visited in their linear index order, unless a tile size
+     * is configured (`Configuration_t::tileSize`). In that case, the grid is
+     * visited one cubic block ("tile") of cells at a time, so that the
+     * neighbourhood of the cells in the same tile is still in cache when it is
+     * needed again. A tile should be small enough that the points of the tile
+     * and of its neighbourhood fit in the L2 cache (e.g. 8 cells per side).
+     * The set of non-isolated points does not depend on the order the cells
+     * are visited, but the order of the returned indices does.
+     *
+     * If a quantum is configured (`Configuration_t::quantum`), the partition
+     * also stores a compact, 16-bit integer version of the position of each
+     * point relative to its cell (see `SpacePartition::enableQuantization()`).
+     * The distance between two points is then first estimated with integer
+     * arithmetic from these compact positions, without accessing the original
+     * points. Only when that estimation is too close to the isolation radius
+     * to be conclusive, the distance is computed again from the original
+     * coordinates: the result is still exact.
+     *
+     * If cell boxes are enabled (`Configuration_t::cellBoxes`), the partition
+     * also tracks the smallest box containing the points of each cell (see
+     * `SpacePartition::enableBoundingBoxes()`), and a neighbour cell is not
+     * checked at all if its box is farther than the isolation radius from the
+     * box of the cell being processed. This is most useful when the cells are
+     * large compared to the isolation radius, e.g. when their size has been
+     * increased to fit the maximum memory. The same happens whenever the
+     * partition passed to `removeIsolatedPoints()` has bounding boxes.
+     *
+     * If an approximation is configured (`Configuration_t::approximation`,
+     * @f$ \epsilon @f$), the result is not exact any more: all the points with
+     * another point within the isolation radius @f$ R @f$ are still reported
+     * as non-isolated, while the points with no other point within
+     * @f$ (1 + \epsilon) R @f$ are still not reported, but the points in
+     * between may be reported or not. In exchange, the cells can be larger
+     * (a cell with more than one point is entirely non-isolated if its
+     * diagonal is within @f$ (1 + \epsilon) R @f$), with cell bounding boxes
+     * all the points of a cell are declared non-isolated when another
+     * non-empty cell is entirely within @f$ (1 + \epsilon) R @f$ from it,
+     * and the points of crowded cells are compared in single precision with
+     * their whole neighbourhood at once.
+     * This mode is meant for fast filtering (e.g. at trigger level).
+     * Quantised positions are not used in this mode.
+     *
      * Other refinements are not implemented. When a point is found non-isolated
      * also the point that makes it non-isolated should also be marked so. Cell
-     * radius might be tuned to be smaller. Some of the neighbour cells may be
-     * too far and should not be checked. The grid allocates a vector for each
+     * radius might be tuned to be smaller. The grid allocates a vector for each
      * cell, whether it's empty or not; using a sparse structure might reduce
      * the memory; also if the grid contains pointers to vectors instead of
      * vectors, and the grid is very sparse, there should still be some memory
      * saving.
      *
      */
-    template <typename Coord = double>
+    template <typename Coord = double, unsigned int Dims = 3U>
     class PointIsolationAlg {
 
         public:
@@ -131,14 +244,23 @@ namespace lar {
       using Coord_t = Coord;
       using Range_t = CoordRange<Coord_t>;
 
+      /// Returns the number of dimensions of the space
+      static constexpr unsigned int dims() { return Dims; }
+
       /// Type containing all configuration parameters of the algorithm
-      struct Configuration_t {
-        Range_t rangeX;   ///< range in X of the covered volume
-        Range_t rangeY;   ///< range in Y of the covered volume
-        Range_t rangeZ;   ///< range in Z of the covered volume
+      /// (`rangeX`, `rangeY` and, in 3D, `rangeZ` are inherited)
+      struct Configuration_t: public details::IsolationVolume<Range_t, Dims> {
         Coord_t radius2;  ///< square of isolation radius [cm^2]
         size_t maxMemory = 100 * 1048576;
                           ///< grid smaller than this number of bytes (100 MiB)
+        unsigned int tileSize = 0;
+                          ///< cells per side of traversal blocks (0: linear)
+        Coord_t quantum = Coord_t(0);
+                          ///< precision of compact coordinates (0: not used)
+        bool cellBoxes = false;
+                          ///< track the bounding box of the points of cells
+        Coord_t approximation = Coord_t(0);
+                          ///< relative tolerance on the radius (0: exact)
       }; // Configuration_t
 
 
@@ -165,11 +287,33 @@ namespace lar {
 
       /// Returns a constant reference to the current configuration
       /// @see reconfigure()
-      Configuration_t& configuration() const { return config; }
+      Configuration_t const& configuration() const { return config; }
 
       /// @}
 
 
+      /// Settings of the partition and of its scan, prepared in advance
+      /// @see preparePartitionLayout()
+      class PartitionLayout_t;
+
+      /**
+       * @brief Computes the settings of the partition for the configuration
+       * @tparam PointIter random access iterator to a point type
+       * @return the layout of the partition and of its scan
+       * @see removeIsolatedPoints(PartitionLayout_t const&, PointIter, PointIter) const
+       *
+       * The size of the cells, the dimensions of the grid and the
+       * neighbourhood of a cell depend only on the configuration of the
+       * algorithm (and, through the memory limit, on the iterator type).
+       * They are normally computed on each call of `removeIsolatedPoints()`:
+       * this method computes them once, so that they can be reused for many
+       * calls, e.g. for all the events with the same geometry.
+       * The layout must be prepared again after each `reconfigure()`.
+       */
+      template <typename PointIter>
+      PartitionLayout_t preparePartitionLayout() const;
+
+
       /**
        * @brief Returns the set of points that are not isolated
        * @tparam PointIter random access iterator to a point type
@@ -189,7 +333,68 @@ namespace lar {
        */
       template <typename PointIter>
       std::vector<size_t> removeIsolatedPoints
-        (PointIter begin, PointIter end) const;
+        (PointIter begin, PointIter end) const
+        {
+          return removeIsolatedPoints
+            (begin, end, std::allocator<PointIter>());
+        }
+
+
+      /**
+       * @brief Returns the set of points that are not isolated
+       * @tparam PointIter random access iterator to a point type
+       * @tparam Alloc type of allocator for the internal data structures
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @param alloc allocator for the internal data structures
+       * @return a list of indices of non-isolated points in the input range
+       * @see removeIsolatedPoints(PointIter begin, PointIter end) const
+       *
+       * This method is equivalent to
+       * `removeIsolatedPoints(PointIter, PointIter)`, but all the memory for
+       * the space partition is obtained from a copy of `alloc` (rebound as
+       * needed). The returned collection always uses the standard allocator.
+       *
+       * This is useful with arena allocators (e.g. `ArenaAllocator`), which
+       * can be reset once per event instead of freeing each cell separately.
+       */
+      template <typename PointIter, typename Alloc>
+      std::vector<size_t> removeIsolatedPoints
+        (PointIter begin, PointIter end, Alloc const& alloc) const;
+
+
+      /**
+       * @brief Returns the set of points that are not isolated
+       * @tparam PointIter random access iterator to a point type
+       * @tparam Alloc type of allocator of the partition
+       * @param partition space partition already filled with the points
+       * @param begin iterator to the first point in the partition
+       * @return a list of indices of non-isolated points in the partition
+       * @see removeIsolatedPoints(PointIter begin, PointIter end) const
+       *
+       * This method is equivalent to
+       * `removeIsolatedPoints(PointIter, PointIter)`, but it uses an existing
+       * partition instead of building its own. This allows a single partition
+       * of the points to be shared by many algorithms (or by the same one with
+       * different radii).
+       * The returned indices are equivalent to `std::distance(begin, point)`,
+       * so `begin` must be the start of the range the partition was filled
+       * with.
+       *
+       * The partition can have any cell size and cover any volume including
+       * all the points: the volume in the configuration of this algorithm,
+       * its maximum memory and its quantum are ignored, while the quantised
+       * positions are used if the partition stores them.
+       * The cell size still affects the performance: cells much smaller than
+       * the isolation radius make the neighbourhood large, and cells larger
+       * than `maximumOptimalCellSize()` prevent the shortcut of declaring
+       * non-isolated all the points in a cell with more than one point.
+       */
+      template <typename PointIter, typename Alloc>
+      std::vector<size_t> removeIsolatedPoints(
+        SpacePartition<PointIter, Alloc, Dims> const& partition,
+        PointIter begin
+        ) const;
 
 
       /**
@@ -203,6 +408,234 @@ namespace lar {
         { return removeIsolatedPoints(std::cbegin(points), std::cend(points)); }
 
 
+      /**
+       * @brief Returns the set of points that are not isolated
+       * @tparam PointIter random access iterator to a point type
+       * @param layout settings of the partition, from `preparePartitionLayout()`
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @return a list of indices of non-isolated points in the input range
+       * @throw std::runtime_error if `layout` was never prepared
+       * @see removeIsolatedPoints(PointIter begin, PointIter end) const
+       *
+       * This method is equivalent to
+       * `removeIsolatedPoints(PointIter, PointIter)`, with the same result,
+       * but the settings of the partition are taken from `layout` instead of
+       * being computed again. The layout must have been prepared with the
+       * current configuration.
+       */
+      template <typename PointIter>
+      std::vector<size_t> removeIsolatedPoints(
+        PartitionLayout_t const& layout,
+        PointIter begin, PointIter end
+        ) const;
+
+
+      /**
+       * @brief Returns the points of a subset that are not isolated
+       * @tparam PointIter random access iterator to a point type
+       * @param begin iterator to the first point of the whole collection
+       * @param subset indices of the points to be considered
+       * @return a list of indices of non-isolated points of the subset
+       * @see removeIsolatedPoints(PointIter begin, PointIter end) const
+       *
+       * The isolation is evaluated only among the points of the subset, i.e.
+       * the points `begin + index` for each index in `subset` (each index
+       * should appear only once), and the result is the same as the one of
+       * `removeIsolatedPoints(PointIter, PointIter)` on a collection with a
+       * copy of them. The returned indices, though, are the positions of the
+       * points in the whole collection, like the ones in `subset`.
+       * The points are not copied: the partition refers directly to the
+       * points in the collection.
+       */
+      template <typename PointIter>
+      std::vector<size_t> removeIsolatedPointsInSubset
+        (PointIter begin, std::vector<size_t> const& subset) const;
+
+      /**
+       * @brief Returns the points selected by a mask that are not isolated
+       * @tparam PointIter random access iterator to a point type
+       * @param begin iterator to the first point of the whole collection
+       * @param mask whether each point of the collection is considered
+       * @return a list of indices of non-isolated points of the subset
+       * @see removeIsolatedPointsInSubset(PointIter, std::vector<size_t> const&) const
+       *
+       * The subset is made of the points `begin + i` for which `mask[i]` is
+       * `true`; the returned indices are positions in the whole collection.
+       */
+      template <typename PointIter>
+      std::vector<size_t> removeIsolatedPointsInSubset
+        (PointIter begin, std::vector<bool> const& mask) const;
+
+      /**
+       * @brief Returns the points of a subset that are not isolated
+       * @param points the whole collection of points
+       * @param subset indices of the points to be considered
+       * @return a list of indices of non-isolated points of the subset
+       * @see removeIsolatedPointsInSubset(PointIter, std::vector<size_t> const&) const
+       */
+      template <typename Cont>
+      std::vector<size_t> removeIsolatedPoints
+        (Cont const& points, std::vector<size_t> const& subset) const
+        { return removeIsolatedPointsInSubset(std::cbegin(points), subset); }
+
+      /**
+       * @brief Returns the points selected by a mask that are not isolated
+       * @param points the whole collection of points
+       * @param mask whether each point of the collection is considered
+       * @return a list of indices of non-isolated points of the subset
+       * @throw std::runtime_error the mask and the collection differ in size
+       * @see removeIsolatedPointsInSubset(PointIter, std::vector<bool> const&) const
+       */
+      template <typename Cont>
+      std::vector<size_t> removeIsolatedPoints
+        (Cont const& points, std::vector<bool> const& mask) const;
+
+
+      /// Number of points tested by `countIsolatedPoints()`, and how many of
+      /// them were found isolated
+      struct IsolationCount_t {
+        size_t tested = 0; ///< number of points tested
+        size_t isolated = 0; ///< number of isolated points among the tested
+      }; // IsolationCount_t
+
+      /**
+       * @brief Counts the isolated points in a sample, until told to stop
+       * @tparam PointIter random access iterator to a point type
+       * @tparam IndexIter forward iterator to the indices of the sample
+       * @tparam Stop type of the stopping condition
+       * @param layout settings of the partition, from `preparePartitionLayout()`
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @param first iterator to the index of the first point to be tested
+       * @param last iterator after the index of the last point to be tested
+       * @param stop condition to end the test early
+       * @return how many points were tested, and how many were isolated
+       * @throw std::runtime_error if `layout` was never prepared
+       *
+       * The isolation of the points `begin + index` is tested, for each index
+       * from `first` to `last` and in that order, against all the points in
+       * [ `begin`, `end` [. After each point, `stop(count)` is called with the
+       * current counts (`IsolationCount_t`), and if it returns `true` no
+       * more points are tested.
+       * All the points are partitioned as in `removeIsolatedPoints()`, but
+       * only the neighbourhood of the tested points is explored: this is
+       * useful to estimate the fraction of isolated points from a random
+       * sample, without scanning the whole collection.
+       *
+       * The isolation of each point is decided by comparing its distance
+       * from the other points with the configured radius; quantised positions
+       * are not used. With an approximation configured, the points in a
+       * crowded cell may be declared non-isolated as in
+       * `removeIsolatedPoints()`, but no other tolerance is applied.
+       */
+      template <typename PointIter, typename IndexIter, typename Stop>
+      IsolationCount_t countIsolatedPoints(
+        PartitionLayout_t const& layout,
+        PointIter begin, PointIter end,
+        IndexIter first, IndexIter last,
+        Stop stop
+        ) const;
+
+      /**
+       * @brief Counts the isolated points in a sample, until told to stop
+       * @see countIsolatedPoints(PartitionLayout_t const&, PointIter, PointIter, IndexIter, IndexIter, Stop) const
+       *
+       * The settings of the partition are computed on each call.
+       */
+      template <typename PointIter, typename IndexIter, typename Stop>
+      IsolationCount_t countIsolatedPoints(
+        PointIter begin, PointIter end,
+        IndexIter first, IndexIter last,
+        Stop stop
+        ) const;
+
+
+      /**
+       * @brief Returns the points that are not isolated in many point sets
+       * @tparam PointIter random access iterator to a point type
+       * @param pointSets the ranges (begin and end) of each set of points
+       * @param nThreads number of threads to use (`0`: one per hardware core)
+       * @return for each set, a list of indices of its non-isolated points
+       * @see removeIsolatedPoints(PointIter begin, PointIter end) const
+       *
+       * Each set of points is processed independently as by
+       * `removeIsolatedPoints(PointIter, PointIter)`, with the same result;
+       * the indices are relative to the beginning of the set.
+       *
+       * This is meant for many small sets (e.g. many events with few hundred
+       * points each), where the fixed costs of the single call dominate:
+       * the cell size and the neighbourhood of a cell are computed only once,
+       * and each thread allocates a single partition, which is cleared and
+       * refilled for each of the sets it processes. The sets are assigned to
+       * the threads one at a time, as they become free.
+       *
+       * If a set has points outside the configured volume, the exception
+       * from the first failing thread is rethrown after all threads are done.
+       */
+      template <typename PointIter>
+      std::vector<std::vector<size_t>> removeIsolatedPointsInBatch(
+        std::vector<std::pair<PointIter, PointIter>> const& pointSets,
+        unsigned int nThreads = 0
+        ) const;
+
+
+      /**
+       * @brief Returns the set of points that are not isolated, with radii
+       *        specific to each point
+       * @tparam PointIter random access iterator to a point type
+       * @tparam RadiusOf type of the radius extractor
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @param radiusOf extractor of the isolation radius of a point
+       * @return a list of indices of non-isolated points in the input range
+       * @see removeIsolatedPoints(PointIter begin, PointIter end) const
+       *
+       * This method is equivalent to
+       * `removeIsolatedPoints(PointIter, PointIter)`, but the isolation radius
+       * of each point is `radiusOf(point)` instead of the configured one.
+       * The extractor is a callable object taking a point (`*begin`) and
+       * returning its radius; it is called once per point.
+       * Two points are close to each other if their distance is not larger
+       * than their combined radius, the quadratic mean of their two radii:
+       * @f$ d_{ij}^{2} \leq (r_{i}^{2} + r_{j}^{2}) / 2 @f$.
+       *
+       * If all the radii are the same, the result is the one of the standard
+       * algorithm with that radius, and so is its speed. Otherwise the
+       * partition is sized for the largest radius, and the shortcut of
+       * declaring non-isolated all the points in a crowded cell is applied
+       * only if the cell is small enough for the smallest radius. Quantised
+       * positions and the approximate mode are not used in this case.
+       */
+      template <typename PointIter, typename RadiusOf>
+      std::vector<size_t> removeIsolatedPointsWithRadii
+        (PointIter begin, PointIter end, RadiusOf radiusOf) const;
+
+      /**
+       * @brief Returns the set of points that are not isolated, with radii
+       *        specific to each point
+       * @tparam PointIter random access iterator to a point type
+       * @tparam Alloc type of allocator of the partition
+       * @tparam RadiusOf type of the radius extractor
+       * @param partition space partition already filled with the points
+       * @param begin iterator to the first point in the partition
+       * @param end iterator after the last point in the partition
+       * @param radiusOf extractor of the isolation radius of a point
+       * @return a list of indices of non-isolated points in the partition
+       * @see removeIsolatedPointsWithRadii(PointIter, PointIter, RadiusOf) const
+       *
+       * This is the equivalent of
+       * `removeIsolatedPoints(SpacePartition const&, PointIter) const` with
+       * per-point radii.
+       */
+      template <typename PointIter, typename Alloc, typename RadiusOf>
+      std::vector<size_t> removeIsolatedPointsWithRadii(
+        SpacePartition<PointIter, Alloc, Dims> const& partition,
+        PointIter begin, PointIter end,
+        RadiusOf radiusOf
+        ) const;
+
+
       /**
        * @brief Brute-force reference algorithm
        * @tparam PointIter random access iterator to a point type
@@ -220,6 +653,63 @@ namespace lar {
       std::vector<size_t> bruteRemoveIsolatedPoints
         (PointIter begin, PointIter end) const;
 
+      /**
+       * @brief Brute-force reference algorithm with per-point radii
+       * @see removeIsolatedPointsWithRadii(), bruteRemoveIsolatedPoints()
+       *
+       * The interface is the same as `removeIsolatedPointsWithRadii()`.
+       * Use this only for tests.
+       */
+      template <typename PointIter, typename RadiusOf>
+      std::vector<size_t> bruteRemoveIsolatedPointsWithRadii
+        (PointIter begin, PointIter end, RadiusOf radiusOf) const;
+
+
+      /**
+       * @brief Parallel brute-force reference algorithm
+       * @tparam PointIter random access iterator to a point type
+       * @param begin iterator to the first point to be considered
+       * @param end iterator after the last point to be considered
+       * @param nThreads number of threads to use (`0`: one per hardware core)
+       * @return a list of indices of non-isolated points in the input range
+       * @see bruteRemoveIsolatedPoints
+       *
+       * This algorithm gives exactly the same result as
+       * `bruteRemoveIsolatedPoints()` (including the order of the indices),
+       * still comparing all the pairs of points, but faster.
+       * The coordinates are first copied into one array per dimension; the
+       * points are then processed in blocks of `BruteBlockSize` points,
+       * compared with chunks of up to `BruteChunkSize` points at a time, in
+       * loops that the compiler can vectorise (e.g. with `-O3`). The blocks
+       * are distributed among `nThreads` threads.
+       * A block stops the comparisons as soon as all its points are known to
+       * be non-isolated.
+       *
+       * This is still a @f$ N^{2} @f$ algorithm, meant for tests with large
+       * samples (@f$ 10^{5} @f$ points and more).
+       */
+      template <typename PointIter>
+      std::vector<size_t> parallelBruteRemoveIsolatedPoints
+        (PointIter begin, PointIter end, unsigned int nThreads = 0) const;
+
+      /// Number of points checked together by `parallelBruteRemoveIsolatedPoints()`
+      static constexpr size_t BruteBlockSize = 16;
+
+      /// Number of points each block is compared with at a time
+      /// by `parallelBruteRemoveIsolatedPoints()`
+      static constexpr size_t BruteChunkSize = 1024;
+
+      /// Number of points compared at a time in approximate mode
+      static constexpr size_t ApproximateChunkSize = 64;
+
+      /// Cells with at least this number of points gather their neighbourhood
+      /// in single precision, in approximate mode
+      static constexpr size_t ApproximateGatherMin = 8;
+
+      /// Smallest non-zero approximation allowed (`Configuration_t`):
+      /// tolerances closer to the single precision rounding are not supported
+      static constexpr Coord_t MinApproximation = Coord_t(1e-4);
+
 
       /// @{
       /// @name Configuration
@@ -233,18 +723,82 @@ namespace lar {
 
       /// Returns the maximum optimal cell size when using a isolation radius
       static Coord_t maximumOptimalCellSize(Coord_t radius)
-        { return radius / std::sqrt(3.); }
+        { return radius / std::sqrt(double(Dims)); }
 
 
         private:
       /// type managing cell indices
-      using Indexer_t = ::util::GridContainer3DIndices; // same in GridContainer
-
-      /// type of neighbourhood cell offsets
-      using NeighAddresses_t = std::vector<Indexer_t::CellIndexOffset_t>;
-
-      template <typename PointIter>
-      using Partition_t = SpacePartition<PointIter>;
+      using Indexer_t = details::GridIndexer_t<Dims>; // same in SpacePartition
+
+      /// type of cell identifier
+      using CellID_t = typename Indexer_t::CellID_t;
+
+      /// type of cell index
+      using CellIndex_t = typename Indexer_t::CellIndex_t;
+
+      /// type of difference between cell indices
+      using CellIndexOffset_t = typename Indexer_t::CellIndexOffset_t;
+
+      /// type of cell index on a single dimension
+      using CellDimIndex_t = typename Indexer_t::CellDimIndex_t;
+
+      /// type of neighbourhood cell offsets, expressed in cell ID shifts
+      using NeighCellIDs_t = std::vector<CellID_t>;
+
+      /// A non-empty cell in the neighbourhood of the cell being scanned
+      struct NeighborCell_t {
+        CellIndex_t index; ///< index of the cell in the partition
+        CellID_t shift; ///< position relative to the scanned cell
+      }; // NeighborCell_t
+
+      /// type of list of non-empty cells in a neighbourhood
+      using NeighborCells_t = std::vector<NeighborCell_t>;
+
+      /// type of single precision coordinates of points, one list per dimension
+      using FloatCoords_t = std::array<std::vector<float>, Dims>;
+
+      /// Settings shared by all the cells in a single isolation scan
+      struct ScanContext_t {
+        /// ID shifts of the rows of neighbour cells along the last dimension
+        /// (the shift on the last dimension is always `0`)
+        NeighCellIDs_t rowShifts;
+        /// index offset of the first cell of each row (same order as
+        /// `rowShifts`), valid for interior cells only
+        std::vector<CellIndexOffset_t> rowOffsets;
+        CellDimIndex_t neighExtent; ///< neighbourhood half-size [cells]
+        std::array<size_t, Dims> dims; ///< number of cells on each dimension
+        bool cellContainedInIsolationSphere; ///< cell diagonal within radius
+        /// squared quantised distance surely within the isolation radius
+        std::int64_t quantizedCloseDist2 = -1;
+        /// squared quantised distance surely beyond the isolation radius
+        std::int64_t quantizedFarDist2 = -1;
+        /// squared isolation radius of each point, by index (`nullptr`: the
+        /// configured radius is used for all points)
+        std::vector<Coord_t> const* radii2 = nullptr;
+        /// squared distance beyond which no point is close to another
+        Coord_t neighborDist2 = Coord_t(0);
+        bool approximate = false; ///< whether the approximate mode is used
+        /// whether whole cells may be found within the tolerated radius
+        /// (approximate mode)
+        bool approximateCellDecisions = false;
+        /// size of the cells on each dimension (approximate mode)
+        std::array<Coord_t, Dims> cellSizes;
+        /// squared distance within which points may be non-isolated
+        /// (approximate mode)
+        Coord_t approximateFarDist2 = Coord_t(0);
+        /// squared distance threshold for single point pairs
+        /// (approximate mode)
+        Coord_t approximatePointDist2 = Coord_t(0);
+        /// squared distance threshold for single point pairs, in single
+        /// precision (approximate mode)
+        float approximateDist2 = 0.0f;
+      }; // ScanContext_t
+
+      template <typename PointIter, typename Alloc = std::allocator<PointIter>>
+      using Partition_t = SpacePartition<PointIter, Alloc, Dims>;
+
+      /// type of the ranges of the partition on all the dimensions
+      using CellRanges_t = std::array<CoordRangeCells<Coord_t>, Dims>;
 
       template <typename PointIter>
       using Point_t = decltype(*PointIter());
@@ -253,34 +807,252 @@ namespace lar {
       Configuration_t config; ///< all configuration data
 
 
+      /// Returns the non-isolated points in `partition`, with the isolation
+      /// radii `radii2` (squared, by point index; `nullptr`: configured one)
+      template <typename PointIter, typename Alloc>
+      std::vector<size_t> removeIsolatedPoints(
+        SpacePartition<PointIter, Alloc, Dims> const& partition,
+        PointIter begin,
+        std::vector<Coord_t> const* radii2
+        ) const;
+
+      /// Returns an empty partition with the configured volume and settings
+      template <typename PointIter, typename Alloc>
+      Partition_t<PointIter, Alloc> makePartition
+        (Coord_t cellSize, Alloc const& alloc) const;
+
+      /// Returns the settings for the scan of `partition`, with the radii
+      /// `radii2` (squared, by point index; `nullptr`: configured one)
+      template <typename PointIter, typename Alloc>
+      ScanContext_t makeScanContext(
+        SpacePartition<PointIter, Alloc, Dims> const& partition,
+        std::vector<Coord_t> const* radii2
+        ) const;
+
+      /// Returns the non-isolated points in `partition`, with settings `scan`
+      template <typename PointIter, typename Alloc>
+      std::vector<size_t> scanPartition(
+        SpacePartition<PointIter, Alloc, Dims> const& partition,
+        PointIter begin,
+        ScanContext_t const& scan
+        ) const;
+
+      /// Counts the isolated points among the ones with the indices in
+      /// [ `first`, `last` [ (see `countIsolatedPoints()`)
+      template <
+        typename PointIter, typename Alloc, typename IndexIter, typename Stop
+        >
+      IsolationCount_t countIsolatedPointsInPartition(
+        Partition_t<PointIter, Alloc> const& partition,
+        PointIter begin,
+        ScanContext_t const& scan,
+        IndexIter first, IndexIter last,
+        Stop stop
+        ) const;
+
+      /// Returns the squared radii of all the points, from `radiusOf`
+      template <typename PointIter, typename RadiusOf>
+      static std::vector<Coord_t> extractRadii2
+        (PointIter begin, PointIter end, RadiusOf radiusOf);
+
+      /// Returns a copy of the configuration with the specified radius
+      Configuration_t configurationWithRadius2(Coord_t radius2) const;
+
       /// Computes the cell size to be used
-      template <typename PointIter = std::array<double, 3> const*>
+      template <
+        typename PointIter = std::array<double, 3> const*,
+        typename Alloc = std::allocator<PointIter>
+        >
       Coord_t computeCellSize() const;
 
 
-      /// Returns a list of cell offsets for the neighbourhood of given radius
-      NeighAddresses_t buildNeighborhood
-        (Indexer_t const& indexer, unsigned int neighExtent) const;
+      /// Returns the ID shifts of the rows of cells (along the last dimension)
+      /// in the neighbourhood of given extent
+      NeighCellIDs_t buildNeighborhoodRows(unsigned int neighExtent) const;
+
+      /// Adds to `nonIsolated` the non-isolated points in the specified cell
+      /// (`neighbors` and `floatCoords` are used as workspace)
+      template <typename PointIter, typename Alloc>
+      void collectNonIsolatedPointsInCell(
+        Partition_t<PointIter, Alloc> const& partition,
+        CellID_t const& cellID,
+        ScanContext_t const& scan,
+        PointIter begin,
+        NeighborCells_t& neighbors,
+        FloatCoords_t& floatCoords,
+        std::vector<size_t>& nonIsolated
+        ) const;
 
-      /// Returns whether a point is isolated with respect to all the others
-      template <typename PointIter>
-      bool isPointIsolatedFrom(
-        Point_t<PointIter> const& point,
-        typename Partition_t<PointIter>::Cell_t const& otherPoints
+      /// Fills `neighbors` with the non-empty cells in the neighbourhood of
+      /// `cellID` (including the cell itself only if needed);
+      /// if `Interior`, the whole neighbourhood must be in the grid
+      template <bool Interior, typename PointIter, typename Alloc>
+      void collectOccupiedNeighbors(
+        Partition_t<PointIter, Alloc> const& partition,
+        CellID_t const& cellID,
+        CellIndex_t cellIndex,
+        ScanContext_t const& scan,
+        NeighborCells_t& neighbors
+        ) const;
+
+      /// Adds to `nonIsolated` the non-isolated points in the specified cell,
+      /// with the approximate criterion (`neighbors` must be already filled)
+      template <typename PointIter, typename Alloc>
+      void collectApproximateNonIsolatedPoints(
+        Partition_t<PointIter, Alloc> const& partition,
+        CellID_t const& cellID,
+        CellIndex_t cellIndex,
+        ScanContext_t const& scan,
+        PointIter begin,
+        NeighborCells_t const& neighbors,
+        FloatCoords_t& coords,
+        std::vector<size_t>& nonIsolated
+        ) const;
+
+      /// Returns whether no other point is within the approximate threshold
+      template <typename PointIter, typename Alloc>
+      bool isApproximatelyIsolated(
+        Partition_t<PointIter, Alloc> const& partition,
+        PointIter pointPtr,
+        NeighborCells_t const& neighbors,
+        ScanContext_t const& scan
+        ) const;
+
+      /// Returns whether a point is isolated in the specified neighbourhood,
+      /// each point with its own radius (`scan.radii2`)
+      template <typename PointIter, typename Alloc>
+      bool isPointIsolatedWithRadii(
+        Partition_t<PointIter, Alloc> const& partition,
+        PointIter begin,
+        PointIter pointPtr,
+        NeighborCells_t const& neighbors,
+        ScanContext_t const& scan
+        ) const;
+
+      /// Returns the square of the largest distance between two boxes
+      template <typename Box>
+      static Coord_t maxBoxDistance2(Box const& a, Box const& b);
+
+      /// Returns the square of the largest distance between the points of two
+      /// cells, with the second at `shift` from the first
+      static Coord_t maxCellDistance2
+        (ScanContext_t const& scan, CellID_t const& shift);
+
+      /// Returns whether a point is isolated in the specified neighbourhood,
+      /// using the quantised positions
+      template <typename PointIter, typename Alloc>
+      bool isQuantizedPointIsolatedWithinNeighborhood(
+        Partition_t<PointIter, Alloc> const& partition,
+        CellIndex_t cellIndex,
+        size_t pointIndex,
+        NeighborCells_t const& neighbors,
+        ScanContext_t const& scan
         ) const;
 
+      /// Returns the square of the distance between two boxes (0 if overlap)
+      template <typename Box>
+      static Coord_t boxDistance2(Box const& a, Box const& b);
+
+      /// Returns whether the whole neighbourhood of `cellID` is in the grid
+      static bool isInteriorCell
+        (ScanContext_t const& scan, CellID_t const& cellID);
+
+      /// Returns whether the cell `cellID` shifted by `shift` is in the grid
+      static bool hasCell(
+        std::array<size_t, Dims> const& dims,
+        CellID_t const& cellID, CellID_t const& shift
+        );
+
+      /// Moves `cellID` by `step` to the next cell in the box
+      /// [ `lower`, `upper` [, returns `false` if it was the last one
+      static bool nextCellID(
+        CellID_t& cellID, CellID_t const& lower, CellID_t const& upper,
+        CellDimIndex_t step = 1
+        );
+
+      /// Returns the ranges of a partition with the specified cell size
+      CellRanges_t cellRanges(Coord_t cellSize) const;
+
+      /// Returns the ranges of a partition with the specified cell size
+      template <std::size_t... Dim>
+      CellRanges_t cellRanges
+        (Coord_t cellSize, std::index_sequence<Dim...>) const;
+
+      /// Returns whether a point is isolated with respect to all the others
+      template <typename PointIter, typename Cell>
+      bool isPointIsolatedFrom
+        (Point_t<PointIter> const& point, Cell const& otherPoints) const;
+
       /// Returns whether a point is isolated in the specified neighbourhood
-      template <typename PointIter>
+      template <typename PointIter, typename Alloc>
       bool isPointIsolatedWithinNeighborhood(
-        Partition_t<PointIter> const& partition,
-        Indexer_t::CellIndex_t cellIndex,
+        Partition_t<PointIter, Alloc> const& partition,
         Point_t<PointIter> const& point,
-        NeighAddresses_t const& neighList
+        NeighborCells_t const& neighbors
+        ) const;
+
+      /// Returns whether the point with index `iPoint` is isolated in the
+      /// specified neighbourhood, reading the coordinates from `coords`
+      /// (see `BulkPositionExtractor`)
+      template <typename PointIter, typename Alloc, typename Coords>
+      bool isArrayPointIsolatedWithinNeighborhood(
+        Partition_t<PointIter, Alloc> const& partition,
+        PointIter begin,
+        Coords const& coords,
+        size_t iPoint,
+        NeighborCells_t const& neighbors
         ) const;
 
+      /// Returns the square of the distance between points `i` and `j`, whose
+      /// coordinates are in `coords`
+      template <typename Coords, std::size_t... Dim>
+      static auto arrayDistance2
+        (Coords const& coords, size_t i, size_t j, std::index_sequence<Dim...>);
+
       /// Returns whether A and B are close enough to be considered non-isolated
       template <typename Point>
-      bool closeEnough(Point const& A, Point const& B) const;
+      bool closeEnough(Point const& A, Point const& B) const
+        {
+          return distance2(A, B, std::make_index_sequence<Dims>())
+            <= config.radius2;
+        }
+
+      /// Returns the square of the distance between A and B
+      template <typename Point, std::size_t... Dim>
+      static auto distance2
+        (Point const& A, Point const& B, std::index_sequence<Dim...>);
+
+      /// Returns all the coordinates of the point
+      template <typename Point, std::size_t... Dim>
+      static auto extractCoordinates
+        (Point const& point, std::index_sequence<Dim...>);
+
+      /// Returns all the coordinates of the point relative to `origin`,
+      /// in single precision
+      template <typename Point, std::size_t... Dim>
+      static std::array<float, Dims> extractFloatCoordinates(
+        Point const& point, std::array<Coord_t, Dims> const& origin,
+        std::index_sequence<Dim...>
+        );
+
+      /// Marks in `nonIsolated` the non-isolated points among the ones in
+      /// the blocks `firstBlock`, `firstBlock + blockStep`, etc.
+      template <typename PointCoord>
+      void bruteCheckBlocks(
+        std::array<PointCoord const*, Dims> const& data, size_t nPoints,
+        size_t firstBlock, size_t blockStep,
+        std::vector<char>& nonIsolated
+        ) const;
+
+      /// Returns how many points in [ `chunkStart`, `chunkEnd` [ are within
+      /// the isolation radius from `point` (including `point` itself)
+      template <typename PointCoord, std::size_t... Dim>
+      unsigned int countCloseInChunk(
+        std::array<PointCoord, Dims> const& point,
+        std::array<PointCoord const*, Dims> const& data,
+        size_t chunkStart, size_t chunkEnd,
+        std::index_sequence<Dim...>
+        ) const;
 
 
       /// Helper function. Returns a string `"(<from> to <to>)"`
@@ -293,6 +1065,31 @@ namespace lar {
     }; // class PointIsolationAlg
 
 
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Settings of a partition and of its scan, computed in advance
+     * @see PointIsolationAlg::preparePartitionLayout()
+     *
+     * The content is opaque; a default-constructed layout is not valid, and
+     * needs to be assigned the one from `preparePartitionLayout()`.
+     */
+    template <typename Coord, unsigned int Dims>
+    class PointIsolationAlg<Coord, Dims>::PartitionLayout_t {
+      friend class PointIsolationAlg<Coord, Dims>;
+
+      Coord_t cellSideSize = Coord_t(0); ///< size of the side of the cells
+      ScanContext_t scan; ///< settings for the scan of the partition
+
+        public:
+      /// Returns whether this layout has been prepared
+      bool isValid() const { return cellSideSize > Coord_t(0); }
+
+      /// Returns the size of the side of the cells
+      Coord_t cellSize() const { return cellSideSize; }
+
+    }; // class PointIsolationAlg<>::PartitionLayout_t
+
+
     //--------------------------------------------------------------------------
     /// @}
     // END RemoveIsolatedSpacePoints group -------------------------------------
@@ -305,15 +1102,13 @@ namespace lar {
 //------------------------------------------------------------------------------
 //--- template implementation
 //------------------------------------------------------------------------------
-template <typename Coord>
-template <typename PointIter>
-std::vector<size_t> lar::example::PointIsolationAlg<Coord>::removeIsolatedPoints
-  (PointIter begin, PointIter end) const
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+std::vector<size_t> lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPoints
+  (PointIter begin, PointIter end, Alloc const& alloc) const
 {
-
-  std::vector<size_t> nonIsolated;
-
-  Coord_t const R = std::sqrt(config.radius2);
+  using PointAlloc_t
+    = typename std::allocator_traits<Alloc>::template rebind_alloc<PointIter>;
 
   //
   // determine space partition settings: cell size
@@ -324,102 +1119,989 @@ std::vector<size_t> lar::example::PointIsolationAlg<Coord>::removeIsolatedPoints
   // minimum: needs tuning
   //
 
-  Coord_t cellSize = computeCellSize<PointIter>();
+  Coord_t cellSize = computeCellSize<PointIter, PointAlloc_t>();
   assert(cellSize > 0);
-  Partition_t<PointIter> partition(
-    { config.rangeX, cellSize },
-    { config.rangeY, cellSize },
-    { config.rangeZ, cellSize }
-    );
-
-  // if a cell is contained in a sphere with
-  bool const cellContainedInIsolationSphere
-    = (cellSize <= maximumOptimalCellSize(R));
+  Partition_t<PointIter, PointAlloc_t> partition
+    = makePartition<PointIter>(cellSize, PointAlloc_t(alloc));
 
   //
-  // determine neighbourhood
-  // the neighbourhood is the number of cells that might contain points closer
-  // than R to a cell; it is equal to R in cell size units, rounded up;
-  // it's expressed as a list of coordinate shifts from a base cell to all the
-  // others in the neighbourhood; it is contained in a cube
+  // populate the partition
   //
-  unsigned int const neighExtent = (int) std::ceil(R / cellSize);
-  NeighAddresses_t neighList
-    = buildNeighborhood(partition.indexManager(), neighExtent);
+  partition.fill(begin, end);
+
+  return removeIsolatedPoints(partition, begin);
+} // lar::example::PointIsolationAlg::removeIsolatedPoints()
+
 
-  // if a cell is not fully contained in a isolation radius, we need to check
-  // the points of the cell with each other: their cell becomes part of the
-  // neighbourhood
-  if (!cellContainedInIsolationSphere)
-    neighList.insert(neighList.begin(), { 0, 0, 0 });
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+std::vector<std::vector<size_t>>
+lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPointsInBatch(
+  std::vector<std::pair<PointIter, PointIter>> const& pointSets,
+  unsigned int nThreads /* = 0 */
+) const
+{
+  std::vector<std::vector<size_t>> results(pointSets.size());
+  if (pointSets.empty()) return results;
 
   //
-  // populate the partition
+  // the settings shared by all the sets: cell size and neighbourhood
   //
-  partition.fill(begin, end);
+  Coord_t const cellSize = computeCellSize<PointIter>();
+  assert(cellSize > 0);
+  Partition_t<PointIter> firstPartition
+    = makePartition<PointIter>(cellSize, std::allocator<PointIter>());
+  ScanContext_t const scan = makeScanContext(firstPartition, nullptr);
+
+  if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+  nThreads
+    = std::max(1U, (unsigned int) std::min<size_t>(nThreads, pointSets.size()));
 
   //
-  // for each cell in the partition:
+  // each thread has its own partition, reused for all its sets;
+  // the sets are handed out one at a time
   //
-  size_t const nCells = partition.indexManager().size();
-  for (Indexer_t::CellIndex_t cellIndex = 0; cellIndex < nCells; ++cellIndex) {
-    auto const& cellPoints = partition[cellIndex];
+  std::atomic<size_t> nextSet{ 0 };
+  std::vector<std::exception_ptr> errors(nThreads);
+  auto processSets = [&](Partition_t<PointIter>& partition, unsigned int iThread)
+    {
+      try {
+        for (size_t iSet = nextSet++; iSet < pointSets.size(); iSet = nextSet++)
+        {
+          auto const& pointSet = pointSets[iSet];
+          partition.clear();
+          partition.fill(pointSet.first, pointSet.second);
+          results[iSet] = scanPartition(partition, pointSet.first, scan);
+        } // for
+      }
+      catch (...) {
+        errors[iThread] = std::current_exception();
+        nextSet = pointSets.size(); // stop all the threads
+      }
+    };
 
-    //
-    // if the cell has more than one element, mark all points as non-isolated;
-    // true only if the cell is completely contained within a R rßadius
-    //
-    if (cellContainedInIsolationSphere && (cellPoints.size() > 1)) {
-      for (auto const& pointPtr: cellPoints)
-        nonIsolated.push_back(std::distance(begin, pointPtr));
-      continue;
-    } // if all non-isolated
+  std::vector<std::thread> workers;
+  workers.reserve(nThreads - 1);
+  for (unsigned int iThread = 1; iThread < nThreads; ++iThread) {
+    workers.emplace_back([this, cellSize, iThread, &processSets]
+      {
+        Partition_t<PointIter> partition
+          = makePartition<PointIter>(cellSize, std::allocator<PointIter>());
+        processSets(partition, iThread);
+      });
+  } // for
+  processSets(firstPartition, 0);
+  for (std::thread& worker: workers) worker.join();
 
-    //
-    // brute force approach: try all the points in this cell against all the
-    // points in the neighbourhood
-    //
-    for (auto const pointPtr: cellPoints) {
-      //
-      // optimisation (speed): mark the points from other cells as non-isolated
-      // when they trigger non-isolation in points of the current one
-      //
+  for (std::exception_ptr const& error: errors)
+    if (error) std::rethrow_exception(error);
 
-      // TODO
+  return results;
+} // lar::example::PointIsolationAlg::removeIsolatedPointsInBatch()
 
-      if (!isPointIsolatedWithinNeighborhood
-        (partition, cellIndex, *pointPtr, neighList)
-        )
-      {
-        nonIsolated.push_back(std::distance(begin, pointPtr));
-      }
-    } // for points in cell
 
-  } // for cell
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+auto lar::example::PointIsolationAlg<Coord, Dims>::preparePartitionLayout
+  () const -> PartitionLayout_t
+{
+  PartitionLayout_t layout;
+  layout.cellSideSize = computeCellSize<PointIter>();
+  assert(layout.cellSideSize > 0);
+
+  // the scan settings need a partition with the same settings, but no point
+  Partition_t<PointIter> const partition = makePartition<PointIter>
+    (layout.cellSideSize, std::allocator<PointIter>());
+  layout.scan = makeScanContext(partition, nullptr);
 
-  return nonIsolated;
-} // lar::example::PointIsolationAlg::removeIsolatedPoints()
+  return layout;
+} // lar::example::PointIsolationAlg::preparePartitionLayout()
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
-void lar::example::PointIsolationAlg<Coord>::validateConfiguration
-  (Configuration_t const& config)
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+std::vector<size_t> lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPoints(
+  PartitionLayout_t const& layout,
+  PointIter begin, PointIter end
+) const
+{
+  if (!layout.isValid()) {
+    throw std::runtime_error
+      ("PointIsolationAlg: partition layout used before being prepared");
+  }
+
+  Partition_t<PointIter> partition = makePartition<PointIter>
+    (layout.cellSideSize, std::allocator<PointIter>());
+  partition.fill(begin, end);
+
+  return scanPartition(partition, begin, layout.scan);
+} // lar::example::PointIsolationAlg::removeIsolatedPoints(PartitionLayout_t)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+std::vector<size_t>
+lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPointsInSubset
+  (PointIter begin, std::vector<size_t> const& subset) const
+{
+  Coord_t const cellSize = computeCellSize<PointIter>();
+  assert(cellSize > 0);
+  Partition_t<PointIter> partition
+    = makePartition<PointIter>(cellSize, std::allocator<PointIter>());
+  partition.fillSubset(begin, subset.cbegin(), subset.cend());
+
+  return removeIsolatedPoints(partition, begin);
+} // lar::example::PointIsolationAlg::removeIsolatedPointsInSubset(indices)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+std::vector<size_t>
+lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPointsInSubset
+  (PointIter begin, std::vector<bool> const& mask) const
+{
+  Coord_t const cellSize = computeCellSize<PointIter>();
+  assert(cellSize > 0);
+  Partition_t<PointIter> partition
+    = makePartition<PointIter>(cellSize, std::allocator<PointIter>());
+  partition.fillSubset(begin, mask);
+
+  return removeIsolatedPoints(partition, begin);
+} // lar::example::PointIsolationAlg::removeIsolatedPointsInSubset(mask)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Cont>
+std::vector<size_t> lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPoints
+  (Cont const& points, std::vector<bool> const& mask) const
+{
+  size_t const nPoints = std::distance(std::cbegin(points), std::cend(points));
+  if (mask.size() != nPoints) {
+    throw std::runtime_error(
+      "PointIsolationAlg: mask of " + std::to_string(mask.size())
+      + " entries for a collection of " + std::to_string(nPoints) + " points"
+      );
+  }
+  return removeIsolatedPointsInSubset(std::cbegin(points), mask);
+} // lar::example::PointIsolationAlg::removeIsolatedPoints(mask)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename IndexIter, typename Stop>
+auto lar::example::PointIsolationAlg<Coord, Dims>::countIsolatedPoints(
+  PartitionLayout_t const& layout,
+  PointIter begin, PointIter end,
+  IndexIter first, IndexIter last,
+  Stop stop
+) const -> IsolationCount_t
+{
+  if (!layout.isValid()) {
+    throw std::runtime_error
+      ("PointIsolationAlg: partition layout used before being prepared");
+  }
+
+  Partition_t<PointIter> partition = makePartition<PointIter>
+    (layout.cellSideSize, std::allocator<PointIter>());
+  partition.fill(begin, end);
+
+  return countIsolatedPointsInPartition
+    (partition, begin, layout.scan, first, last, stop);
+} // lar::example::PointIsolationAlg::countIsolatedPoints(PartitionLayout_t)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename IndexIter, typename Stop>
+auto lar::example::PointIsolationAlg<Coord, Dims>::countIsolatedPoints(
+  PointIter begin, PointIter end,
+  IndexIter first, IndexIter last,
+  Stop stop
+) const -> IsolationCount_t
+{
+  Coord_t const cellSize = computeCellSize<PointIter>();
+  assert(cellSize > 0);
+  Partition_t<PointIter> partition
+    = makePartition<PointIter>(cellSize, std::allocator<PointIter>());
+  partition.fill(begin, end);
+
+  return countIsolatedPointsInPartition
+    (partition, begin, makeScanContext(partition, nullptr), first, last, stop);
+} // lar::example::PointIsolationAlg::countIsolatedPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <
+  typename PointIter, typename Alloc, typename IndexIter, typename Stop
+  >
+auto lar::example::PointIsolationAlg<Coord, Dims>::countIsolatedPointsInPartition(
+  Partition_t<PointIter, Alloc> const& partition,
+  PointIter begin,
+  ScanContext_t const& scan,
+  IndexIter first, IndexIter last,
+  Stop stop
+) const -> IsolationCount_t
+{
+  IsolationCount_t count;
+
+  // workspace: list of the non-empty cells in a neighbourhood
+  NeighborCells_t neighbors;
+
+  for (; first != last; ++first) {
+    size_t const iPoint = *first;
+    PointIter const pointPtr = begin + iPoint;
+
+    CellID_t const cellID = partition.pointCellID(*pointPtr);
+    CellIndex_t const cellIndex = partition.indexManager().index(cellID);
+
+    //
+    // a point sharing a cell contained in the isolation sphere is not
+    // isolated; otherwise, it is compared with all the points of the
+    // neighbourhood of its cell
+    //
+    bool isolated = false;
+    if (!scan.cellContainedInIsolationSphere
+      || (partition[cellIndex].size() < 2))
+    {
+      if (isInteriorCell(scan, cellID)) {
+        collectOccupiedNeighbors<true>
+          (partition, cellID, cellIndex, scan, neighbors);
+      }
+      else {
+        collectOccupiedNeighbors<false>
+          (partition, cellID, cellIndex, scan, neighbors);
+      }
+
+      if constexpr (details::hasBulkPositions<PointIter>) {
+        auto const coords
+          = BulkPositionExtractor<PointIter>::coordinates(begin);
+        isolated = isArrayPointIsolatedWithinNeighborhood
+          (partition, begin, coords, iPoint, neighbors);
+      }
+      else {
+        isolated
+          = isPointIsolatedWithinNeighborhood(partition, *pointPtr, neighbors);
+      }
+    } // if not in a crowded cell
+
+    ++count.tested;
+    if (isolated) ++count.isolated;
+    if (stop(count)) break;
+  } // for
+
+  return count;
+} // lar::example::PointIsolationAlg::countIsolatedPointsInPartition()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+auto lar::example::PointIsolationAlg<Coord, Dims>::makePartition
+  (Coord_t cellSize, Alloc const& alloc) const -> Partition_t<PointIter, Alloc>
+{
+  Partition_t<PointIter, Alloc> partition(cellRanges(cellSize), alloc);
+
+  // optionally store also quantised positions
+  if (config.quantum > Coord_t(0))
+    partition.enableQuantization(config.quantum);
+
+  // optionally track the box containing the points of each cell
+  if (config.cellBoxes) partition.enableBoundingBoxes();
+
+  return partition;
+} // lar::example::PointIsolationAlg::makePartition()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+std::vector<size_t> lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPoints(
+  SpacePartition<PointIter, Alloc, Dims> const& partition,
+  PointIter begin
+) const
+{
+  return removeIsolatedPoints(partition, begin, nullptr);
+} // lar::example::PointIsolationAlg::removeIsolatedPoints(SpacePartition)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename RadiusOf>
+std::vector<size_t>
+lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPointsWithRadii
+  (PointIter begin, PointIter end, RadiusOf radiusOf) const
+{
+  std::vector<Coord_t> const radii2 = extractRadii2(begin, end, radiusOf);
+  if (radii2.empty()) return {};
+
+  auto const minmax = std::minmax_element(radii2.cbegin(), radii2.cend());
+
+  //
+  // if all the radii are the same, this is the standard algorithm
+  //
+  Configuration_t uniformConfig = configurationWithRadius2(*(minmax.second));
+  if (*(minmax.first) == *(minmax.second))
+    return PointIsolationAlg(uniformConfig).removeIsolatedPoints(begin, end);
+
+  //
+  // partition sized for the largest radius
+  //
+  using PointAlloc_t = std::allocator<PointIter>;
+  uniformConfig.approximation = Coord_t(0);
+  uniformConfig.quantum = Coord_t(0);
+  Coord_t const cellSize = PointIsolationAlg(uniformConfig)
+    .template computeCellSize<PointIter, PointAlloc_t>();
+  assert(cellSize > 0);
+  Partition_t<PointIter, PointAlloc_t> partition(cellRanges(cellSize));
+  if (config.cellBoxes) partition.enableBoundingBoxes();
+  partition.fill(begin, end);
+
+  return removeIsolatedPoints(partition, begin, &radii2);
+} // lar::example::PointIsolationAlg::removeIsolatedPointsWithRadii()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc, typename RadiusOf>
+std::vector<size_t>
+lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPointsWithRadii(
+  SpacePartition<PointIter, Alloc, Dims> const& partition,
+  PointIter begin, PointIter end,
+  RadiusOf radiusOf
+) const
+{
+  std::vector<Coord_t> const radii2 = extractRadii2(begin, end, radiusOf);
+  if (radii2.empty()) return {};
+
+  auto const minmax = std::minmax_element(radii2.cbegin(), radii2.cend());
+
+  // if all the radii are the same, this is the standard algorithm
+  if (*(minmax.first) == *(minmax.second)) {
+    return PointIsolationAlg(configurationWithRadius2(*(minmax.second)))
+      .removeIsolatedPoints(partition, begin);
+  }
+
+  return removeIsolatedPoints(partition, begin, &radii2);
+} // lar::example::PointIsolationAlg::removeIsolatedPointsWithRadii(SpacePartition)
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename RadiusOf>
+auto lar::example::PointIsolationAlg<Coord, Dims>::extractRadii2
+  (PointIter begin, PointIter end, RadiusOf radiusOf) -> std::vector<Coord_t>
+{
+  std::vector<Coord_t> radii2;
+  radii2.reserve(std::distance(begin, end));
+  for (auto it = begin; it != end; ++it)
+    radii2.push_back(cet::square(Coord_t(radiusOf(*it))));
+  return radii2;
+} // lar::example::PointIsolationAlg<Coord, Dims>::extractRadii2()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+auto lar::example::PointIsolationAlg<Coord, Dims>::configurationWithRadius2
+  (Coord_t radius2) const -> Configuration_t
+{
+  Configuration_t radiusConfig = config;
+  radiusConfig.radius2 = radius2;
+  return radiusConfig;
+} // lar::example::PointIsolationAlg<Coord, Dims>::configurationWithRadius2()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+std::vector<size_t> lar::example::PointIsolationAlg<Coord, Dims>::removeIsolatedPoints(
+  SpacePartition<PointIter, Alloc, Dims> const& partition,
+  PointIter begin,
+  std::vector<Coord_t> const* radii2
+) const
+{
+  return scanPartition(partition, begin, makeScanContext(partition, radii2));
+} // lar::example::PointIsolationAlg::removeIsolatedPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+auto lar::example::PointIsolationAlg<Coord, Dims>::makeScanContext(
+  SpacePartition<PointIter, Alloc, Dims> const& partition,
+  std::vector<Coord_t> const* radii2
+) const -> ScanContext_t
+{
+  //
+  // with per-point radii, the neighbourhood is determined by the largest
+  // radius, and the cells are contained in the smallest one
+  //
+  Coord_t maxRadius2 = config.radius2;
+  Coord_t minRadius2 = config.radius2;
+  if (radii2 && !radii2->empty()) {
+    auto const minmax = std::minmax_element(radii2->cbegin(), radii2->cend());
+    minRadius2 = *(minmax.first);
+    maxRadius2 = *(minmax.second);
+  }
+  Coord_t const R = std::sqrt(maxRadius2);
+  Coord_t const minR = std::sqrt(minRadius2);
+
+  // the partition cells are not necessarily cubic: the largest side decides
+  // whether a cell is contained in the isolation sphere, the smallest one
+  // how many cells the neighbourhood needs to span
+  Coord_t minCellSize = partition.ranges()[0].cellSize;
+  Coord_t maxCellSize = minCellSize;
+  for (auto const& range: partition.ranges()) {
+    minCellSize = std::min(minCellSize, range.cellSize);
+    maxCellSize = std::max(maxCellSize, range.cellSize);
+  } // for
+  assert(minCellSize > 0);
+
+  ScanContext_t scan;
+  scan.dims = partition.dimensions();
+  scan.radii2 = radii2;
+  scan.neighborDist2 = maxRadius2;
+
+  //
+  // in approximate mode, points are allowed to be non-isolated as long as
+  // they have a neighbour within a radius (1+epsilon) R
+  //
+  scan.approximate = !radii2 && (config.approximation > Coord_t(0));
+  Coord_t const farR = scan.approximate? R * (1 + config.approximation): minR;
+  if (scan.approximate) {
+    for (std::size_t i = 0; i < Dims; ++i)
+      scan.cellSizes[i] = partition.ranges()[i].cellSize;
+    scan.approximateFarDist2 = cet::square(farR);
+    // cells are entirely within the tolerated radius from each other only if
+    // they are small (the closest ones are still 2 cells apart), unless their
+    // content is known to be smaller (bounding boxes)
+    CellID_t nearestShift{}; // all 0
+    nearestShift[Dims - 1] = 1;
+    scan.approximateCellDecisions = partition.hasBoundingBoxes()
+      || (maxCellDistance2(scan, nearestShift) <= scan.approximateFarDist2);
+    // single pairs are compared with a threshold halfway between R and farR,
+    // far from both compared to the single precision rounding
+    scan.approximatePointDist2
+      = cet::square(R * (1 + config.approximation / 2));
+    scan.approximateDist2 = float(scan.approximatePointDist2);
+  } // if approximate
+
+  // if a cell is contained in a sphere with
+  scan.cellContainedInIsolationSphere
+    = (maxCellSize <= maximumOptimalCellSize(farR));
+
+  //
+  // determine neighbourhood
+  // the neighbourhood is the number of cells that might contain points closer
+  // than R to a cell; it is equal to R in cell size units, rounded up;
+  // it is contained in a cube, which is described as a list of rows of cells
+  // along the last dimension, where the cell indices are contiguous;
+  // the occupancy of a whole row can then be tested with a few word operations
+  // on the occupancy map of the partition
+  //
+  unsigned int const neighExtent = (int) std::ceil(R / minCellSize);
+  scan.neighExtent = neighExtent;
+  scan.rowShifts = buildNeighborhoodRows(neighExtent);
+
+  // for cells whose neighbourhood is all in the grid ("interior" cells),
+  // rows start at a fixed offset from the cell, and need no bound check
+  scan.rowOffsets.reserve(scan.rowShifts.size());
+  CellID_t const center{}; // all 0
+  for (CellID_t rowStart: scan.rowShifts) {
+    rowStart[Dims - 1] = -scan.neighExtent;
+    scan.rowOffsets.push_back
+      (partition.indexManager().offset(center, rowStart));
+  } // for
+
+  //
+  // quantised distances (if any) are affected by an uncertainty:
+  // each coordinate is off by less than 1.5 quanta (truncation and clamping),
+  // and the distance between two points by less than 3 sqrt(Dims) quanta
+  // (that is less than 6 in 3D)
+  //
+  if (partition.isQuantized() && !radii2) {
+    Coord_t const margin = std::ceil(3 * std::sqrt(Coord_t(Dims)));
+    Coord_t const Rq = R / partition.quantum();
+    scan.quantizedCloseDist2 = (Rq > margin)
+      ? std::int64_t(std::floor(cet::square(Rq - margin))): -1;
+    scan.quantizedFarDist2 = std::int64_t(std::ceil(cet::square(Rq + margin)));
+  } // if quantized
+
+  return scan;
+} // lar::example::PointIsolationAlg::makeScanContext()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+std::vector<size_t> lar::example::PointIsolationAlg<Coord, Dims>::scanPartition(
+  SpacePartition<PointIter, Alloc, Dims> const& partition,
+  PointIter begin,
+  ScanContext_t const& scan
+) const
+{
+  std::vector<size_t> nonIsolated;
+
+  //
+  // for each cell in the partition:
+  //
+  // optimisation (speed): visit the cells one tile at a time, so that the
+  // points in the neighbourhood are reused while still in cache;
+  // without tiling, the whole grid is a single tile
+  //
+  if (partition.indexManager().size() == 0) return nonIsolated;
+
+  CellID_t const gridStart{}; // all 0
+  CellID_t gridEnd;
+  std::copy(scan.dims.begin(), scan.dims.end(), gridEnd.begin());
+
+  // workspace: list of the non-empty cells in a neighbourhood
+  NeighborCells_t neighbors;
+
+  // workspace: coordinates of the points in a neighbourhood (approximate mode)
+  FloatCoords_t floatCoords;
+
+  constexpr std::size_t lastDim = Dims - 1;
+
+  CellDimIndex_t const tileSize = config.tileSize;
+  CellID_t tileStart = gridStart, tileEnd, cellID;
+  do {
+    for (std::size_t i = 0; i < Dims; ++i) {
+      tileEnd[i] = (tileSize == 0)
+        ? gridEnd[i]: std::min(tileStart[i] + tileSize, gridEnd[i]);
+    }
+
+    cellID = tileStart;
+    do {
+      //
+      // optimisation (speed): skip the cells in empty super-cells, up to the
+      // next occupied super-cell on the last dimension (where cells are
+      // visited in sequence); sparse grids are crossed a few words at a time
+      //
+      if (!partition.isSuperCellOccupied(cellID)) {
+        cellID[lastDim]
+          = partition.firstInOccupiedSuperCell(cellID, tileEnd[lastDim]) - 1;
+        continue;
+      }
+
+      collectNonIsolatedPointsInCell
+        (partition, cellID, scan, begin, neighbors, floatCoords, nonIsolated);
+    } while (nextCellID(cellID, tileStart, tileEnd));
+
+  } while ((tileSize > 0) && nextCellID(tileStart, gridStart, gridEnd, tileSize));
+
+  return nonIsolated;
+} // lar::example::PointIsolationAlg::scanPartition()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+void lar::example::PointIsolationAlg<Coord, Dims>::collectNonIsolatedPointsInCell(
+  Partition_t<PointIter, Alloc> const& partition,
+  CellID_t const& cellID,
+  ScanContext_t const& scan,
+  PointIter begin,
+  NeighborCells_t& neighbors,
+  FloatCoords_t& floatCoords,
+  std::vector<size_t>& nonIsolated
+) const
+{
+  CellIndex_t const cellIndex
+    = partition.indexManager().index(cellID);
+
+  // empty cells are skipped without accessing their content
+  if (!partition.isOccupied(cellIndex)) return;
+
+  auto const& cellPoints = partition[cellIndex];
+
+  //
+  // if the cell has more than one element, mark all points as non-isolated;
+  // true only if the cell is completely contained within a R radius
+  //
+  if (scan.cellContainedInIsolationSphere && (cellPoints.size() > 1)) {
+    for (auto const& pointPtr: cellPoints)
+      nonIsolated.push_back(std::distance(begin, pointPtr));
+    return;
+  } // if all non-isolated
+
+  //
+  // brute force approach: try all the points in this cell against all the
+  // points in the neighbourhood;
+  // the list of non-empty neighbour cells is shared by all the points
+  //
+  //
+  // optimisation (speed): most cells are far from the border of the grid,
+  // and their neighbourhood can be explored without any bound check
+  //
+  if (isInteriorCell(scan, cellID)) {
+    collectOccupiedNeighbors<true>
+      (partition, cellID, cellIndex, scan, neighbors);
+  }
+  else {
+    collectOccupiedNeighbors<false>
+      (partition, cellID, cellIndex, scan, neighbors);
+  }
+
+  if (scan.radii2) {
+    for (auto const pointPtr: cellPoints) {
+      if (isPointIsolatedWithRadii(partition, begin, pointPtr, neighbors, scan))
+        continue;
+      nonIsolated.push_back(std::distance(begin, pointPtr));
+    } // for points in cell
+    return;
+  } // if per-point radii
+
+  if (scan.approximate) {
+    collectApproximateNonIsolatedPoints(
+      partition, cellID, cellIndex, scan, begin, neighbors, floatCoords,
+      nonIsolated
+      );
+    return;
+  } // if approximate
+
+  if (partition.isQuantized()) {
+    for (size_t iPoint = 0; iPoint < cellPoints.size(); ++iPoint) {
+      if (!isQuantizedPointIsolatedWithinNeighborhood
+        (partition, cellIndex, iPoint, neighbors, scan)
+        )
+      {
+        nonIsolated.push_back(std::distance(begin, cellPoints[iPoint]));
+      }
+    } // for points in cell
+    return;
+  } // if quantized
+
+  //
+  // optimisation (speed): with the coordinates already in arrays, points are
+  // identified and compared by their index, with no access to the points
+  //
+  if constexpr (details::hasBulkPositions<PointIter>) {
+    auto const coords = BulkPositionExtractor<PointIter>::coordinates(begin);
+    for (auto const pointPtr: cellPoints) {
+      size_t const iPoint = std::distance(begin, pointPtr);
+      if (!isArrayPointIsolatedWithinNeighborhood
+        (partition, begin, coords, iPoint, neighbors)
+        )
+      {
+        nonIsolated.push_back(iPoint);
+      }
+    } // for points in cell
+  } // if coordinate arrays
+  else {
+    for (auto const pointPtr: cellPoints) {
+      //
+      // optimisation (speed): mark the points from other cells as
+      // non-isolated when they trigger non-isolation in points of the current
+      // one
+      //
+
+      // TODO
+
+      if (!isPointIsolatedWithinNeighborhood(partition, *pointPtr, neighbors))
+      {
+        nonIsolated.push_back(std::distance(begin, pointPtr));
+      }
+    } // for points in cell
+  } // if ... else
+
+} // lar::example::PointIsolationAlg::collectNonIsolatedPointsInCell()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+void lar::example::PointIsolationAlg<Coord, Dims>::collectApproximateNonIsolatedPoints(
+  Partition_t<PointIter, Alloc> const& partition,
+  CellID_t const& cellID,
+  CellIndex_t cellIndex,
+  ScanContext_t const& scan,
+  PointIter begin,
+  NeighborCells_t const& neighbors,
+  FloatCoords_t& coords,
+  std::vector<size_t>& nonIsolated
+) const
+{
+  auto const& cellPoints = partition[cellIndex];
+
+  //
+  // decision at cell level: if any other non-empty cell is entirely within
+  // the tolerated radius from this one, all the points here are non-isolated;
+  // the bounding boxes of the cells are used if available, otherwise the
+  // cells themselves (which is not useful unless they are small)
+  //
+  if (scan.approximateCellDecisions) {
+    auto const* cellBox = partition.hasBoundingBoxes()
+      ? &(partition.cellBox(cellIndex)): nullptr;
+    for (NeighborCell_t const& neighbor: neighbors) {
+      if (neighbor.index == cellIndex) continue;
+      Coord_t const d2 = cellBox
+        ? maxBoxDistance2(*cellBox, partition.cellBox(neighbor.index))
+        : maxCellDistance2(scan, neighbor.shift);
+      if (d2 > scan.approximateFarDist2) continue;
+      for (auto const& pointPtr: cellPoints)
+        nonIsolated.push_back(std::distance(begin, pointPtr));
+      return;
+    } // for neighbours
+  } // if cell decisions
+
+  //
+  // decision at point level;
+  // a few points are compared directly with the others, each until one is
+  // close enough
+  //
+  if (cellPoints.size() < ApproximateGatherMin) {
+    for (auto const& pointPtr: cellPoints) {
+      if (isApproximatelyIsolated(partition, pointPtr, neighbors, scan))
+        continue;
+      nonIsolated.push_back(std::distance(begin, pointPtr));
+    } // for points in cell
+    return;
+  } // if few points
+
+  //
+  // with more points, the points of the neighbourhood are gathered only once
+  // for all the points of the cell, and compared a chunk at a time, in single
+  // precision; the coordinates are taken relative to this cell, so that they
+  // stay small and precise enough
+  //
+  std::array<Coord_t, Dims> origin;
+  for (std::size_t i = 0; i < Dims; ++i) {
+    auto const& range = partition.ranges()[i];
+    origin[i] = range.lower + cellID[i] * range.cellSize;
+  }
+
+  size_t nOthers = 0;
+  for (NeighborCell_t const& neighbor: neighbors)
+    nOthers += partition[neighbor.index].size();
+  for (auto& dimCoords: coords) dimCoords.resize(nOthers);
+
+  unsigned int nSelf = 0; // whether each point is also in the list
+  size_t j = 0;
+  for (NeighborCell_t const& neighbor: neighbors) {
+    if (neighbor.index == cellIndex) nSelf = 1;
+    for (auto const& otherPtr: partition[neighbor.index]) {
+      std::array<float, Dims> const other = extractFloatCoordinates
+        (*otherPtr, origin, std::make_index_sequence<Dims>());
+      for (std::size_t i = 0; i < Dims; ++i) coords[i][j] = other[i];
+      ++j;
+    } // for points in neighbour cell
+  } // for neighbours
+
+  std::array<float const*, Dims> data;
+  for (std::size_t i = 0; i < Dims; ++i) data[i] = coords[i].data();
+
+  for (auto const& pointPtr: cellPoints) {
+    std::array<float, Dims> const point = extractFloatCoordinates
+      (*pointPtr, origin, std::make_index_sequence<Dims>());
+
+    unsigned int nClose = 0;
+    for (size_t chunkStart = 0; chunkStart < nOthers;
+      chunkStart += ApproximateChunkSize
+    ) {
+      size_t const chunkEnd
+        = std::min(chunkStart + ApproximateChunkSize, nOthers);
+      // no branches in this loop, so that it can be vectorised
+      for (size_t k = chunkStart; k < chunkEnd; ++k) {
+        float d2 = 0.0f;
+        for (std::size_t i = 0; i < Dims; ++i)
+          d2 += cet::square(point[i] - data[i][k]);
+        nClose += (d2 <= scan.approximateDist2);
+      } // for
+      if (nClose > nSelf) break;
+    } // for chunks
+
+    if (nClose > nSelf) nonIsolated.push_back(std::distance(begin, pointPtr));
+  } // for points in cell
+
+} // lar::example::PointIsolationAlg::collectApproximateNonIsolatedPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+bool lar::example::PointIsolationAlg<Coord, Dims>::isApproximatelyIsolated(
+  Partition_t<PointIter, Alloc> const& partition,
+  PointIter pointPtr,
+  NeighborCells_t const& neighbors,
+  ScanContext_t const& scan
+) const
+{
+  for (NeighborCell_t const& neighbor: neighbors) {
+    for (auto const& otherPtr: partition[neighbor.index]) {
+      if (otherPtr == pointPtr) continue;
+      Coord_t const d2
+        = distance2(*pointPtr, *otherPtr, std::make_index_sequence<Dims>());
+      if (d2 <= scan.approximatePointDist2) return false;
+    } // for points in neighbour cell
+  } // for neighbours
+  return true;
+} // lar::example::PointIsolationAlg<Coord, Dims>::isApproximatelyIsolated()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+bool lar::example::PointIsolationAlg<Coord, Dims>::isPointIsolatedWithRadii(
+  Partition_t<PointIter, Alloc> const& partition,
+  PointIter begin,
+  PointIter pointPtr,
+  NeighborCells_t const& neighbors,
+  ScanContext_t const& scan
+) const
+{
+  std::vector<Coord_t> const& radii2 = *(scan.radii2);
+  Coord_t const pointRadius2 = radii2[std::distance(begin, pointPtr)];
+
+  for (NeighborCell_t const& neighbor: neighbors) {
+    for (auto const& otherPtr: partition[neighbor.index]) {
+      if (otherPtr == pointPtr) continue;
+      // d^2 <= (r1^2 + r2^2) / 2
+      Coord_t const d2
+        = distance2(*pointPtr, *otherPtr, std::make_index_sequence<Dims>());
+      if (2 * d2 <= pointRadius2 + radii2[std::distance(begin, otherPtr)])
+        return false;
+    } // for points in neighbour cell
+  } // for neighbours
+  return true;
+} // lar::example::PointIsolationAlg<Coord, Dims>::isPointIsolatedWithRadii()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Box>
+Coord lar::example::PointIsolationAlg<Coord, Dims>::maxBoxDistance2
+  (Box const& a, Box const& b)
+{
+  Coord_t d2 = Coord_t(0);
+  for (std::size_t i = 0; i < Dims; ++i) {
+    d2 += cet::square
+      (std::max(a[i].upper - b[i].lower, b[i].upper - a[i].lower));
+  } // for
+  return d2;
+} // lar::example::PointIsolationAlg<Coord, Dims>::maxBoxDistance2()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+Coord lar::example::PointIsolationAlg<Coord, Dims>::maxCellDistance2
+  (ScanContext_t const& scan, CellID_t const& shift)
+{
+  // two cells `n` apart on a dimension have points up to `n + 1` cells apart
+  Coord_t d2 = Coord_t(0);
+  for (std::size_t i = 0; i < Dims; ++i) {
+    CellDimIndex_t const n = (shift[i] < 0)? -shift[i]: shift[i];
+    d2 += cet::square((n + 1) * scan.cellSizes[i]);
+  } // for
+  return d2;
+} // lar::example::PointIsolationAlg<Coord, Dims>::maxCellDistance2()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <bool Interior, typename PointIter, typename Alloc>
+void lar::example::PointIsolationAlg<Coord, Dims>::collectOccupiedNeighbors(
+  Partition_t<PointIter, Alloc> const& partition,
+  CellID_t const& cellID,
+  CellIndex_t cellIndex,
+  ScanContext_t const& scan,
+  NeighborCells_t& neighbors
+) const
+{
+  neighbors.clear();
+
+  // bounding box of the points in this cell (if available)
+  auto const* cellBox = partition.hasBoundingBoxes()
+    ? &(partition.cellBox(cellIndex)): nullptr;
+
+  // the range of the rows on the last dimension, clipped to the grid
+  // (interior cells need no clipping)
+  constexpr std::size_t lastDim = Dims - 1;
+  CellDimIndex_t const rowStart = Interior
+    ? cellID[lastDim] - scan.neighExtent
+    : std::max(cellID[lastDim] - scan.neighExtent, CellDimIndex_t(0));
+  CellDimIndex_t const rowEnd = Interior
+    ? cellID[lastDim] + scan.neighExtent + 1
+    : std::min(
+      cellID[lastDim] + scan.neighExtent + 1,
+      (CellDimIndex_t) scan.dims[lastDim]
+      );
+
+  for (std::size_t iRow = 0; iRow < scan.rowShifts.size(); ++iRow) {
+    CellID_t const& rowShift = scan.rowShifts[iRow];
+
+    CellIndex_t first;
+    if constexpr (Interior) {
+      first = cellIndex + scan.rowOffsets[iRow];
+    }
+    else {
+      if (!hasCell(scan.dims, cellID, rowShift)) continue;
+
+      CellID_t firstCellID;
+      for (std::size_t i = 0; i < Dims; ++i)
+        firstCellID[i] = cellID[i] + rowShift[i];
+      firstCellID[lastDim] = rowStart;
+      first = partition.indexManager().index(firstCellID);
+    }
+
+    partition.forEachOccupied(first, first + (rowEnd - rowStart) - 1,
+      [&](CellIndex_t index)
+        {
+          // if a cell is not fully contained in a isolation radius, we need
+          // to check the points of the cell with each other: only then their
+          // cell becomes part of the neighbourhood
+          if ((index == cellIndex) && scan.cellContainedInIsolationSphere)
+            return;
+          // optimisation (speed): if all the points of the two cells are
+          // farther than the isolation radius, the cell is not needed
+          if (cellBox && (index != cellIndex)) {
+            Coord_t const d2
+              = boxDistance2(*cellBox, partition.cellBox(index));
+            if (d2 > scan.neighborDist2) return;
+          }
+          CellID_t shift = rowShift;
+          shift[lastDim] = rowStart + (index - first) - cellID[lastDim];
+          neighbors.push_back({ index, shift });
+        }
+      );
+  } // for rows
+
+} // lar::example::PointIsolationAlg::collectOccupiedNeighbors()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+void lar::example::PointIsolationAlg<Coord, Dims>::validateConfiguration
+  (Configuration_t const& config)
 {
   std::vector<std::string> errors;
   if (config.radius2 < Coord_t(0)) {
     errors.push_back
       ("invalid radius squared (" + std::to_string(config.radius2) + ")");
   }
-  if (!config.rangeX.valid()) {
-    errors.push_back("invalid x range " + rangeString(config.rangeX));
-  }
-  if (!config.rangeY.valid()) {
-    errors.push_back("invalid y range " + rangeString(config.rangeY));
-  }
-  if (!config.rangeZ.valid()) {
-    errors.push_back("invalid z range " + rangeString(config.rangeZ));
+  if ((config.approximation < Coord_t(0))
+    || ((config.approximation > Coord_t(0))
+      && (config.approximation < MinApproximation))
+    )
+  {
+    errors.push_back("invalid approximation ("
+      + std::to_string(config.approximation) + "): must be 0 or at least "
+      + std::to_string(MinApproximation)
+      );
   }
+  auto const ranges = config.ranges();
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    if (ranges[i].valid()) continue;
+    errors.push_back(
+      std::string("invalid ") + "xyz"[i] + " range " + rangeString(ranges[i])
+      );
+  } // for
 
   if (errors.empty()) return;
 
@@ -434,9 +2116,9 @@ void lar::example::PointIsolationAlg<Coord>::validateConfiguration
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
-template <typename PointIter /* = std::array<double, 3> const* */>
-Coord lar::example::PointIsolationAlg<Coord>::computeCellSize() const {
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+Coord lar::example::PointIsolationAlg<Coord, Dims>::computeCellSize() const {
 
   Coord_t const R = std::sqrt(config.radius2);
 
@@ -451,42 +2133,49 @@ Coord lar::example::PointIsolationAlg<Coord>::computeCellSize() const {
 
   // TODO
 
-  if (config.maxMemory == 0) return cellSize;
+  if (config.maxMemory > 0) do {
+    std::array<size_t, Dims> const partition
+      = details::diceVolume(cellRanges(cellSize));
 
-  do {
-    std::array<size_t, 3> partition = details::diceVolume(
-      CoordRangeCells<Coord_t>{ config.rangeX, cellSize },
-      CoordRangeCells<Coord_t>{ config.rangeY, cellSize },
-      CoordRangeCells<Coord_t>{ config.rangeZ, cellSize }
-      );
-
-    size_t const nCells = partition[0] * partition[1] * partition[2];
+    size_t nCells = 1;
+    for (size_t n: partition) nCells *= n;
     if (nCells <= 1) break; // we can't reduce it any further
 
     // is memory low enough?
-    size_t const memory
-      = nCells * sizeof(typename SpacePartition<PointIter>::Cell_t);
+    using ThisPartition_t = Partition_t<PointIter, Alloc>;
+    size_t const cellMemory = sizeof(typename ThisPartition_t::Cell_t)
+      + ((config.quantum > Coord_t(0))
+        ? sizeof(typename ThisPartition_t::QuantizedCell_t): 0
+      )
+      + (config.cellBoxes? sizeof(typename ThisPartition_t::CellBox_t): 0);
+    size_t const memory = nCells * cellMemory;
     if (memory < config.maxMemory) break;
 
     cellSize *= 2;
   } while (true);
 
+  // in approximate mode, cells may be as large as the tolerated radius allows
+  // (but not smaller than the exact mode ones, which might be already larger)
+  if (config.approximation > Coord_t(0)) {
+    cellSize = std::max
+      (cellSize, maximumOptimalCellSize(R * (1 + config.approximation)));
+  }
+
   return cellSize;
-} // lar::example::PointIsolationAlg<Coord>::computeCellSize()
+} // lar::example::PointIsolationAlg<Coord, Dims>::computeCellSize()
 
 
 //------------------------------------------------------------------------------
-template <typename Coord>
-typename lar::example::PointIsolationAlg<Coord>::NeighAddresses_t
-lar::example::PointIsolationAlg<Coord>::buildNeighborhood
-  (Indexer_t const& indexer, unsigned int neighExtent) const
+template <typename Coord, unsigned int Dims>
+typename lar::example::PointIsolationAlg<Coord, Dims>::NeighCellIDs_t
+lar::example::PointIsolationAlg<Coord, Dims>::buildNeighborhoodRows
+  (unsigned int neighExtent) const
 {
   unsigned int const neighSize = 1 + 2 * neighExtent;
-  NeighAddresses_t neighList;
-  neighList.reserve(neighSize * neighSize * neighSize - 1);
-
-  using CellID_t = Indexer_t::CellID_t;
-  using CellDimIndex_t = Indexer_t::CellDimIndex_t;
+  size_t nRows = 1;
+  for (unsigned int i = 0; i < Dims - 1; ++i) nRows *= neighSize;
+  NeighCellIDs_t rowList;
+  rowList.reserve(nRows);
 
   //
   // optimisation (speed): reshape the neighbourhood
@@ -497,32 +2186,27 @@ lar::example::PointIsolationAlg<Coord>::buildNeighborhood
 
   CellDimIndex_t const ext = neighExtent; // convert into the right signedness
 
-  CellID_t center{{ 0, 0, 0 }}, cellID;
-  for (CellDimIndex_t ixOfs = -ext; ixOfs <= ext; ++ixOfs) {
-    cellID[0] = ixOfs;
-    for (CellDimIndex_t iyOfs = -ext; iyOfs <= ext; ++iyOfs) {
-      cellID[1] = iyOfs;
-      for (CellDimIndex_t izOfs = -ext; izOfs <= ext; ++izOfs) {
-        if ((ixOfs == 0) && (iyOfs == 0) && (izOfs == 0)) continue;
-        cellID[2] = izOfs;
-
-        neighList.push_back(indexer.offset(center, cellID));
-
-      } // for ixOfs
-    } // for iyOfs
-  } // for izOfs
+  // visit all the rows in the cube [ -ext, +ext ], including the central one;
+  // the last dimension is the one along the rows, and it stays 0
+  CellID_t lower, upper, cellID;
+  lower.fill(-ext);
+  upper.fill(ext + 1);
+  lower[Dims - 1] = 0;
+  upper[Dims - 1] = 1;
+  cellID = lower;
+  do {
+    rowList.push_back(cellID);
+  } while (nextCellID(cellID, lower, upper));
 
-  return neighList;
-} // lar::example::PointIsolationAlg<Coord>::buildNeighborhood()
+  return rowList;
+} // lar::example::PointIsolationAlg<Coord, Dims>::buildNeighborhoodRows()
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
-template <typename PointIter>
-bool lar::example::PointIsolationAlg<Coord>::isPointIsolatedFrom(
-  Point_t<PointIter> const& point,
-  typename Partition_t<PointIter>::Cell_t const& otherPoints
-) const
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Cell>
+bool lar::example::PointIsolationAlg<Coord, Dims>::isPointIsolatedFrom
+  (Point_t<PointIter> const& point, Cell const& otherPoints) const
 {
 
   for (auto const& otherPointPtr: otherPoints) {
@@ -533,30 +2217,23 @@ bool lar::example::PointIsolationAlg<Coord>::isPointIsolatedFrom(
 
   return true;
 
-} // lar::example::PointIsolationAlg<Coord>::isPointIsolatedFrom()
+} // lar::example::PointIsolationAlg<Coord, Dims>::isPointIsolatedFrom()
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
-template <typename PointIter>
-bool lar::example::PointIsolationAlg<Coord>::isPointIsolatedWithinNeighborhood(
-  Partition_t<PointIter> const& partition,
-  Indexer_t::CellIndex_t cellIndex,
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+bool lar::example::PointIsolationAlg<Coord, Dims>::isPointIsolatedWithinNeighborhood(
+  Partition_t<PointIter, Alloc> const& partition,
   Point_t<PointIter> const& point,
-  NeighAddresses_t const& neighList
+  NeighborCells_t const& neighbors
 ) const
 {
 
-  // check in all cells of the neighbourhood
-  for (Indexer_t::CellIndexOffset_t neighOfs: neighList) {
+  // check in all the non-empty cells of the neighbourhood
+  for (NeighborCell_t const& neighbor: neighbors) {
 
-    //
-    // optimisation (speed): have neighbour offsets so that the invalid ones
-    // are all at the beginning and at the end, so that skipping is faster
-    //
-
-    if (!partition.has(cellIndex + neighOfs)) continue;
-    auto const& neighCellPoints = partition[cellIndex + neighOfs];
+    auto const& neighCellPoints = partition[neighbor.index];
 
     if (!isPointIsolatedFrom<PointIter>(point, neighCellPoints)) return false;
 
@@ -564,14 +2241,172 @@ bool lar::example::PointIsolationAlg<Coord>::isPointIsolatedWithinNeighborhood(
 
   return true;
 
-} // lar::example::PointIsolationAlg<Coord>::isPointIsolatedWithinNeighborhood()
+} // lar::example::PointIsolationAlg<Coord, Dims>::isPointIsolatedWithinNeighborhood()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc, typename Coords>
+bool lar::example::PointIsolationAlg<Coord, Dims>::isArrayPointIsolatedWithinNeighborhood(
+  Partition_t<PointIter, Alloc> const& partition,
+  PointIter begin,
+  Coords const& coords,
+  size_t iPoint,
+  NeighborCells_t const& neighbors
+) const
+{
+
+  for (NeighborCell_t const& neighbor: neighbors) {
+    for (auto const& otherPtr: partition[neighbor.index]) {
+      size_t const iOther = std::distance(begin, otherPtr);
+      if (iOther == iPoint) continue;
+      auto const d2 = arrayDistance2
+        (coords, iPoint, iOther, std::make_index_sequence<Dims>());
+      if (d2 <= config.radius2) return false;
+    } // for points in neighbour cell
+  } // for neigh cell
+
+  return true;
+
+} // lar::example::PointIsolationAlg<Coord, Dims>::isArrayPointIsolatedWithinNeighborhood()
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename Alloc>
+bool
+lar::example::PointIsolationAlg<Coord, Dims>::isQuantizedPointIsolatedWithinNeighborhood
+(
+  Partition_t<PointIter, Alloc> const& partition,
+  CellIndex_t cellIndex,
+  size_t pointIndex,
+  NeighborCells_t const& neighbors,
+  ScanContext_t const& scan
+) const
+{
+  auto const& point = *(partition[cellIndex][pointIndex]);
+  auto const& qPoint = partition.quantizedCell(cellIndex)[pointIndex];
+  std::int64_t const cellQuanta = partition.cellQuanta();
+
+  // check in all the non-empty cells of the neighbourhood
+  for (NeighborCell_t const& neighbor: neighbors) {
+    // the quantised positions are relative to the cells
+    CellID_t const& shift = neighbor.shift;
+    CellIndex_t const neighIndex = neighbor.index;
+    auto const& neighCellPoints = partition[neighIndex];
+    auto const& neighQPoints = partition.quantizedCell(neighIndex);
+
+    // position of the neighbour cell relative to the point, in quanta
+    std::array<std::int64_t, Dims> base;
+    for (std::size_t i = 0; i < Dims; ++i)
+      base[i] = shift[i] * cellQuanta - qPoint[i];
+
+    for (size_t iOther = 0; iOther < neighQPoints.size(); ++iOther) {
+      // make sure that we did not compare the point with itself
+      if ((neighIndex == cellIndex) && (iOther == pointIndex)) continue;
+
+      auto const& qOther = neighQPoints[iOther];
+      std::int64_t d2 = 0;
+      for (std::size_t i = 0; i < Dims; ++i)
+        d2 += cet::square(base[i] + qOther[i]);
+      if (d2 > scan.quantizedFarDist2) continue;
+      if (d2 <= scan.quantizedCloseDist2) return false;
+
+      // too close to the isolation radius to decide: use full precision
+      if (closeEnough(point, *(neighCellPoints[iOther]))) return false;
+    } // for points in neighbour cell
+
+  } // for neigh cell
+
+  return true;
+
+} // lar::example::PointIsolationAlg<Coord, Dims>::isQuantizedPointIsolatedWithinNeighborhood()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Box>
+Coord lar::example::PointIsolationAlg<Coord, Dims>::boxDistance2
+  (Box const& a, Box const& b)
+{
+  Coord_t d2 = Coord_t(0);
+  for (std::size_t i = 0; i < Dims; ++i) {
+    // gap between the boxes on this dimension (negative if they overlap)
+    Coord_t const gap
+      = std::max(a[i].lower - b[i].upper, b[i].lower - a[i].upper);
+    if (gap > Coord_t(0)) d2 += gap * gap;
+  } // for
+  return d2;
+} // lar::example::PointIsolationAlg<Coord, Dims>::boxDistance2()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+bool lar::example::PointIsolationAlg<Coord, Dims>::isInteriorCell
+  (ScanContext_t const& scan, CellID_t const& cellID)
+{
+  for (std::size_t i = 0; i < Dims; ++i) {
+    if (cellID[i] < scan.neighExtent) return false;
+    if (cellID[i] + scan.neighExtent >= (CellDimIndex_t) scan.dims[i])
+      return false;
+  } // for
+  return true;
+} // lar::example::PointIsolationAlg<Coord, Dims>::isInteriorCell()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+bool lar::example::PointIsolationAlg<Coord, Dims>::hasCell(
+  std::array<size_t, Dims> const& dims,
+  CellID_t const& cellID, CellID_t const& shift
+) {
+  for (std::size_t i = 0; i < dims.size(); ++i) {
+    CellDimIndex_t const c = cellID[i] + shift[i];
+    if ((c < 0) || (c >= (CellDimIndex_t) dims[i])) return false;
+  } // for
+  return true;
+} // lar::example::PointIsolationAlg<Coord, Dims>::hasCell()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+bool lar::example::PointIsolationAlg<Coord, Dims>::nextCellID(
+  CellID_t& cellID, CellID_t const& lower, CellID_t const& upper,
+  CellDimIndex_t step /* = 1 */
+) {
+  // the last dimension runs the fastest
+  for (std::size_t i = Dims; i-- > 0;) {
+    cellID[i] += step;
+    if (cellID[i] < upper[i]) return true;
+    cellID[i] = lower[i];
+  } // for
+  return false;
+} // lar::example::PointIsolationAlg<Coord, Dims>::nextCellID()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+auto lar::example::PointIsolationAlg<Coord, Dims>::cellRanges
+  (Coord_t cellSize) const -> CellRanges_t
+  { return cellRanges(cellSize, std::make_index_sequence<Dims>()); }
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <std::size_t... Dim>
+auto lar::example::PointIsolationAlg<Coord, Dims>::cellRanges
+  (Coord_t cellSize, std::index_sequence<Dim...>) const -> CellRanges_t
+{
+  auto const ranges = config.ranges();
+  return {{ CoordRangeCells<Coord_t>{ ranges[Dim], cellSize }... }};
+} // lar::example::PointIsolationAlg<Coord, Dims>::cellRanges()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
 template <typename PointIter>
 std::vector<size_t>
-lar::example::PointIsolationAlg<Coord>::bruteRemoveIsolatedPoints
+lar::example::PointIsolationAlg<Coord, Dims>::bruteRemoveIsolatedPoints
   (PointIter begin, PointIter end) const
 {
   //
@@ -600,26 +2435,311 @@ lar::example::PointIsolationAlg<Coord>::bruteRemoveIsolatedPoints
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
-template <typename Point>
-bool lar::example::PointIsolationAlg<Coord>::closeEnough
-  (Point const& A, Point const& B) const
+template <typename Coord, unsigned int Dims>
+template <typename PointIter, typename RadiusOf>
+std::vector<size_t>
+lar::example::PointIsolationAlg<Coord, Dims>::bruteRemoveIsolatedPointsWithRadii
+  (PointIter begin, PointIter end, RadiusOf radiusOf) const
+{
+  std::vector<Coord_t> const radii2 = extractRadii2(begin, end, radiusOf);
+
+  std::vector<size_t> nonIsolated;
+
+  size_t i = 0;
+  for (auto it = begin; it != end; ++it, ++i) {
+
+    size_t j = 0;
+    for (auto ioth = begin; ioth != end; ++ioth, ++j) {
+      if (it == ioth) continue;
+
+      Coord_t const d2
+        = distance2(*it, *ioth, std::make_index_sequence<Dims>());
+      if (2 * d2 <= radii2[i] + radii2[j]) {
+        nonIsolated.push_back(i);
+        break;
+      }
+
+    } // for oth
+
+  } // for (it)
+
+  return nonIsolated;
+} // lar::example::PointIsolationAlg::bruteRemoveIsolatedPointsWithRadii()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointIter>
+std::vector<size_t>
+lar::example::PointIsolationAlg<Coord, Dims>::parallelBruteRemoveIsolatedPoints
+  (PointIter begin, PointIter end, unsigned int nThreads /* = 0 */) const
+{
+  using PointCoord_t = details::ExtractCoordType_t<decltype(*begin)>;
+
+  //
+  // copy the coordinates into one array per dimension, unless they are
+  // already stored that way
+  //
+  size_t const nPoints = std::distance(begin, end);
+  std::array<std::vector<PointCoord_t>, Dims> coords;
+  std::array<PointCoord_t const*, Dims> data;
+  if constexpr (details::hasBulkPositions<PointIter>) {
+    auto const arrays = BulkPositionExtractor<PointIter>::coordinates(begin);
+    for (std::size_t i = 0; i < Dims; ++i) data[i] = arrays[i];
+  }
+  else {
+    for (auto& coord: coords) coord.reserve(nPoints);
+    for (auto it = begin; it != end; ++it) {
+      auto const point
+        = extractCoordinates(*it, std::make_index_sequence<Dims>());
+      for (std::size_t i = 0; i < Dims; ++i) coords[i].push_back(point[i]);
+    } // for
+    for (std::size_t i = 0; i < Dims; ++i) data[i] = coords[i].data();
+  }
+
+  //
+  // distribute the blocks among the threads;
+  // each point is marked by only one thread, and each flag has its own byte
+  //
+  std::vector<char> nonIsolatedFlags(nPoints, 0);
+  size_t const nBlocks = (nPoints + BruteBlockSize - 1) / BruteBlockSize;
+  if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+  nThreads = std::max(1U, (unsigned int) std::min<size_t>(nThreads, nBlocks));
+
+  std::vector<std::thread> workers;
+  workers.reserve(nThreads - 1);
+  for (unsigned int iThread = 1; iThread < nThreads; ++iThread) {
+    workers.emplace_back
+      ([this, &data, nPoints, &nonIsolatedFlags, iThread, nThreads]
+        {
+          bruteCheckBlocks
+            (data, nPoints, iThread, nThreads, nonIsolatedFlags);
+        }
+      );
+  } // for
+  bruteCheckBlocks(data, nPoints, 0, nThreads, nonIsolatedFlags);
+  for (std::thread& worker: workers) worker.join();
+
+  //
+  // collect the result
+  //
+  std::vector<size_t> nonIsolated;
+  for (size_t i = 0; i < nPoints; ++i)
+    if (nonIsolatedFlags[i]) nonIsolated.push_back(i);
+
+  return nonIsolated;
+} // lar::example::PointIsolationAlg::parallelBruteRemoveIsolatedPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointCoord>
+void lar::example::PointIsolationAlg<Coord, Dims>::bruteCheckBlocks(
+  std::array<PointCoord const*, Dims> const& data, size_t nPoints,
+  size_t firstBlock, size_t blockStep,
+  std::vector<char>& nonIsolated
+) const {
+
+  for (size_t iBlock = firstBlock; iBlock * BruteBlockSize < nPoints;
+    iBlock += blockStep
+  ) {
+    size_t const blockStart = iBlock * BruteBlockSize;
+    size_t const blockEnd = std::min(blockStart + BruteBlockSize, nPoints);
+    size_t nLeft = blockEnd - blockStart; // points not known non-isolated yet
+
+    // optimisation (speed): most points have a neighbour among the first
+    // ones checked; the chunks start small and grow up to `BruteChunkSize`
+    size_t chunkSize = BruteBlockSize;
+    for (size_t chunkStart = 0; chunkStart < nPoints;
+      chunkStart += chunkSize, chunkSize = std::min(2 * chunkSize, BruteChunkSize)
+    ) {
+      size_t const chunkEnd = std::min(chunkStart + chunkSize, nPoints);
+
+      for (size_t i = blockStart; i < blockEnd; ++i) {
+        if (nonIsolated[i]) continue;
+
+        std::array<PointCoord, Dims> point;
+        for (std::size_t d = 0; d < Dims; ++d) point[d] = data[d][i];
+
+        // the point itself is always counted
+        unsigned int nClose = (i >= chunkStart) && (i < chunkEnd)? 0U: 1U;
+        nClose += countCloseInChunk(
+          point, data, chunkStart, chunkEnd, std::make_index_sequence<Dims>()
+          );
+
+        if (nClose > 1) {
+          nonIsolated[i] = 1;
+          --nLeft;
+        }
+      } // for points in block
+
+      if (nLeft == 0) break; // all non-isolated already
+    } // for chunks
+
+  } // for blocks
+
+} // lar::example::PointIsolationAlg<Coord, Dims>::bruteCheckBlocks()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename PointCoord, std::size_t... Dim>
+unsigned int lar::example::PointIsolationAlg<Coord, Dims>::countCloseInChunk(
+  std::array<PointCoord, Dims> const& point,
+  std::array<PointCoord const*, Dims> const& data,
+  size_t chunkStart, size_t chunkEnd,
+  std::index_sequence<Dim...>
+) const {
+  //
+  // this loop has no branches nor dependencies between iterations, so that it
+  // can be vectorised; the squared distance is accumulated in the same order
+  // and with the same type as in `closeEnough()`, so that the result is the
+  // same
+  //
+  unsigned int nClose = 0;
+  for (size_t j = chunkStart; j < chunkEnd; ++j) {
+    PointCoord const d2
+      = (cet::square(point[Dim] - data[Dim][j]) + ...);
+    nClose += (d2 <= config.radius2);
+  } // for
+  return nClose;
+} // lar::example::PointIsolationAlg<Coord, Dims>::countCloseInChunk()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Point, std::size_t... Dim>
+auto lar::example::PointIsolationAlg<Coord, Dims>::extractCoordinates
+  (Point const& point, std::index_sequence<Dim...>)
+{
+  using PointCoord_t = details::ExtractCoordType_t<Point>;
+  return std::array<PointCoord_t, Dims>
+    {{ PointCoord_t(details::extractPosition<Dim>(point))... }};
+} // lar::example::PointIsolationAlg<Coord, Dims>::extractCoordinates()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Point, std::size_t... Dim>
+auto lar::example::PointIsolationAlg<Coord, Dims>::extractFloatCoordinates(
+  Point const& point, std::array<Coord_t, Dims> const& origin,
+  std::index_sequence<Dim...>
+) -> std::array<float, Dims>
+{
+  return {{ float(details::extractPosition<Dim>(point) - origin[Dim])... }};
+} // lar::example::PointIsolationAlg<Coord, Dims>::extractFloatCoordinates()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+template <typename Point, std::size_t... Dim>
+auto lar::example::PointIsolationAlg<Coord, Dims>::distance2
+  (Point const& A, Point const& B, std::index_sequence<Dim...>)
 {
-  return cet::sum_of_squares(
-    details::extractPositionX(A) - details::extractPositionX(B),
-    details::extractPositionY(A) - details::extractPositionY(B),
-    details::extractPositionZ(A) - details::extractPositionZ(B)
-    ) <= config.radius2;
-} // lar::example::PointIsolationAlg<Point>::closeEnough()
+  return (
+    cet::square
+      (details::extractPosition<Dim>(A) - details::extractPosition<Dim>(B))
+    + ...
+    );
+} // lar::example::PointIsolationAlg<Coord, Dims>::distance2()
 
 
 //--------------------------------------------------------------------------
-template <typename Coord>
-std::string lar::example::PointIsolationAlg<Coord>::rangeString
+template <typename Coord, unsigned int Dims>
+template <typename Coords, std::size_t... Dim>
+auto lar::example::PointIsolationAlg<Coord, Dims>::arrayDistance2
+  (Coords const& coords, size_t i, size_t j, std::index_sequence<Dim...>)
+{
+  // same order of the operations as in `distance2()`, for the same result
+  return (cet::square(coords[Dim][i] - coords[Dim][j]) + ...);
+} // lar::example::PointIsolationAlg<Coord, Dims>::arrayDistance2()
+
+
+//--------------------------------------------------------------------------
+template <typename Coord, unsigned int Dims>
+std::string lar::example::PointIsolationAlg<Coord, Dims>::rangeString
   (Coord_t from, Coord_t to)
   { return "(" + std::to_string(from) + " to " + std::to_string(to) + ")"; }
 
 
+//--------------------------------------------------------------------------
+//--- precompiled instantiations
+//---
+/*
+ * The instantiations of the algorithm for the most common point types
+ * (`std::array` of `float` or `double` in a vector or in a C array) are
+ * compiled once in the library of this example (`PointIsolationAlg.cxx`),
+ * and they are declared `extern` here so that the code including this header
+ * does not compile them again. Other point types are compiled inline as usual.
+ *
+ * Code which does not link to the library can define
+ * `LAREXAMPLES_POINTISOLATIONALG_HEADERONLY` before including this header,
+ * and all the instantiations will be compiled inline.
+ *
+ * The same macros are used for the declarations (with `extern`) and for the
+ * definitions (with no `extern`), so that the two lists can't diverge.
+ * The coordinate type of the algorithm must be the one of the points, and
+ * the type of the iterator must be a single macro argument, i.e. it must
+ * contain no comma.
+ */
+
+/// Instantiates the partition of the points from iterators of type `ITER`.
+#define LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE_PARTITION(EXTERN, ITER)    \
+  EXTERN template class lar::example::SpacePartition<ITER>
+
+/// Instantiates `PointIsolationAlg<COORD>` entry points for `ITER` iterators.
+#define LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE_ALG(EXTERN, COORD, ITER)   \
+  EXTERN template std::vector<size_t>                                        \
+  lar::example::PointIsolationAlg<COORD>::removeIsolatedPoints               \
+    (ITER, ITER, std::allocator<ITER> const&) const;                         \
+  EXTERN template std::vector<size_t>                                        \
+  lar::example::PointIsolationAlg<COORD>::removeIsolatedPoints               \
+    (lar::example::SpacePartition<ITER> const&, ITER) const;                 \
+  EXTERN template lar::example::PointIsolationAlg<COORD>::PartitionLayout_t  \
+  lar::example::PointIsolationAlg<COORD>::preparePartitionLayout<ITER>()     \
+    const;                                                                   \
+  EXTERN template std::vector<size_t>                                        \
+  lar::example::PointIsolationAlg<COORD>::removeIsolatedPoints(              \
+    lar::example::PointIsolationAlg<COORD>::PartitionLayout_t const&,        \
+    ITER, ITER                                                               \
+    ) const
+
+/// Instantiates the partition and the algorithm for `ITER` iterators.
+#define LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(EXTERN, COORD, ITER)       \
+  LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE_PARTITION(EXTERN, ITER);         \
+  LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE_ALG(EXTERN, COORD, ITER)
+
+
+namespace lar {
+  namespace example {
+    namespace details {
+
+      /// Point types with precompiled instantiations (names without commas).
+      using FloatPoint3D_t = std::array<float, 3U>;
+      using DoublePoint3D_t = std::array<double, 3U>;
+
+    } // namespace details
+  } // namespace example
+} // namespace lar
+
+
+#ifndef LAREXAMPLES_POINTISOLATIONALG_HEADERONLY
+
+extern template class lar::example::PointIsolationAlg<float>;
+extern template class lar::example::PointIsolationAlg<double>;
+
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(extern, float,
+  std::vector<lar::example::details::FloatPoint3D_t>::const_iterator);
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(extern, double,
+  std::vector<lar::example::details::DoublePoint3D_t>::const_iterator);
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(extern, float,
+  lar::example::details::FloatPoint3D_t const*);
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(extern, double,
+  lar::example::details::DoublePoint3D_t const*);
+
+#endif // !LAREXAMPLES_POINTISOLATIONALG_HEADERONLY
+
+
 //--------------------------------------------------------------------------
 
 #endif // LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_POINTISOLATIONALG_H
@@ -0,0 +1,273 @@
+/**
+ * @file   RemoveIsolatedHits_module.cc
+ * @brief  Module removing isolated hits on each wire plane
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * Provides:
+ *
+ * * `lar::example::RemoveIsolatedHits` module
+ *
+ */
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointIsolationAlg.h"
+#include "lardataobj/RecoBase/Hit.h"
+#include "larcore/Geometry/Geometry.h"
+#include "larcore/CoreUtils/ServiceUtil.h" // lar::providerFrom()
+#include "larcorealg/Geometry/GeometryCore.h"
+#include "larcoreobj/SimpleTypesAndConstants/geo_types.h" // geo::PlaneID
+
+// framework libraries
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h" // art::ValidHandle
+#include "canvas/Utilities/InputTag.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/OptionalAtom.h"
+#include "cetlib/pow.h" // cet::square()
+
+// C/C++ standard libraries
+#include <map>
+#include <vector>
+#include <array>
+#include <algorithm> // std::sort(), std::minmax_element()
+#include <memory> // std::make_unique()
+
+
+namespace lar {
+  namespace example {
+
+    /**
+     * @brief _art_ module: removes isolated hits.
+     * @see @ref RemoveIsolatedSpacePoints "RemoveIsolatedSpacePoints example overview"
+     * @ingroup RemoveIsolatedSpacePoints
+     *
+     * A new collection of hits is added to the event, that contains only the
+     * hits that are not isolated.
+     *
+     * Isolation is determined by the `PointIsolationAlg` algorithm in two
+     * dimensions, separately on each wire plane. The two coordinates of each
+     * hit are its wire number and its peak time, each converted into a length
+     * by its own scale: the wire pitch and the `tickScale` parameter.
+     * Removing isolated hits on each plane is cheaper than removing isolated
+     * space points, since it reduces the number of combinations of hits that
+     * space point reconstruction has to consider.
+     *
+     * The hits are not associated to anything.
+     *
+     * Input
+     * ------
+     *
+     * A collection of `recob::Hit` is required.
+     *
+     *
+     * Output
+     * ------
+     *
+     * A collection of `recob::Hit` is produced, containing copies of the
+     * non-isolated input hits, in the same order as in the input.
+     *
+     *
+     * Configuration parameters
+     * =========================
+     *
+     * * *hits* (input tag, _mandatory_): label of the data product with
+     *   input hits
+     * * *radius* (real, _mandatory_): isolation radius [cm]
+     * * *tickScale* (real, _mandatory_): length corresponding to a TDC tick
+     *   [cm], typically drift velocity times sampling time
+     * * *wirePitch* (real, optional): length corresponding to one wire [cm];
+     *   by default, the pitch of each plane is read from the geometry
+     *
+     */
+    class RemoveIsolatedHits: public art::EDProducer {
+
+        public:
+
+      /// Module configuration data
+      struct Config {
+
+        using Name    = fhicl::Name;
+        using Comment = fhicl::Comment;
+
+        fhicl::Atom<art::InputTag> hits{
+          Name("hits"),
+          Comment("the hits to be filtered")
+          };
+
+        fhicl::Atom<double> radius{
+          Name("radius"),
+          Comment("the radius for the isolation [cm]")
+          };
+
+        fhicl::Atom<double> tickScale{
+          Name("tickScale"),
+          Comment("length of a TDC tick [cm]")
+          };
+
+        fhicl::OptionalAtom<double> wirePitch{
+          Name("wirePitch"),
+          Comment("distance between wires [cm] (default: from geometry)")
+          };
+
+      }; // Config
+
+      /// Standard _art_ alias for module configuration table
+      using Parameters = art::EDProducer::Table<Config>;
+
+      /// Constructor; see the class documentation for the configuration
+      explicit RemoveIsolatedHits(Parameters const& config);
+
+
+      virtual void produce(art::Event& event) override;
+
+
+        private:
+      /// Type of the isolation algorithm, in two dimensions
+      using IsolationAlg_t = PointIsolationAlg<double, 2U>;
+
+      /// Position of a hit on its plane: { wire, time } [cm]
+      using HitPosition_t = std::array<double, 2U>;
+
+      art::InputTag hitsLabel; ///< label of the input data product
+
+      double radius; ///< isolation radius [cm]
+      double tickScale; ///< length of a tick [cm]
+      double wirePitch = 0.0; ///< length of a wire pitch [cm] (0: geometry)
+
+      /// Returns the indices of the non-isolated hits among the specified ones
+      std::vector<size_t> selectNonIsolatedHits(
+        std::vector<recob::Hit> const& hits,
+        std::vector<size_t> const& planeHits,
+        double planeWirePitch
+        ) const;
+
+    }; // class RemoveIsolatedHits
+
+
+  } // namespace example
+} // namespace lar
+
+
+
+//------------------------------------------------------------------------------
+//--- RemoveIsolatedHits
+//---
+lar::example::RemoveIsolatedHits::RemoveIsolatedHits
+  (Parameters const& config)
+  : EDProducer{config}
+  , hitsLabel(config().hits())
+  , radius(config().radius())
+  , tickScale(config().tickScale())
+{
+  config().wirePitch(wirePitch);
+
+  consumes<std::vector<recob::Hit>>(hitsLabel);
+  produces<std::vector<recob::Hit>>();
+} // lar::example::RemoveIsolatedHits::RemoveIsolatedHits()
+
+
+//------------------------------------------------------------------------------
+void lar::example::RemoveIsolatedHits::produce(art::Event& event) {
+
+  //
+  // read the input
+  //
+  auto const& hits
+    = *(event.getValidHandle<std::vector<recob::Hit>>(hitsLabel));
+
+  auto const* geom = lar::providerFrom<geo::Geometry>();
+
+  //
+  // sort the hits by plane
+  //
+  std::map<geo::PlaneID, std::vector<size_t>> hitsByPlane;
+  for (size_t iHit = 0; iHit < hits.size(); ++iHit)
+    hitsByPlane[hits[iHit].WireID().planeID()].push_back(iHit);
+
+  //
+  // run the algorithm on each plane
+  //
+  std::vector<size_t> socialHitIndices;
+  socialHitIndices.reserve(hits.size());
+  for (auto const& planeInfo: hitsByPlane) {
+    double const planeWirePitch
+      = (wirePitch > 0.0)? wirePitch: geom->WirePitch(planeInfo.first);
+
+    std::vector<size_t> const planeSelection
+      = selectNonIsolatedHits(hits, planeInfo.second, planeWirePitch);
+    socialHitIndices.insert
+      (socialHitIndices.end(), planeSelection.begin(), planeSelection.end());
+  } // for planes
+
+  //
+  // extract and save the results (in the original order)
+  //
+  std::sort(socialHitIndices.begin(), socialHitIndices.end());
+
+  auto socialHits = std::make_unique<std::vector<recob::Hit>>();
+  socialHits->reserve(socialHitIndices.size()); // preallocate
+  for (size_t index: socialHitIndices) socialHits->push_back(hits[index]);
+
+  mf::LogInfo("RemoveIsolatedHits")
+    << "Found " << socialHits->size() << "/" << hits.size()
+    << " non-isolated hits on " << hitsByPlane.size() << " planes in '"
+    << hitsLabel.encode() << "'";
+
+  event.put(std::move(socialHits));
+
+} // lar::example::RemoveIsolatedHits::produce()
+
+
+//------------------------------------------------------------------------------
+std::vector<size_t> lar::example::RemoveIsolatedHits::selectNonIsolatedHits(
+  std::vector<recob::Hit> const& hits,
+  std::vector<size_t> const& planeHits,
+  double planeWirePitch
+) const {
+
+  //
+  // convert the hits into positions on the plane
+  //
+  std::vector<HitPosition_t> positions;
+  positions.reserve(planeHits.size());
+  for (size_t iHit: planeHits) {
+    recob::Hit const& hit = hits[iHit];
+    positions.push_back({{
+      hit.WireID().Wire * planeWirePitch, hit.PeakTime() * tickScale
+      }});
+  } // for
+
+  //
+  // the area is the one covered by the hits, with some margin so that the
+  // last hits are not on the border
+  //
+  auto const wireRange = std::minmax_element(positions.begin(), positions.end(),
+    [](HitPosition_t const& a, HitPosition_t const& b){ return a[0] < b[0]; });
+  auto const timeRange = std::minmax_element(positions.begin(), positions.end(),
+    [](HitPosition_t const& a, HitPosition_t const& b){ return a[1] < b[1]; });
+
+  IsolationAlg_t::Configuration_t config;
+  config.rangeX = { (*wireRange.first)[0], (*wireRange.second)[0] + radius };
+  config.rangeY = { (*timeRange.first)[1], (*timeRange.second)[1] + radius };
+  config.radius2 = cet::square(radius);
+
+  IsolationAlg_t const isolAlg(config);
+
+  //
+  // run the algorithm and convert the result back into hit indices
+  //
+  std::vector<size_t> selection = isolAlg.removeIsolatedPoints(positions);
+  for (size_t& index: selection) index = planeHits[index];
+
+  return selection;
+} // lar::example::RemoveIsolatedHits::selectNonIsolatedHits()
+
+
+//------------------------------------------------------------------------------
+DEFINE_ART_MODULE(lar::example::RemoveIsolatedHits)
+
+
+//------------------------------------------------------------------------------
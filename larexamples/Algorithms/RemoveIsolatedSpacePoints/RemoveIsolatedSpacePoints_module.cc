@@ -13,20 +13,32 @@
 
 // LArSoft libraries
 #include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIsolationAlg.h"
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndexService.h"
 #include "lardataobj/RecoBase/SpacePoint.h"
+#include "lardataobj/RecoBase/Hit.h"
 #include "larcore/Geometry/Geometry.h"
 
 // framework libraries
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/SharedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
 #include "art/Framework/Principal/Handle.h" // art::ValidHandle
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Persistency/Common/PtrMaker.h"
+#include "canvas/Persistency/Common/Assns.h"
+#include "canvas/Persistency/Common/Ptr.h"
 #include "canvas/Utilities/InputTag.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/Table.h"
+#include "cetlib_except/exception.h"
 
 // C/C++ standard libraries
+#include <vector>
+#include <string>
+#include <algorithm> // std::sort()
+#include <limits> // std::numeric_limits<>
 #include <memory> // std::make_unique()
 
 
@@ -43,19 +55,49 @@ namespace lar {
      *
      * Isolation is determined by the `SpacePointIsolationAlg` algorithm.
      *
-     * The space points are not associated to anything.
+     * The new space points are not associated to anything, unless the
+     * associations of the input space points with hits are propagated
+     * (`propagateHitAssns`).
+     *
+     * The algorithm is set up with the geometry at the beginning of each run;
+     * the settings derived from the geometry (volume, partition cells and
+     * neighbourhood) are computed again only if the geometry has changed.
+     *
+     * This is a shared module: several events may be processed at the same
+     * time, since the algorithm is not modified while processing an event.
+     * This holds also when `useSharedIndex` is set, since
+     * `SpacePointIndexService` keeps the indices of each event separate.
      *
      * Input
      * ------
      *
      * A collection of `recob::SpacePoint` is required.
+     * If `propagateHitAssns` is set, also their associations with `recob::Hit`
+     * (`art::Assns<recob::SpacePoint, recob::Hit>`), with the same label.
      *
      *
      * Output
      * ------
      *
-     * A collection of `recob::SpacePoint` is produced, containing copies of
-     * the non-isolated inpt points.
+     * The content of the output depends on the `outputMode` parameter:
+     *
+     * * `copy` (default): a collection of `recob::SpacePoint` is produced,
+     *   containing copies of the non-isolated input points;
+     * * `mask`: a `std::vector<bool>` is produced, with one element per input
+     *   space point, `true` if the space point is not isolated;
+     * * `pointers`: a `std::vector<art::Ptr<recob::SpacePoint>>` is produced,
+     *   with a pointer to each of the non-isolated input space points, in
+     *   their original order.
+     *
+     * The last two modes do not copy the space points, and the downstream
+     * modules need to read the input collection too; the data product they
+     * add to the event is much smaller.
+     *
+     * In `copy` mode, if `propagateHitAssns` is set, the associations of the
+     * space points with hits are also produced
+     * (`art::Assns<recob::SpacePoint, recob::Hit>`): each non-isolated space
+     * point in the new collection is associated with the same hits as the
+     * original one, in the order of the input associations.
      *
      *
      * Configuration parameters
@@ -65,9 +107,19 @@ namespace lar {
      *   input space points
      * * *isolation* (parameter set, _mandatory_): configuration for the
      *   isolation algorithm (see `SpacePointIsolationAlg` documentation)
+     * * *useSharedIndex* (boolean, default: `false`): instead of partitioning
+     *   the space points on its own, the algorithm uses the index from
+     *   `SpacePointIndexService`, which is built only once per event for all
+     *   the modules using it (the service must be configured)
+     * * *outputMode* (string, default: `"copy"`): what the output data product
+     *   is made of: `"copy"`, `"mask"` or `"pointers"` (see above)
+     * * *propagateHitAssns* (boolean, default: `false`): associates the new
+     *   space points with the hits of the original ones (only in `copy`
+     *   output mode; in the other modes, the original space points, which
+     *   are still associated with their hits, are used)
      *
      */
-    class RemoveIsolatedSpacePoints: public art::EDProducer {
+    class RemoveIsolatedSpacePoints: public art::SharedProducer {
 
         public:
 
@@ -87,23 +139,83 @@ namespace lar {
           Comment("settings for the isolation algorithm")
           };
 
+        fhicl::Atom<bool> useSharedIndex{
+          Name("useSharedIndex"),
+          Comment("use the space point index from SpacePointIndexService"),
+          false
+          };
+
+        fhicl::Atom<std::string> outputMode{
+          Name("outputMode"),
+          Comment("output: \"copy\" of the points, \"mask\" or \"pointers\""),
+          "copy"
+          };
+
+        fhicl::Atom<bool> propagateHitAssns{
+          Name("propagateHitAssns"),
+          Comment("associate the new space points with the hits of the input"),
+          false
+          };
+
       }; // Config
 
       /// Standard _art_ alias for module configuration table
-      using Parameters = art::EDProducer::Table<Config>;
+      using Parameters = art::SharedProducer::Table<Config>;
 
       /// Constructor; see the class documentation for the configuration
-      explicit RemoveIsolatedSpacePoints(Parameters const& config);
+      explicit RemoveIsolatedSpacePoints
+        (Parameters const& config, art::ProcessingFrame const&);
 
 
-      virtual void produce(art::Event& event) override;
+      virtual void beginRun
+        (art::Run& run, art::ProcessingFrame const&) override;
+
+      virtual void produce
+        (art::Event& event, art::ProcessingFrame const&) override;
 
 
         private:
+      /// Content of the output data product
+      enum class OutputMode_t {
+        Copy, ///< copies of the non-isolated space points
+        Mask, ///< one flag per input space point: whether it's not isolated
+        Pointers ///< pointers to the non-isolated space points
+      }; // OutputMode_t
+
       art::InputTag spacePointsLabel; ///< label of the input data product
 
+      bool useSharedIndex; ///< whether to use the shared index
+
+      OutputMode_t outputMode; ///< content of the output data product
+
+      bool propagateHitAssns; ///< whether to produce space point-hit assns
+
       SpacePointIsolationAlg isolAlg; ///< instance of the algorithm
 
+      /// Returns the output mode matching the specified name
+      /// @throw cet::exception (category: `RemoveIsolatedSpacePoints`) if
+      ///        no mode matches the name
+      static OutputMode_t parseOutputMode(std::string const& name);
+
+      /**
+       * @brief Returns the hit associations of the copied space points
+       * @param event the event being processed (for the new pointers)
+       * @param spacePointHandle handle to the input space points
+       * @param socialPointIndices index of the copied points in the input
+       * @return the associations of the new space points with hits
+       *
+       * The input associations are read in a single pass; the new space point
+       * is found from the key of the pointer to the original one, with no
+       * access to the space point itself.
+       */
+      std::unique_ptr<art::Assns<recob::SpacePoint, recob::Hit>>
+      propagateAssns(
+        art::Event& event,
+        art::ValidHandle<std::vector<recob::SpacePoint>> const&
+          spacePointHandle,
+        std::vector<size_t> const& socialPointIndices
+        ) const;
+
     }; // class RemoveIsolatedSpacePoints
 
 
@@ -116,30 +228,67 @@ namespace lar {
 //--- RemoveIsolatedSpacePoints
 //---
 lar::example::RemoveIsolatedSpacePoints::RemoveIsolatedSpacePoints
-  (Parameters const& config)
-  : EDProducer{config}
+  (Parameters const& config, art::ProcessingFrame const&)
+  : SharedProducer{config}
   , spacePointsLabel(config().spacePoints())
+  , useSharedIndex(config().useSharedIndex())
+  , outputMode(parseOutputMode(config().outputMode()))
+  , propagateHitAssns(config().propagateHitAssns())
   , isolAlg(config().isolation())
 {
+  if (propagateHitAssns && (outputMode != OutputMode_t::Copy)) {
+    throw cet::exception("RemoveIsolatedSpacePoints")
+      << "Hit associations can be propagated only in 'copy' output mode ('"
+      << config().outputMode() << "' requested)\n";
+  }
+
   consumes<std::vector<recob::SpacePoint>>(spacePointsLabel);
-  produces<std::vector<recob::SpacePoint>>();
+  if (propagateHitAssns) {
+    consumes<art::Assns<recob::SpacePoint, recob::Hit>>(spacePointsLabel);
+    produces<art::Assns<recob::SpacePoint, recob::Hit>>();
+  }
+  switch (outputMode) {
+    case OutputMode_t::Copy:
+      produces<std::vector<recob::SpacePoint>>();
+      break;
+    case OutputMode_t::Mask:
+      produces<std::vector<bool>>();
+      break;
+    case OutputMode_t::Pointers:
+      produces<std::vector<art::Ptr<recob::SpacePoint>>>();
+      break;
+  } // switch
+
+  // the shared index service is also safe for concurrent events
+  async<art::InEvent>();
+
 } // lar::example::RemoveIsolatedSpacePoints::RemoveIsolatedSpacePoints()
 
 
 //------------------------------------------------------------------------------
-void lar::example::RemoveIsolatedSpacePoints::produce(art::Event& event) {
+void lar::example::RemoveIsolatedSpacePoints::beginRun
+  (art::Run&, art::ProcessingFrame const&)
+{
 
   //
-  // read the input
+  // set up the algorithm (the geometry may change only between runs)
   //
-  auto spacePointHandle
-    = event.getValidHandle<std::vector<recob::SpacePoint>>(spacePointsLabel);
+  auto const* geom = lar::providerFrom<geo::Geometry>();
+  isolAlg.setup(*geom);
+
+} // lar::example::RemoveIsolatedSpacePoints::beginRun()
+
+
+//------------------------------------------------------------------------------
+void lar::example::RemoveIsolatedSpacePoints::produce
+  (art::Event& event, art::ProcessingFrame const&)
+{
 
   //
-  // set up the algorithm
+  // read the input
   //
-  auto const* geom = lar::providerFrom<geo::Geometry>();
-  isolAlg.setup(*geom);
+  auto spacePointHandle
+    = event.getValidHandle<std::vector<recob::SpacePoint>>(spacePointsLabel);
 
   //
   // run the algorithm
@@ -147,25 +296,122 @@ void lar::example::RemoveIsolatedSpacePoints::produce(art::Event& event) {
 
   // the return value is a list of indices of non-isolated space points
   auto const& spacePoints = *spacePointHandle;
-  std::vector<size_t> socialPointIndices
-    = isolAlg.removeIsolatedPoints(spacePoints);
+  std::vector<size_t> socialPointIndices;
+  if (useSharedIndex) {
+    art::ServiceHandle<SpacePointIndexService> indexService;
+    socialPointIndices = isolAlg.removeIsolatedPoints
+      (indexService->index(event, spacePointsLabel));
+  }
+  else socialPointIndices = isolAlg.removeIsolatedPoints(spacePoints);
+
+  mf::LogInfo("RemoveIsolatedSpacePoints")
+    << "Found " << socialPointIndices.size() << "/" << spacePoints.size()
+    << " isolated space points in '" << spacePointsLabel.encode() << "'";
 
   //
   // extract and save the results
   //
-  auto socialSpacePoints = std::make_unique<std::vector<recob::SpacePoint>>();
+  switch (outputMode) {
+    case OutputMode_t::Copy: {
+      auto socialSpacePoints
+        = std::make_unique<std::vector<recob::SpacePoint>>();
+
+      socialSpacePoints->reserve(socialPointIndices.size()); // preallocate
+      for (size_t index: socialPointIndices)
+        socialSpacePoints->push_back(spacePoints[index]);
+
+      if (propagateHitAssns) {
+        event.put
+          (propagateAssns(event, spacePointHandle, socialPointIndices));
+      }
+      event.put(std::move(socialSpacePoints));
+      break;
+    } // copy
+    case OutputMode_t::Mask: {
+      auto socialMask
+        = std::make_unique<std::vector<bool>>(spacePoints.size(), false);
+      for (size_t index: socialPointIndices) (*socialMask)[index] = true;
+
+      event.put(std::move(socialMask));
+      break;
+    } // mask
+    case OutputMode_t::Pointers: {
+      // pointers are sorted as the points they point to
+      std::sort(socialPointIndices.begin(), socialPointIndices.end());
+
+      art::PtrMaker<recob::SpacePoint> makePointPtr
+        (event, spacePointHandle.id());
+      auto socialPointPtrs
+        = std::make_unique<std::vector<art::Ptr<recob::SpacePoint>>>();
+
+      socialPointPtrs->reserve(socialPointIndices.size()); // preallocate
+      for (size_t index: socialPointIndices)
+        socialPointPtrs->push_back(makePointPtr(index));
+
+      event.put(std::move(socialPointPtrs));
+      break;
+    } // pointers
+  } // switch
 
-  socialSpacePoints->reserve(socialPointIndices.size()); // preallocate
-  for (size_t index: socialPointIndices)
-    socialSpacePoints->push_back(spacePoints[index]);
+} // lar::example::RemoveIsolatedSpacePoints::produce()
 
-  mf::LogInfo("RemoveIsolatedSpacePoints")
-    << "Found " << socialSpacePoints->size() << "/" << spacePoints.size()
-    << " isolated space points in '" << spacePointsLabel.encode() << "'";
 
-  event.put(std::move(socialSpacePoints));
+//------------------------------------------------------------------------------
+std::unique_ptr<art::Assns<recob::SpacePoint, recob::Hit>>
+lar::example::RemoveIsolatedSpacePoints::propagateAssns(
+  art::Event& event,
+  art::ValidHandle<std::vector<recob::SpacePoint>> const& spacePointHandle,
+  std::vector<size_t> const& socialPointIndices
+) const
+{
+  using SpacePointHitAssns_t = art::Assns<recob::SpacePoint, recob::Hit>;
 
-} // lar::example::RemoveIsolatedSpacePoints::produce()
+  auto const& inputAssns
+    = *(event.getValidHandle<SpacePointHitAssns_t>(spacePointsLabel));
+
+  //
+  // index of the new space point from the index of the original one
+  //
+  constexpr size_t NoIndex = std::numeric_limits<size_t>::max();
+  std::vector<size_t> newIndices(spacePointHandle->size(), NoIndex);
+  for (size_t iNew = 0; iNew < socialPointIndices.size(); ++iNew)
+    newIndices[socialPointIndices[iNew]] = iNew;
+
+  //
+  // single pass on the input associations
+  //
+  art::PtrMaker<recob::SpacePoint> makeSocialPointPtr(event);
+  auto socialAssns = std::make_unique<SpacePointHitAssns_t>();
+
+  art::ProductID const inputID = spacePointHandle.id();
+  for (auto const& spacePointAndHit: inputAssns) {
+    art::Ptr<recob::SpacePoint> const& spacePointPtr = spacePointAndHit.first;
+    if (spacePointPtr.id() != inputID) {
+      throw cet::exception("RemoveIsolatedSpacePoints")
+        << "Associations '" << spacePointsLabel.encode()
+        << "' refer to space points not in the input collection\n";
+    }
+    size_t const newIndex = newIndices[spacePointPtr.key()];
+    if (newIndex == NoIndex) continue; // isolated space point
+    socialAssns->addSingle
+      (makeSocialPointPtr(newIndex), spacePointAndHit.second);
+  } // for
+
+  return socialAssns;
+} // lar::example::RemoveIsolatedSpacePoints::propagateAssns()
+
+
+//------------------------------------------------------------------------------
+auto lar::example::RemoveIsolatedSpacePoints::parseOutputMode
+  (std::string const& name) -> OutputMode_t
+{
+  if (name == "copy") return OutputMode_t::Copy;
+  if (name == "mask") return OutputMode_t::Mask;
+  if (name == "pointers") return OutputMode_t::Pointers;
+  throw cet::exception("RemoveIsolatedSpacePoints")
+    << "Invalid output mode: '" << name
+    << "' (supported: 'copy', 'mask', 'pointers')\n";
+} // lar::example::RemoveIsolatedSpacePoints::parseOutputMode()
 
 
 //------------------------------------------------------------------------------
@@ -1,15 +1,16 @@
 /**
  * @file   SpacePartition.h
- * @brief  Class to organise data into a 3D grid
+ * @brief  Class to organise data into a 3D (or 2D) grid
  * @author Gianluca Petrillo (petrillo@fnal.gov)
  * @date   May 27, 2016
  * @ingroup RemoveIsolatedSpacePoints
  *
  * This library provides:
  *
- * * SpacePartition: class to organise data in space into a 3D grid
+ * * SpacePartition: class to organise data in space into a 3D (or 2D) grid
  * * CoordRange: simple coordinate range (interval) class
- * * PositionExtractor: abstraction to extract a 3D position from an object
+ * * PositionExtractor: abstraction to extract a position from an object
+ * * BulkPositionExtractor: optional access to the coordinates of many points
  *
  * This library contains only template classes and it is header only.
  *
@@ -19,15 +20,22 @@
 #define LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPARTITION_H
 
 // LArSoft libraries
-#include "lardata/Utilities/GridContainers.h"
+#include "lardata/Utilities/GridContainerIndices.h"
 
 // C/C++ standard libraries
 #include <cstddef> // std::ptrdiff_t
-#include <cmath> // std::ceil()
+#include <cstdint> // std::int16_t, std::uint64_t
+#include <cmath> // std::ceil(), std::floor()
+#include <algorithm> // std::min(), std::max(), std::fill()
+#include <limits> // std::numeric_limits<>
+#include <memory> // std::allocator, std::allocator_traits
+#include <utility> // std::index_sequence, std::declval()
+#include <type_traits> // std::conditional_t, std::void_t, std::is_same_v
 #include <vector>
 #include <array>
 #include <string>
 #include <stdexcept> // std::runtime_error
+#include <iterator> // std::distance()
 
 
 namespace lar {
@@ -46,6 +54,8 @@ namespace lar {
      * - `static T y(Point const& point)`: return y coordinate of point
      * - `static T z(Point const& point)`: return z coordinate of point
      *
+     * Points used only in two dimensions (e.g. with `SpacePartition` with
+     * `Dims` equal to `2`) need only `x()` and `y()`.
      * The type T must be convertible to a number (typically a real one).
      * Examples of specialisation:
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -85,15 +95,80 @@ namespace lar {
     template <typename Point>
     struct PositionExtractor;
 
+    /**
+     * @brief Optional access to the coordinates of many points at once
+     * @tparam PointIter type of iterator to the points
+     *
+     * When the coordinates of the points are already stored in one contiguous
+     * array per dimension ("structure of arrays"), this class can be
+     * specialised for the iterator to the points, so that the algorithms
+     * read the coordinates straight from the arrays instead of one point at a
+     * time (`PositionExtractor` for the point type is still required).
+     * The specialisation must provide:
+     *
+     *     static std::array<Coord const*, 3U> coordinates(PointIter it);
+     *
+     * returning the address of each of the coordinates of the point at `it`,
+     * with `Coord` the coordinate type from `PositionExtractor`; the
+     * coordinates of the following points must follow, so that coordinate
+     * `d` of the point at `it + i` is `coordinates(it)[d][i]`.
+     * In two dimensions, the third pointer is not used.
+     *
+     * Example for a collection of points stored as three vectors, where the
+     * iterator holds the collection and the index of the point:
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     *     template <>
+     *     struct BulkPositionExtractor<PointArraysIter> {
+     *
+     *       static std::array<double const*, 3U> coordinates
+     *         (PointArraysIter it)
+     *         {
+     *           auto const& arrays = it.collection();
+     *           return {{
+     *             arrays.x.data() + it.index(),
+     *             arrays.y.data() + it.index(),
+     *             arrays.z.data() + it.index()
+     *             }};
+     *         }
+     *
+     *     };
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     *
+     * The general template provides no `coordinates()`, and the points are
+     * then accessed one at a time.
+     */
+    template <typename PointIter, typename Enable = void>
+    struct BulkPositionExtractor {};
+
     namespace details {
       template <typename Point>
       struct PointTraits_t;
 
+      /// Whether `BulkPositionExtractor<PointIter>` provides `coordinates()`
+      template <typename PointIter, typename = void>
+      struct HasBulkPositions: std::false_type {};
+
+      template <typename PointIter>
+      struct HasBulkPositions<PointIter, std::void_t<decltype(
+        BulkPositionExtractor<PointIter>::coordinates(std::declval<PointIter>())
+        )>>: std::true_type {};
+
+      /// Whether the coordinates of the points are available as arrays
+      template <typename PointIter>
+      constexpr bool hasBulkPositions = HasBulkPositions<PointIter>::value;
+
       /// type of Point coordinate
       template <typename Point>
       using ExtractCoordType_t
         = typename details::PointTraits_t<Point>::Coord_t;
 
+      /// Type of index manager for a grid with `Dims` dimensions (2 or 3)
+      template <unsigned int Dims>
+      using GridIndexer_t = std::conditional_t<
+        Dims == 2U, ::util::GridContainer2DIndices,
+        ::util::GridContainer3DIndices
+        >;
+
     } // namespace details
 
 
@@ -165,19 +240,55 @@ namespace lar {
     /**
      * @brief A container of points sorted in cells
      * @tparam PointIter type of iterator to the point
+     * @tparam Alloc allocator for the content of the cells
+     * @tparam Dims number of dimensions of the grid (`3` or `2`)
      *
      * This container arranges its elements into a 3D grid according to their
      * position in space.
      * The "position" is defined by the `PositionExtractor` class.
+     * With `Dims` set to `2`, the grid is two-dimensional and only the first
+     * two coordinates of the points (`x` and `y`) are used.
      *
      * The container stores a bit on information for each cell (it is not
      * _sparse_), therefore its size can become large very quickly.
      * Currently each (empty) cell in the grid uses
-     * `sizeof(std::vector<...>)`, that is 24, bytes.
+     * `sizeof(std::vector<PointIter, Alloc>)`, that is 24 bytes with the
+     * standard allocator, plus a bit in the occupancy map.
+     *
+     * All the memory of the container, both the cell table and the content of
+     * each cell, is requested to the allocator `Alloc` (rebound as needed),
+     * a copy of which can be passed to the constructor. This allows for example
+     * to use an arena (like `MonotonicArena`) which is reset after each event,
+     * so that filling the partition does not translate in a memory allocation
+     * per cell.
+     *
+     * The position of an element in the container can be computed from a
+     * copy of it with `pointIndex()`. The container can also be used as a
+     * spatial index: `forEachPointWithin()` visits all the points within a
+     * distance from an arbitrary position, and `nearestPoints()` finds the
+     * points closest to it. Neither allocates memory.
+     *
+     * The container also keeps a map of which cells contain points, with one
+     * bit per cell (`isOccupied()`), and a coarser one with one bit per block
+     * ("super-cell") of `SuperCellSide` cells per side
+     * (`isSuperCellOccupied()`). These allow to skip empty cells and regions
+     * without accessing the cells themselves: in sparse data, most of the
+     * cells are empty. `forEachOccupied()` visits the non-empty cells in a
+     * range of cell indices, a 64-bit word at a time.
+     *
+     * Optionally, the container can also store for each point a compact,
+     * quantised version of its position, relative to the origin of its cell
+     * (`enableQuantization()`). Each coordinate is a 16-bit integer, in units
+     * of a "quantum" which is an integral fraction of the cell size. These
+     * positions are kept in a separate table (`quantizedCell()`), in the same
+     * order as the points in the cell. This requires all the dimensions of the
+     * cells to be the same.
      *
-     * Currently, no facility is provided to find an element, although from a
-     * copy of the element, its position in the container can be computed with
-     * `pointIndex()`.
+     * Optionally, the container can also keep for each cell the smallest box
+     * containing all its points (`enableBoundingBoxes()`, `cellBox()`), which
+     * allows to tell that all the points of two cells are far from each other
+     * without looking at the points. This costs `2 * Dims` coordinates per
+     * cell (48 bytes for 3D double coordinates).
      *
      * For example, suppose you need to arrange points in a box of 6 x 8 x 4
      * (arbitrary units) symmetric around the origin, each with 20 cells.
@@ -218,70 +329,443 @@ namespace lar {
      * The class `PositionExtractor` is specialized for `double const*` in this
      * same library.
      */
-    template <typename PointIter>
+    template <
+      typename PointIter,
+      typename Alloc = std::allocator<PointIter>,
+      unsigned int Dims = 3U
+      >
     class SpacePartition {
+      static_assert((Dims == 2U) || (Dims == 3U),
+        "SpacePartition supports only 2 or 3 dimensions");
+
       using Point_t = decltype(*(PointIter())); ///< type of the point
-      using Grid_t = ::util::GridContainer3D<PointIter>; ///< data container
 
         public:
+      /// Returns the number of dimensions of the grid
+      static constexpr unsigned int dims() { return Dims; }
+
       /// type of point coordinate
       using Coord_t = details::ExtractCoordType_t<Point_t>;
       using Range_t = CoordRangeCells<Coord_t>; ///< type of coordinate range
 
+      /// type of allocator for the cell content
+      using Allocator_t = Alloc;
+
       /// type of index manager of the grid
-      using Indexer_t = typename Grid_t::Indexer_t;
+      using Indexer_t = details::GridIndexer_t<Dims>;
+
+      /// type of the ranges on all the dimensions
+      using Ranges_t = std::array<Range_t, Dims>;
 
       /// type of difference between cell indices
       using CellIndexOffset_t = typename Indexer_t::CellIndexOffset_t;
 
       using CellIndex_t = typename Indexer_t::CellIndex_t; /// type of cell index
 
+      /// type of cell index on a single dimension
+      using CellDimIndex_t = typename Indexer_t::CellDimIndex_t;
+
       /// type of cell identifier
       using CellID_t = typename Indexer_t::CellID_t;
 
       /// type of cell
-      using Cell_t = typename Grid_t::Cell_t;
+      using Cell_t = std::vector<PointIter, Allocator_t>;
+
+      /// type of quantised position of a point, relative to its cell origin
+      using QuantizedPosition_t = std::array<std::int16_t, Dims>;
+
+      /// type of quantised positions of all the points in a cell
+      using QuantizedCell_t = std::vector<
+        QuantizedPosition_t,
+        typename std::allocator_traits<Allocator_t>
+          ::template rebind_alloc<QuantizedPosition_t>
+        >;
+
+      /// Largest number of quanta in a cell side
+      static constexpr int MaxCellQuanta
+        = std::numeric_limits<std::int16_t>::max();
+
+      /// Number of cells on each side of a super-cell of the occupancy map
+      static constexpr unsigned int SuperCellSide = 4U;
+
+      /// type of box containing all the points of a cell (range per dimension)
+      using CellBox_t = std::array<CoordRange<Coord_t>, Dims>;
+
+      /// type of a position in space, as used in queries
+      using Position_t = std::array<Coord_t, Dims>;
+
+      /// A point found by `nearestPoints()`
+      struct NearPoint_t {
+        PointIter point; ///< the point
+        Coord_t distance2; ///< square of its distance from the query position
+      }; // NearPoint_t
+
+        private:
+      /// allocator for the cell table
+      using CellAllocator_t = typename std::allocator_traits<Allocator_t>
+        ::template rebind_alloc<Cell_t>;
+
+      using Cells_t = std::vector<Cell_t, CellAllocator_t>; ///< cell table
+
+      /// table of the quantised positions of the points in each cell
+      using QuantizedCells_t = std::vector<
+        QuantizedCell_t,
+        typename std::allocator_traits<Allocator_t>
+          ::template rebind_alloc<QuantizedCell_t>
+        >;
+
+      /// table of the bounding boxes of the points in each cell
+      using CellBoxes_t = std::vector<
+        CellBox_t,
+        typename std::allocator_traits<Allocator_t>
+          ::template rebind_alloc<CellBox_t>
+        >;
+
+      using OccupancyWord_t = std::uint64_t; ///< a word of occupancy bits
+
+      /// number of bits in a word of the occupancy map
+      static constexpr unsigned int OccupancyWordBits = 64U;
+
+      /// bit map of occupancy
+      using OccupancyBits_t = std::vector<
+        OccupancyWord_t,
+        typename std::allocator_traits<Allocator_t>
+          ::template rebind_alloc<OccupancyWord_t>
+        >;
+
+        public:
+      /// type of iterator to the cells
+      using const_iterator = typename Cells_t::const_iterator;
 
       /// Constructs the partition in a given volume with the given cell size
       SpacePartition
-        (Range_t rangeX, Range_t rangeY, Range_t rangeZ);
+        (Ranges_t const& ranges, Allocator_t const& alloc = Allocator_t());
+
+      /// Constructs the 3D partition in a given volume with the given cell size
+      SpacePartition(
+        Range_t rangeX, Range_t rangeY, Range_t rangeZ,
+        Allocator_t const& alloc = Allocator_t()
+        )
+        : SpacePartition(Ranges_t{{ rangeX, rangeY, rangeZ }}, alloc)
+        {}
+
+      /**
+       * @brief Enables the storage of quantised positions
+       * @param quantum the requested precision of the quantised coordinates
+       * @return the quantum actually used
+       * @throw std::runtime_error if the cells are not cubic
+       *
+       * The actual quantum is the smallest integral fraction of the cell size
+       * that is not smaller than the requested `quantum`, and that still
+       * allows the cell size to fit into `MaxCellQuanta` quanta.
+       * This must be called before the partition is filled.
+       */
+      Coord_t enableQuantization(Coord_t quantum);
+
+      /// Returns whether quantised positions are stored
+      bool isQuantized() const { return nCellQuanta > 0; }
+
+      /// Returns the size of the quantum of the quantised positions
+      Coord_t quantum() const { return quantumSize; }
+
+      /// Returns the size of the side of a cell, in quanta
+      int cellQuanta() const { return nCellQuanta; }
+
+      /**
+       * @brief Enables the tracking of the bounding box of each cell
+       *
+       * The bounding box of a cell is the smallest box containing all the
+       * points in the cell (empty cells have an empty box).
+       * This must be called before the partition is filled.
+       */
+      void enableBoundingBoxes();
+
+      /// Returns whether the bounding boxes of the cells are tracked
+      bool hasBoundingBoxes() const { return !boxes.empty(); }
 
       /// Fills the partition with the points in the specified range
       /// @throw std::runtime_error a point is outside the covered volume
+      /// @see BulkPositionExtractor
       void fill(PointIter begin, PointIter end);
 
+      /**
+       * @brief Fills the partition with some of the points of a range
+       * @tparam IndexIter forward iterator to the indices of the points
+       * @param base iterator to the first point of the range
+       * @param first iterator to the index of the first point to be added
+       * @param last iterator after the index of the last point to be added
+       * @throw std::runtime_error a point is outside the covered volume
+       *
+       * The point `base + index` is added for each index in the list (each
+       * index should appear only once).
+       * The points are stored as iterators into the whole range, so that
+       * `std::distance(base, point)` is the index of a point in the range,
+       * and the points are not copied.
+       */
+      template <typename IndexIter>
+      void fillSubset(PointIter base, IndexIter first, IndexIter last);
+
+      /**
+       * @brief Fills the partition with the points of a range selected by mask
+       * @param base iterator to the first point of the range
+       * @param mask whether each point in the range is added
+       * @throw std::runtime_error a point is outside the covered volume
+       *
+       * The point `base + i` is added if `mask[i]` is `true`.
+       * @see fillSubset(PointIter, IndexIter, IndexIter)
+       */
+      void fillSubset(PointIter base, std::vector<bool> const& mask);
+
+      /**
+       * @brief Removes all the points from the partition
+       *
+       * The grid and its settings (quantisation, bounding boxes) are kept, as
+       * is the memory of the cells, so that the partition can be filled again
+       * with no allocation. Only the occupied cells are visited.
+       */
+      void clear();
+
       /// Returns the index pertaining the point (might be invalid!)
       /// @throw std::runtime_error point is outside the covered volume
-      CellIndexOffset_t pointIndex(Point_t const& point) const;
+      CellIndexOffset_t pointIndex(Point_t const& point) const
+        { return indices.index(pointCellID(point)); }
+
+      /// Returns the ID of the cell pertaining the point
+      /// @throw std::runtime_error point is outside the covered volume
+      CellID_t pointCellID(Point_t const& point) const;
 
       /// Returns the index manager of the grid
       Indexer_t const& indexManager() const
-        { return data.indexManager(); }
+        { return indices; }
+
+      /// Returns the number of cells on each of the dimensions of the grid
+      std::array<size_t, Dims> const& dimensions() const
+        { return dimSizes; }
+
+      /// Returns the range and cell size on each of the dimensions of the grid
+      Ranges_t const& ranges() const { return dimRanges; }
 
       /// Returns whether there is a cell with the specified index (signed!)
       bool has(CellIndexOffset_t ofs) const
-        { return data.has(ofs); }
+        { return indices.has(ofs); }
 
       /// Returns the cell with the specified index
       Cell_t const& operator[] (CellIndex_t index) const
         { return data[index]; }
 
+      /// Returns the quantised positions of the points in the specified cell
+      /// (only if `isQuantized()`)
+      QuantizedCell_t const& quantizedCell(CellIndex_t index) const
+        { return quantizedData[index]; }
+
+      /// Returns the box containing all the points in the specified cell
+      /// (only if `hasBoundingBoxes()`)
+      CellBox_t const& cellBox(CellIndex_t index) const
+        { return boxes[index]; }
+
+      /// Returns whether the cell with the specified index contains points
+      bool isOccupied(CellIndex_t index) const
+        { return testBit(occupancy, index); }
+
+      /// Returns whether any cell in the super-cell of `cellID` has points
+      bool isSuperCellOccupied(CellID_t const& cellID) const
+        { return testBit(superOccupancy, superCellIndex(cellID)); }
+
+      /**
+       * @brief Returns the first cell of a row in an occupied super-cell
+       * @param cellID ID of the first cell of the row to be considered
+       * @param rowEnd index (on the last dimension) after the end of the row
+       * @return the index on the last dimension of the first cell, from
+       *         `cellID` on, whose super-cell has points (`rowEnd` if none)
+       *
+       * The row is along the last dimension, where the super-cells have
+       * contiguous indices, so that their occupancy is tested a word at a
+       * time.
+       */
+      CellDimIndex_t firstInOccupiedSuperCell
+        (CellID_t const& cellID, CellDimIndex_t rowEnd) const;
+
+      /**
+       * @brief Calls `op(index)` for each non-empty cell in a range of indices
+       * @tparam Op type of operation, callable with a `CellIndex_t` argument
+       * @param first index of the first cell to be considered
+       * @param last index of the last cell to be considered (included!)
+       * @param op operation to be called
+       *
+       * The cells are visited in order of index. The range must be valid.
+       * Only the bits of the occupancy map are accessed, a word at a time,
+       * so that a range of up to 64 empty cells costs one or two word tests.
+       */
+      template <typename Op>
+      void forEachOccupied(CellIndex_t first, CellIndex_t last, Op op) const;
+
+      /**
+       * @brief Calls `op(index)` for each non-empty cell around a cell
+       * @tparam Op type of operation, callable with a `CellIndex_t` argument
+       * @param cellID ID of the central cell
+       * @param extent number of cells on each side of the central one
+       * @param op operation to be called
+       *
+       * The neighbourhood is the block of cells up to `extent` cells away
+       * from `cellID` on each dimension, central cell included, clipped to
+       * the grid. It is visited one row along the last dimension at a time
+       * (see `forEachOccupied()`), so the cells are visited in order of index.
+       */
+      template <typename Op>
+      void forEachOccupiedNeighbor
+        (CellID_t const& cellID, unsigned int extent, Op op) const;
+
+      /**
+       * @brief Calls `op(point)` for each point within a distance of a position
+       * @tparam Op type of operation, callable with a `PointIter` argument
+       * @param position the position to measure the distance from
+       * @param radius the largest distance of the points from `position`
+       * @param op operation to be called
+       *
+       * All the points in the partition not farther than `radius` from
+       * `position` are visited, in no particular order. The position does not
+       * need to be inside the volume of the partition.
+       * Only the rows of cells (along the last dimension) crossing the sphere
+       * are explored, via the occupancy map, and no memory is allocated.
+       */
+      template <typename Op>
+      void forEachPointWithin
+        (Position_t const& position, Coord_t radius, Op op) const;
+
+      /**
+       * @brief Finds the points closest to a position
+       * @param position the position to measure the distance from
+       * @param k the number of points to be found
+       * @param nearest where to store the points found (room for `k` of them)
+       * @return the number of points found
+       *
+       * The `k` points closest to `position` are stored into `nearest`, from
+       * the closest one. Fewer points are returned only if the partition does
+       * not have `k` points. No memory is allocated: the points are searched
+       * with `forEachPointWithin()`, starting from a radius as large as a cell
+       * and doubling it until enough points are found.
+       */
+      size_t nearestPoints
+        (Position_t const& position, size_t k, NearPoint_t* nearest) const;
+
       /// Returns a constant iterator pointing to the first cell
-      typename Grid_t::const_iterator begin() const;
+      const_iterator begin() const { return data.begin(); }
 
       /// Returns a constant iterator pointing after the last cell
-      typename Grid_t::const_iterator end() const;
+      const_iterator end() const { return data.end(); }
+
+      /// Returns a copy of the allocator used for the cell content
+      Allocator_t get_allocator() const
+        { return Allocator_t(data.get_allocator()); }
 
         protected:
-      using CellDimIndex_t = typename Grid_t::CellDimIndex_t;
+      Ranges_t dimRanges; ///< coordinates of the contained volume on each axis
+
+      std::array<size_t, Dims> dimSizes; ///< number of cells on each dimension
+      Indexer_t indices; ///< index manager of the grid
+      Cells_t data; ///< container of points, one cell per grid index
 
-      Coord_t cellSize; ///< length of the side of each cubic cell
+      Coord_t quantumSize = Coord_t(0); ///< size of quantised position units
+      int nCellQuanta = 0; ///< number of quanta in the cell side (0: disabled)
+      QuantizedCells_t quantizedData; ///< quantised positions, one per point
 
-      Range_t xRange; ///< coordinates of the contained volume on x axis
-      Range_t yRange; ///< coordinates of the contained volume on z axis
-      Range_t zRange; ///< coordinates of the contained volume on z axis
+      CellBoxes_t boxes; ///< bounding box of each cell (empty: not tracked)
 
-      Grid_t data; ///< container of points
+      OccupancyBits_t occupancy; ///< one bit per cell: whether it has points
+      Indexer_t superIndices; ///< index manager of the super-cells
+      OccupancyBits_t superOccupancy; ///< one bit per super-cell
+
+      /// Returns the index of the super-cell including cell `cellID`
+      CellIndex_t superCellIndex(CellID_t const& cellID) const;
+
+      /// Marks as occupied the cell with the specified ID and index
+      void setOccupied(CellID_t const& cellID, CellIndex_t index);
+
+      /// Adds a single point to its cell
+      /// @throw std::runtime_error the point is outside the covered volume
+      void addPoint(PointIter it);
+
+      /// Extends the bounding box of the cell `index` to include `point`
+      template <std::size_t... Dim>
+      void extendBox(
+        CellIndex_t index, Point_t const& point, std::index_sequence<Dim...>
+        );
+
+      /// Returns the value of bit `index` of the map `bits`
+      static bool testBit(OccupancyBits_t const& bits, CellIndex_t index)
+        {
+          return (bits[index / OccupancyWordBits]
+            >> (index % OccupancyWordBits)) & 1U;
+        }
+
+      /// Returns a box with inverted boundaries, extended by any point
+      static CellBox_t emptyCellBox();
+
+      /// Returns the number of super-cells on each dimension
+      static std::array<size_t, Dims> superCellDims
+        (std::array<size_t, Dims> const& cellDims);
+
+      /// Returns the number of words needed to store the specified bits
+      static size_t occupancyWords(size_t nBits)
+        { return (nBits + OccupancyWordBits - 1) / OccupancyWordBits; }
+
+      /// Calls `op(point, distance2)` for each point within `radius`
+      template <typename Op>
+      void forEachPointWithinImpl
+        (Position_t const& position, Coord_t radius, Op op) const;
+
+      /// Returns the cell on dimension `dim` of coordinate `c`, not clipped
+      /// to the grid (and not converted to an index)
+      Coord_t cellOnDim(unsigned int dim, Coord_t c) const
+        {
+          Range_t const& range = dimRanges[dim];
+          return std::floor(range.offset(c) / range.cellSize);
+        }
+
+      /// Returns the distance of coordinate `c` from `cell` on dimension `dim`
+      Coord_t distanceFromCellOnDim
+        (unsigned int dim, CellDimIndex_t cell, Coord_t c) const;
+
+      /// Moves `rowStart` to the next row of cells (along the last dimension)
+      /// in the block [ `lower`, `upper` ]; returns `false` after the last one
+      static bool nextRow
+        (CellID_t& rowStart, CellID_t const& lower, CellID_t const& upper);
+
+      /// Returns the square of the distance of `point` from `position`
+      template <std::size_t... Dim>
+      static Coord_t distance2From(
+        Position_t const& position, Point_t const& point,
+        std::index_sequence<Dim...>
+        );
+
+      /// Number of points whose cells are computed together by `fill()`, when
+      /// their coordinates are available as arrays (`BulkPositionExtractor`)
+      static constexpr std::size_t BulkFillBlockSize = 64;
+
+      /// Implementation of `fill()` reading coordinates from arrays
+      /// (a template, so that it is compiled only for iterators supporting it)
+      template <typename Iter>
+      void fillFromArrays(Iter begin, Iter end);
+
+      /// Returns the cell ID of `point`, with dimensions `Dim...`
+      template <std::size_t... Dim>
+      CellID_t pointCellIDimpl
+        (Point_t const& point, std::index_sequence<Dim...>) const;
+
+      /// Returns the cell index of coordinate `c` on dimension `dim`
+      /// @throw std::runtime_error coordinate is outside the covered volume
+      CellDimIndex_t findCellOnDim(unsigned int dim, Coord_t c) const;
+
+      /// Returns the quantised position of `point` relative to cell `cellID`
+      template <std::size_t... Dim>
+      QuantizedPosition_t quantizePosition(
+        Point_t const& point, CellID_t const& cellID,
+        std::index_sequence<Dim...>
+        ) const;
+
+      /// Returns the quantised coordinate `c` relative to cell `cell`
+      std::int16_t quantizeCoordinate
+        (Range_t const& range, Coord_t c, CellDimIndex_t cell) const;
 
     }; // SpacePartition<>
 
@@ -309,6 +793,16 @@ namespace lar {
       auto extractPositionZ(Point const& point)
         { return PositionExtractor<Point>::z(point); }
 
+      /// Returns the coordinate `Dim` of the point (`0` is x, `1` y, `2` z)
+      template <unsigned int Dim, typename Point>
+      auto extractPosition(Point const& point)
+        {
+          static_assert(Dim < 3U, "Only three coordinates are supported");
+          if constexpr (Dim == 0U) return extractPositionX(point);
+          else if constexpr (Dim == 1U) return extractPositionY(point);
+          else return extractPositionZ(point);
+        } // extractPosition()
+
       template <typename Point>
       struct PointTraits_t {
         /// type of Point coordinate
@@ -324,9 +818,10 @@ namespace lar {
     {};
 
     /// Specialisation of PositionExtractor for C++ array: { x, y, z }
-    template <typename T>
-    struct PositionExtractor<std::array<T, 3U>>:
-      public details::PositionExtractorFromArray<std::array<T, 3U>, T>
+    /// (or { x, y })
+    template <typename T, std::size_t N>
+    struct PositionExtractor<std::array<T, N>>:
+      public details::PositionExtractorFromArray<std::array<T, N>, T>
     {};
 
     /// Specialisation of PositionExtractor for C++ vector: { x, y, z }
@@ -351,7 +846,30 @@ namespace lar {
   namespace example {
     namespace details {
 
+      /// Returns the position of the lowest bit set in `word` (not `0`)
+      inline unsigned int lowestBitSet(std::uint64_t word)
+        {
+#if defined(__GNUC__)
+          return __builtin_ctzll(word);
+#else
+          unsigned int bit = 0;
+          while (!(word & 1U)) { word >>= 1; ++bit; }
+          return bit;
+#endif
+        } // lowestBitSet()
+
       /// Returns the dimensions of a grid diced with the specified size
+      template <typename Coord, std::size_t Dims>
+      std::array<size_t, Dims> diceVolume
+        (std::array<CoordRangeCells<Coord>, Dims> const& ranges)
+        {
+          std::array<size_t, Dims> dims;
+          for (std::size_t i = 0; i < Dims; ++i)
+            dims[i] = size_t(std::ceil(ranges[i].size() / ranges[i].cellSize));
+          return dims;
+        } // diceVolume()
+
+      /// Returns the dimensions of a 3D grid diced with the specified size
       template <typename Coord>
       std::array<size_t, 3> diceVolume(
         CoordRangeCells<Coord> const& rangeX,
@@ -408,7 +926,7 @@ bool lar::example::CoordRange<Coord>::operator!= (const Range_t& than) const
 template <typename Coord>
 lar::example::CoordRangeCells<Coord>::CoordRangeCells
   (Coord_t low, Coord_t high, Coord_t cs)
-  : Base_t(low, high), cellSize(cs)
+  : Base_t{ low, high }, cellSize(cs)
   {}
 
 template <typename Coord>
@@ -426,74 +944,609 @@ std::ptrdiff_t lar::example::CoordRangeCells<Coord>::findCell(Coord_t c) const
 //------------------------------------------------------------------------------
 //--- lar::example::SpacePartition
 //---
-template <typename PointIter>
-lar::example::SpacePartition<PointIter>::SpacePartition
-  (Range_t rangeX, Range_t rangeY, Range_t rangeZ)
-  : xRange(rangeX)
-  , yRange(rangeY)
-  , zRange(rangeZ)
-  , data(details::diceVolume(xRange, yRange, zRange))
+template <typename PointIter, typename Alloc, unsigned int Dims>
+lar::example::SpacePartition<PointIter, Alloc, Dims>::SpacePartition
+  (Ranges_t const& ranges, Allocator_t const& alloc /* = Allocator_t() */)
+  : dimRanges(ranges)
+  , dimSizes(details::diceVolume(dimRanges))
+  , indices(dimSizes)
+  , data(indices.size(), Cell_t(alloc), CellAllocator_t(alloc))
+  , quantizedData(alloc)
+  , boxes(alloc)
+  , occupancy(occupancyWords(indices.size()), 0, alloc)
+  , superIndices(superCellDims(dimSizes))
+  , superOccupancy(occupancyWords(superIndices.size()), 0, alloc)
 {
   /*
     std::cout << "Grid: "
       << indexManager().sizeX() << " x "
       << indexManager().sizeY() << " x " << indexManager().sizeZ()
       << " (" << indexManager().size() << " cells)"
-      << "\n  range X: " << xRange.lower << " -- " << xRange.upper << " [/" << xRange.cellSize << "]"
-      << "\n  range Y: " << yRange.lower << " -- " << yRange.upper << " [/" << yRange.cellSize << "]"
-      << "\n  range Z: " << zRange.lower << " -- " << zRange.upper << " [/" << zRange.cellSize << "]"
+      << "\n  range X: " << ranges()[0].lower << " -- " << ranges()[0].upper << " [/" << ranges()[0].cellSize << "]"
+      << "\n  range Y: " << ranges()[1].lower << " -- " << ranges()[1].upper << " [/" << ranges()[1].cellSize << "]"
+      << "\n  range Z: " << ranges()[2].lower << " -- " << ranges()[2].upper << " [/" << ranges()[2].cellSize << "]"
       << std::endl;
   */
 } // lar::example::SpacePartition<>::SpacePartition
 
 
 //--------------------------------------------------------------------------
-template <typename PointIter>
-void lar::example::SpacePartition<PointIter>::fill
+template <typename PointIter, typename Alloc, unsigned int Dims>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::fill
   (PointIter begin, PointIter end)
 {
+  if constexpr (details::hasBulkPositions<PointIter>) {
+    fillFromArrays(begin, end);
+    return;
+  }
+
+  bool const trackBoxes = hasBoundingBoxes();
 
   PointIter it = begin;
-  while (it != end) {
-    // if the point is outside the volume, pointIndex will throw an exception
-    data.insert(pointIndex(*it), it);
-    ++it;
-  } // while
+  if (isQuantized()) {
+    while (it != end) {
+      // if the point is outside the volume, pointCellID will throw
+      CellID_t const cellID = pointCellID(*it);
+      CellIndex_t const index = indices.index(cellID);
+      data[index].push_back(it);
+      setOccupied(cellID, index);
+      quantizedData[index].push_back
+        (quantizePosition(*it, cellID, std::make_index_sequence<Dims>()));
+      if (trackBoxes)
+        extendBox(index, *it, std::make_index_sequence<Dims>());
+      ++it;
+    } // while
+  }
+  else {
+    while (it != end) {
+      // if the point is outside the volume, pointCellID will throw
+      CellID_t const cellID = pointCellID(*it);
+      CellIndex_t const index = indices.index(cellID);
+      data[index].push_back(it);
+      setOccupied(cellID, index);
+      if (trackBoxes)
+        extendBox(index, *it, std::make_index_sequence<Dims>());
+      ++it;
+    } // while
+  }
 
 } // lar::example::SpacePartition<>::fill()
 
 
 //--------------------------------------------------------------------------
-template <typename PointIter>
-typename lar::example::SpacePartition<PointIter>::CellIndexOffset_t
-lar::example::SpacePartition<PointIter>::pointIndex(Point_t const& point) const
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <typename Iter>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::fillFromArrays
+  (Iter begin, Iter end)
 {
-  // compute the cell ID coordinates
-  Coord_t const x = details::extractPositionX(point);
-  CellDimIndex_t const xc = xRange.findCell(x);
-  if (!data.hasX(xc)) {
-    throw std::runtime_error
-      ("Point out of the volume (x = " + std::to_string(x) + ")");
-  }
+  static_assert(std::is_same_v<Iter, PointIter>,
+    "fillFromArrays() works on the iterator type of the partition");
+
+  auto const coords = BulkPositionExtractor<PointIter>::coordinates(begin);
+  std::size_t const nPoints = std::distance(begin, end);
+
+  bool const quantized = isQuantized();
+  bool const trackBoxes = hasBoundingBoxes();
+
+  //
+  // optimisation (speed): the cells of a block of points are computed one
+  // dimension at a time, in loops with no branches that the compiler can
+  // vectorise; the points are then assigned to the cells one by one
+  //
+  CellDimIndex_t cells[Dims][BulkFillBlockSize];
+  for (std::size_t blockStart = 0; blockStart < nPoints;
+    blockStart += BulkFillBlockSize
+  ) {
+    std::size_t const blockSize
+      = std::min(BulkFillBlockSize, nPoints - blockStart);
+
+    for (std::size_t d = 0; d < Dims; ++d) {
+      Range_t const& range = dimRanges[d];
+      auto const* coord = coords[d] + blockStart;
+      for (std::size_t i = 0; i < blockSize; ++i)
+        cells[d][i] = range.findCell(coord[i]);
+    } // for dimensions
+
+    for (std::size_t i = 0; i < blockSize; ++i) {
+      CellID_t cellID;
+      for (std::size_t d = 0; d < Dims; ++d) {
+        cellID[d] = cells[d][i];
+        // if the point is outside the volume, findCellOnDim() will throw
+        if ((cellID[d] < 0) || (cellID[d] >= (CellDimIndex_t) dimSizes[d]))
+          findCellOnDim(d, coords[d][blockStart + i]);
+      } // for dimensions
+
+      PointIter const it = begin + (blockStart + i);
+      CellIndex_t const index = indices.index(cellID);
+      data[index].push_back(it);
+      setOccupied(cellID, index);
+      if (quantized) {
+        quantizedData[index].push_back
+          (quantizePosition(*it, cellID, std::make_index_sequence<Dims>()));
+      }
+      if (trackBoxes)
+        extendBox(index, *it, std::make_index_sequence<Dims>());
+    } // for points in block
+  } // for blocks
+
+} // lar::example::SpacePartition<>::fillFromArrays()
 
-  Coord_t const y = details::extractPositionY(point);
-  CellDimIndex_t const yc = yRange.findCell(y);
-  if (!data.hasY(yc)) {
-    throw std::runtime_error
-      ("Point out of the volume (y = " + std::to_string(y) + ")");
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <typename IndexIter>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::fillSubset
+  (PointIter base, IndexIter first, IndexIter last)
+{
+  while (first != last) addPoint(base + *(first++));
+} // lar::example::SpacePartition<>::fillSubset(IndexIter)
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::fillSubset
+  (PointIter base, std::vector<bool> const& mask)
+{
+  for (std::size_t i = 0; i < mask.size(); ++i)
+    if (mask[i]) addPoint(base + i);
+} // lar::example::SpacePartition<>::fillSubset(mask)
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::addPoint
+  (PointIter it)
+{
+  // if the point is outside the volume, pointCellID will throw
+  CellID_t const cellID = pointCellID(*it);
+  CellIndex_t const index = indices.index(cellID);
+  data[index].push_back(it);
+  setOccupied(cellID, index);
+  if (isQuantized()) {
+    quantizedData[index].push_back
+      (quantizePosition(*it, cellID, std::make_index_sequence<Dims>()));
   }
+  if (hasBoundingBoxes())
+    extendBox(index, *it, std::make_index_sequence<Dims>());
+} // lar::example::SpacePartition<>::addPoint()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::clear() {
+
+  if (indices.size() > 0) {
+    bool const quantized = isQuantized();
+    bool const trackBoxes = hasBoundingBoxes();
+    CellBox_t const emptyBox = emptyCellBox();
+    forEachOccupied(0, indices.size() - 1,
+      [this, quantized, trackBoxes, &emptyBox](CellIndex_t index)
+        {
+          data[index].clear(); // capacity is kept
+          if (quantized) quantizedData[index].clear();
+          if (trackBoxes) boxes[index] = emptyBox;
+        }
+      );
+  } // if
+
+  std::fill(occupancy.begin(), occupancy.end(), OccupancyWord_t(0));
+  std::fill(superOccupancy.begin(), superOccupancy.end(), OccupancyWord_t(0));
+
+} // lar::example::SpacePartition<>::clear()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <typename Op>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::forEachOccupied
+  (CellIndex_t first, CellIndex_t last, Op op) const
+{
+  CellIndex_t const firstWord = first / OccupancyWordBits;
+  CellIndex_t const lastWord = last / OccupancyWordBits;
+  for (CellIndex_t iWord = firstWord; iWord <= lastWord; ++iWord) {
+    OccupancyWord_t word = occupancy[iWord];
+
+    // mask out the bits outside the range
+    if (iWord == firstWord)
+      word &= ~OccupancyWord_t(0) << (first % OccupancyWordBits);
+    if (iWord == lastWord) {
+      word &= ~OccupancyWord_t(0)
+        >> (OccupancyWordBits - 1 - (last % OccupancyWordBits));
+    }
+
+    // visit the bits that are set, from the lowest
+    while (word != 0) {
+      op(CellIndex_t(iWord * OccupancyWordBits + details::lowestBitSet(word)));
+      word &= word - 1; // clear the lowest bit set
+    } // while
+  } // for words
+} // lar::example::SpacePartition<>::forEachOccupied()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::firstInOccupiedSuperCell
+  (CellID_t const& cellID, CellDimIndex_t rowEnd) const -> CellDimIndex_t
+{
+  constexpr std::size_t lastDim = Dims - 1;
+  if (cellID[lastDim] >= rowEnd) return rowEnd;
+
+  CellID_t lastCellID = cellID;
+  lastCellID[lastDim] = rowEnd - 1;
+  CellIndex_t const first = superCellIndex(cellID);
+  CellIndex_t const last = superCellIndex(lastCellID);
+
+  CellIndex_t const firstWord = first / OccupancyWordBits;
+  CellIndex_t const lastWord = last / OccupancyWordBits;
+  for (CellIndex_t iWord = firstWord; iWord <= lastWord; ++iWord) {
+    OccupancyWord_t word = superOccupancy[iWord];
+
+    // mask out the bits outside the range
+    if (iWord == firstWord)
+      word &= ~OccupancyWord_t(0) << (first % OccupancyWordBits);
+    if (iWord == lastWord) {
+      word &= ~OccupancyWord_t(0)
+        >> (OccupancyWordBits - 1 - (last % OccupancyWordBits));
+    }
+    if (word == 0) continue;
+
+    CellIndex_t const superIndex
+      = iWord * OccupancyWordBits + details::lowestBitSet(word);
+    CellDimIndex_t const superCell
+      = cellID[lastDim] / SuperCellSide + CellDimIndex_t(superIndex - first);
+    return std::max(cellID[lastDim], superCell * CellDimIndex_t(SuperCellSide));
+  } // for words
+
+  return rowEnd;
+} // lar::example::SpacePartition<>::firstInOccupiedSuperCell()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <typename Op>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::forEachOccupiedNeighbor
+  (CellID_t const& cellID, unsigned int extent, Op op) const
+{
+  CellDimIndex_t const ext = extent; // convert into the right signedness
+
+  // the neighbourhood, clipped to the grid (both ends included)
+  CellID_t lower, upper;
+  for (std::size_t i = 0; i < Dims; ++i) {
+    lower[i] = std::max(cellID[i] - ext, CellDimIndex_t(0));
+    upper[i] = std::min(cellID[i] + ext, CellDimIndex_t(dimSizes[i]) - 1);
+  } // for
+
+  CellID_t rowStart = lower;
+  do {
+    CellID_t rowEnd = rowStart;
+    rowEnd[Dims - 1] = upper[Dims - 1];
+    forEachOccupied(indices.index(rowStart), indices.index(rowEnd), op);
+  } while (nextRow(rowStart, lower, upper));
+} // lar::example::SpacePartition<>::forEachOccupiedNeighbor()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <typename Op>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::forEachPointWithin
+  (Position_t const& position, Coord_t radius, Op op) const
+{
+  forEachPointWithinImpl
+    (position, radius, [&op](PointIter point, Coord_t){ op(point); });
+} // lar::example::SpacePartition<>::forEachPointWithin()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+size_t lar::example::SpacePartition<PointIter, Alloc, Dims>::nearestPoints
+  (Position_t const& position, size_t k, NearPoint_t* nearest) const
+{
+  if (k == 0) return 0;
+
+  //
+  // beyond the farthest corner of the volume there are no more points
+  //
+  Coord_t maxDistance2 = Coord_t(0);
+  Coord_t radius = dimRanges[0].cellSize;
+  for (std::size_t i = 0; i < Dims; ++i) {
+    Range_t const& range = dimRanges[i];
+    maxDistance2 += std::max(
+      (position[i] - range.lower) * (position[i] - range.lower),
+      (position[i] - range.upper) * (position[i] - range.upper)
+      );
+    radius = std::min(radius, range.cellSize);
+  } // for
+
+  //
+  // all the points within the radius are closer than the ones outside it:
+  // if there are at least k of them, the closest k are among them
+  //
+  while (true) {
+    size_t nFound = 0;
+    forEachPointWithinImpl(position, radius,
+      [k, nearest, &nFound](PointIter point, Coord_t distance2)
+        {
+          if ((nFound == k) && !(distance2 < nearest[k - 1].distance2))
+            return;
+
+          // insertion into the sorted list, dropping the farthest if full
+          size_t i = (nFound < k)? nFound++: k - 1;
+          for (; (i > 0) && (distance2 < nearest[i - 1].distance2); --i)
+            nearest[i] = nearest[i - 1];
+          nearest[i] = { point, distance2 };
+        }
+      );
+    if ((nFound == k) || (radius * radius >= maxDistance2)) return nFound;
+    radius *= 2;
+  } // while
+} // lar::example::SpacePartition<>::nearestPoints()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <typename Op>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::forEachPointWithinImpl
+  (Position_t const& position, Coord_t radius, Op op) const
+{
+  if (!(radius >= Coord_t(0))) return;
+  Coord_t const radius2 = radius * radius;
+
+  //
+  // the block of cells including the sphere, clipped to the grid
+  //
+  CellID_t lower, upper;
+  for (std::size_t i = 0; i < Dims; ++i) {
+    Coord_t const first = cellOnDim(i, position[i] - radius);
+    Coord_t const last = cellOnDim(i, position[i] + radius);
+    Coord_t const lastCell = Coord_t(dimSizes[i]) - 1;
+    if ((last < Coord_t(0)) || (first > lastCell)) return; // outside the grid
+    lower[i] = CellDimIndex_t(std::max(first, Coord_t(0)));
+    upper[i] = CellDimIndex_t(std::min(last, lastCell));
+  } // for
+
+  constexpr std::size_t RowDim = Dims - 1; // the dimension along the rows
+  Coord_t const lastCell = Coord_t(dimSizes[RowDim]) - 1;
+
+  CellID_t rowStart = lower;
+  do {
+    // distance of the row from the position, on the dimensions across it
+    Coord_t rowDistance2 = Coord_t(0);
+    for (std::size_t i = 0; i < RowDim; ++i) {
+      Coord_t const d = distanceFromCellOnDim(i, rowStart[i], position[i]);
+      rowDistance2 += d * d;
+    } // for
+    if (rowDistance2 > radius2) continue;
+
+    // along the row, only the cells within the remaining radius
+    Coord_t const halfLength = std::sqrt(radius2 - rowDistance2);
+    Coord_t const first = std::max
+      (cellOnDim(RowDim, position[RowDim] - halfLength), Coord_t(0));
+    Coord_t const last = std::min
+      (cellOnDim(RowDim, position[RowDim] + halfLength), lastCell);
+    if (first > last) continue;
+
+    CellID_t cellID = rowStart;
+    cellID[RowDim] = CellDimIndex_t(first);
+    CellIndex_t const firstIndex = indices.index(cellID);
+    cellID[RowDim] = CellDimIndex_t(last);
+    forEachOccupied(firstIndex, indices.index(cellID),
+      [this, &position, radius2, &op](CellIndex_t index)
+        {
+          for (PointIter point: data[index]) {
+            Coord_t const distance2 = distance2From
+              (position, *point, std::make_index_sequence<Dims>());
+            if (distance2 <= radius2) op(point, distance2);
+          } // for
+        }
+      );
+  } while (nextRow(rowStart, lower, upper));
+
+} // lar::example::SpacePartition<>::forEachPointWithinImpl()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::distanceFromCellOnDim
+  (unsigned int dim, CellDimIndex_t cell, Coord_t c) const -> Coord_t
+{
+  Range_t const& range = dimRanges[dim];
+  Coord_t const cellLower = range.lower + cell * range.cellSize;
+  if (c < cellLower) return cellLower - c;
+  Coord_t const cellUpper = cellLower + range.cellSize;
+  return (c > cellUpper)? c - cellUpper: Coord_t(0);
+} // lar::example::SpacePartition<>::distanceFromCellOnDim()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+bool lar::example::SpacePartition<PointIter, Alloc, Dims>::nextRow
+  (CellID_t& rowStart, CellID_t const& lower, CellID_t const& upper)
+{
+  // the last dimension is the one along the rows, and it is not changed
+  for (std::size_t i = Dims - 1; i-- > 0;) {
+    if (++rowStart[i] <= upper[i]) return true;
+    rowStart[i] = lower[i];
+  } // for
+  return false;
+} // lar::example::SpacePartition<>::nextRow()
+
 
-  Coord_t const z = details::extractPositionZ(point);
-  CellDimIndex_t const zc = zRange.findCell(z);
-  if (!data.hasZ(zc)) {
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <std::size_t... Dim>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::distance2From(
+  Position_t const& position, Point_t const& point,
+  std::index_sequence<Dim...>
+) -> Coord_t
+{
+  return ((
+    (position[Dim] - Coord_t(details::extractPosition<Dim>(point)))
+    * (position[Dim] - Coord_t(details::extractPosition<Dim>(point)))
+    ) + ...);
+} // lar::example::SpacePartition<>::distance2From()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::superCellIndex
+  (CellID_t const& cellID) const -> CellIndex_t
+{
+  CellID_t superCellID;
+  for (std::size_t i = 0; i < Dims; ++i)
+    superCellID[i] = cellID[i] / SuperCellSide;
+  return superIndices.index(superCellID);
+} // lar::example::SpacePartition<>::superCellIndex()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::setOccupied
+  (CellID_t const& cellID, CellIndex_t index)
+{
+  occupancy[index / OccupancyWordBits]
+    |= OccupancyWord_t(1) << (index % OccupancyWordBits);
+  CellIndex_t const superIndex = superCellIndex(cellID);
+  superOccupancy[superIndex / OccupancyWordBits]
+    |= OccupancyWord_t(1) << (superIndex % OccupancyWordBits);
+} // lar::example::SpacePartition<>::setOccupied()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <std::size_t... Dim>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::extendBox(
+  CellIndex_t index, Point_t const& point, std::index_sequence<Dim...>
+) {
+  CellBox_t& box = boxes[index];
+  Coord_t const coords[Dims]
+    = { Coord_t(details::extractPosition<Dim>(point))... };
+  for (std::size_t i = 0; i < Dims; ++i) {
+    if (coords[i] < box[i].lower) box[i].lower = coords[i];
+    if (coords[i] > box[i].upper) box[i].upper = coords[i];
+  } // for
+} // lar::example::SpacePartition<>::extendBox()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::superCellDims
+  (std::array<size_t, Dims> const& cellDims) -> std::array<size_t, Dims>
+{
+  std::array<size_t, Dims> superDims;
+  for (std::size_t i = 0; i < Dims; ++i)
+    superDims[i] = (cellDims[i] + SuperCellSide - 1) / SuperCellSide;
+  return superDims;
+} // lar::example::SpacePartition<>::superCellDims()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::enableQuantization
+  (Coord_t quantum) -> Coord_t
+{
+  Coord_t const cellSide = dimRanges[0].cellSize;
+  for (Range_t const& range: dimRanges) {
+    if (range.cellSize == cellSide) continue;
     throw std::runtime_error
-      ("Point out of the volume (z = " + std::to_string(z) + ")");
-  }
+      ("Quantised positions are supported only with cubic cells");
+  } // for
+
+  int const nQuanta = (quantum > Coord_t(0))
+    ? int(std::min(Coord_t(MaxCellQuanta), std::floor(cellSide / quantum)))
+    : MaxCellQuanta;
+
+  nCellQuanta = std::max(nQuanta, 1);
+  quantumSize = cellSide / nCellQuanta;
+  quantizedData.assign
+    (indices.size(), QuantizedCell_t(quantizedData.get_allocator()));
+  return quantumSize;
+} // lar::example::SpacePartition<>::enableQuantization()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+void lar::example::SpacePartition<PointIter, Alloc, Dims>::enableBoundingBoxes()
+  { boxes.assign(indices.size(), emptyCellBox()); }
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::emptyCellBox()
+  -> CellBox_t
+{
+  // the empty box has inverted boundaries, so that any point extends it
+  CoordRange<Coord_t> const emptyRange{
+    std::numeric_limits<Coord_t>::max(), std::numeric_limits<Coord_t>::lowest()
+    };
+  CellBox_t emptyBox;
+  emptyBox.fill(emptyRange);
+  return emptyBox;
+} // lar::example::SpacePartition<>::emptyCellBox()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <std::size_t... Dim>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::quantizePosition(
+  Point_t const& point, CellID_t const& cellID, std::index_sequence<Dim...>
+) const -> QuantizedPosition_t
+{
+  return {{
+    quantizeCoordinate
+      (dimRanges[Dim], details::extractPosition<Dim>(point), cellID[Dim])...
+    }};
+} // lar::example::SpacePartition<>::quantizePosition()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::quantizeCoordinate
+  (Range_t const& range, Coord_t c, CellDimIndex_t cell) const -> std::int16_t
+{
+  // rounding may bring the coordinate just outside its own cell: clamp it
+  Coord_t const cellOffset = range.offset(c) - cell * range.cellSize;
+  int const q = int(std::floor(cellOffset / quantumSize));
+  return std::int16_t(std::min(std::max(q, 0), nCellQuanta - 1));
+} // lar::example::SpacePartition<>::quantizeCoordinate()
 
-  // return its index
-  return data.index(CellID_t{{ xc, yc, zc }});
 
-} // lar::example::SpacePartition<>::pointIndex()
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+typename lar::example::SpacePartition<PointIter, Alloc, Dims>::CellID_t
+lar::example::SpacePartition<PointIter, Alloc, Dims>::pointCellID
+  (Point_t const& point) const
+{
+  // compute the cell ID coordinates
+  return pointCellIDimpl(point, std::make_index_sequence<Dims>());
+
+} // lar::example::SpacePartition<>::pointCellID()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+template <std::size_t... Dim>
+typename lar::example::SpacePartition<PointIter, Alloc, Dims>::CellID_t
+lar::example::SpacePartition<PointIter, Alloc, Dims>::pointCellIDimpl
+  (Point_t const& point, std::index_sequence<Dim...>) const
+{
+  return {{ findCellOnDim(Dim, details::extractPosition<Dim>(point))... }};
+} // lar::example::SpacePartition<>::pointCellIDimpl()
+
+
+//--------------------------------------------------------------------------
+template <typename PointIter, typename Alloc, unsigned int Dims>
+auto lar::example::SpacePartition<PointIter, Alloc, Dims>::findCellOnDim
+  (unsigned int dim, Coord_t c) const -> CellDimIndex_t
+{
+  CellDimIndex_t const cell = dimRanges[dim].findCell(c);
+  if ((cell < 0) || (cell >= (CellDimIndex_t) dimSizes[dim])) {
+    throw std::runtime_error(
+      std::string("Point out of the volume (") + "xyz"[dim]
+      + " = " + std::to_string(c) + ")"
+      );
+  }
+  return cell;
+} // lar::example::SpacePartition<>::findCellOnDim()
 
 
 //--------------------------------------------------------------------------
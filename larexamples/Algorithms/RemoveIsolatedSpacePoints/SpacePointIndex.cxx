@@ -0,0 +1,94 @@
+/**
+ * @file   SpacePointIndex.cxx
+ * @brief  Spatial index of a collection of space points
+ * @see    SpacePointIndex.h
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ */
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndex.h"
+#include "larcorealg/Geometry/GeometryCore.h"
+
+// C/C++ standard libraries
+#include <stdexcept> // std::runtime_error
+#include <string> // std::to_string()
+
+
+//------------------------------------------------------------------------------
+//--- lar::example::SpacePointIndex
+//---
+lar::example::SpacePointIndex::SpacePointIndex(
+  SpacePoints_t const& points,
+  geo::BoxBoundedGeo const& volume,
+  Coord_t cellSize,
+  Coord_t quantum /* = 0 */,
+  std::size_t maxMemory /* = 0 */
+)
+  : spacePoints(&points)
+  , cells(checkMemory(makeRanges(volume, cellSize), quantum, maxMemory))
+{
+  if (quantum > Coord_t(0)) cells.enableQuantization(quantum);
+  cells.fill(begin(), end());
+} // lar::example::SpacePointIndex::SpacePointIndex()
+
+
+//------------------------------------------------------------------------------
+geo::BoxBoundedGeo lar::example::SpacePointIndex::detectorVolume
+  (geo::GeometryCore const& geom)
+{
+  // merge the volumes from all TPCs
+  auto iTPC = geom.begin_TPC(), tpcend = geom.end_TPC();
+
+  // a TPC is (also) a bounded box:
+  geo::BoxBoundedGeo box = (geo::BoxBoundedGeo) *iTPC;
+
+  while (++iTPC != tpcend) box.ExtendToInclude(*iTPC);
+
+  return box;
+} // lar::example::SpacePointIndex::detectorVolume()
+
+
+//------------------------------------------------------------------------------
+auto lar::example::SpacePointIndex::makeRanges
+  (geo::BoxBoundedGeo const& volume, Coord_t cellSize) -> Partition_t::Ranges_t
+{
+  if (cellSize <= Coord_t(0)) {
+    throw std::runtime_error("SpacePointIndex: cell size ("
+      + std::to_string(cellSize) + " cm) must be positive");
+  }
+  using Range_t = Partition_t::Range_t;
+  return {{
+    Range_t{ volume.MinX(), volume.MaxX(), cellSize },
+    Range_t{ volume.MinY(), volume.MaxY(), cellSize },
+    Range_t{ volume.MinZ(), volume.MaxZ(), cellSize }
+    }};
+} // lar::example::SpacePointIndex::makeRanges()
+
+
+//------------------------------------------------------------------------------
+auto lar::example::SpacePointIndex::checkMemory(
+  Partition_t::Ranges_t const& ranges,
+  Coord_t quantum, std::size_t maxMemory
+) -> Partition_t::Ranges_t
+{
+  if (maxMemory == 0) return ranges;
+
+  std::size_t nCells = 1;
+  for (std::size_t n: details::diceVolume(ranges)) nCells *= n;
+
+  std::size_t const cellMemory = sizeof(Partition_t::Cell_t)
+    + ((quantum > Coord_t(0))? sizeof(Partition_t::QuantizedCell_t): 0);
+
+  // the check is written so that it does not overflow
+  if (nCells > maxMemory / cellMemory) {
+    throw std::runtime_error("SpacePointIndex: "
+      + std::to_string(nCells) + " cells of "
+      + std::to_string(ranges[0].cellSize) + " cm would take more than "
+      + std::to_string(maxMemory) + " bytes; use larger cells");
+  }
+  return ranges;
+} // lar::example::SpacePointIndex::checkMemory()
+
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,133 @@
+/**
+ * @file   SpacePointIndex.h
+ * @brief  Spatial index of a collection of space points
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * Provides:
+ *
+ * * `lar::example::SpacePointIndex` class
+ *
+ */
+
+#ifndef LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTINDEX_H
+#define LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTINDEX_H
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIsolationAlg.h" // PositionExtractor
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePartition.h"
+#include "lardataobj/RecoBase/SpacePoint.h"
+#include "larcorealg/Geometry/BoxBoundedGeo.h"
+
+// C/C++ standard libraries
+#include <vector>
+#include <cstddef> // std::size_t
+
+
+// forward declarations
+namespace geo { class GeometryCore; }
+
+
+namespace lar {
+  namespace example {
+
+    // BEGIN RemoveIsolatedSpacePoints group -----------------------------------
+    /// @ingroup RemoveIsolatedSpacePoints
+    /// @{
+    /**
+     * @brief A collection of space points sorted into a `SpacePartition`
+     * @see SpacePointIndexService
+     *
+     * The index is built once from a collection of space points, and can then
+     * be used by many algorithms, so that each of them does not need to build
+     * its own partition.
+     * For example, `SpacePointIsolationAlg::removeIsolatedPoints()` accepts an
+     * index as input.
+     *
+     * The index refers to the original space points, which must outlive it.
+     * In _art_, the typical life time of an index is a single event:
+     * `SpacePointIndexService` takes care of it.
+     *
+     * The cell size should be tuned on the algorithms using the index.
+     * For `PointIsolationAlg`, a cell size equal to its
+     * `maximumOptimalCellSize()` (about 58% of the isolation radius) is a good
+     * choice; smaller cells still give the correct answer, but require more
+     * memory and the inspection of more cells.
+     */
+    class SpacePointIndex {
+
+        public:
+      /// Type of the indexed collection
+      using SpacePoints_t = std::vector<recob::SpacePoint>;
+
+      /// Type of iterator to the indexed points
+      using PointIter_t = SpacePoints_t::const_iterator;
+
+      /// Type of the partition
+      using Partition_t = SpacePartition<PointIter_t>;
+
+      /// Type of the coordinate
+      using Coord_t = Partition_t::Coord_t;
+
+      /**
+       * @brief Constructor: indexes all the points
+       * @param points the space points to be indexed
+       * @param volume the volume containing all the space points
+       * @param cellSize the size of the cells of the partition [cm]
+       * @param quantum precision of the compact positions [cm] (`0`: none)
+       * @param maxMemory largest size of the cell table [bytes] (`0`: any)
+       * @throw std::runtime_error if a point is outside `volume`
+       * @throw std::runtime_error if `cellSize` is not positive
+       * @throw std::runtime_error if the cell table would exceed `maxMemory`
+       * @see SpacePartition::enableQuantization()
+       *
+       * The size of the cell table is checked before it is allocated, and it
+       * does not include the memory for the indexed points themselves.
+       */
+      SpacePointIndex(
+        SpacePoints_t const& points,
+        geo::BoxBoundedGeo const& volume,
+        Coord_t cellSize,
+        Coord_t quantum = Coord_t(0),
+        std::size_t maxMemory = 0
+        );
+
+      /// Returns the indexed space points
+      SpacePoints_t const& points() const { return *spacePoints; }
+
+      /// Returns an iterator to the first indexed point
+      PointIter_t begin() const { return points().begin(); }
+
+      /// Returns an iterator after the last indexed point
+      PointIter_t end() const { return points().end(); }
+
+      /// Returns the partition of the space points
+      Partition_t const& partition() const { return cells; }
+
+
+      /// Returns the box including all the TPCs in the geometry
+      static geo::BoxBoundedGeo detectorVolume(geo::GeometryCore const& geom);
+
+        private:
+      SpacePoints_t const* spacePoints; ///< the indexed points
+      Partition_t cells; ///< partition of the space points
+
+      /// Returns the ranges of the partition covering `volume`
+      static Partition_t::Ranges_t makeRanges
+        (geo::BoxBoundedGeo const& volume, Coord_t cellSize);
+
+      /// Returns `ranges` if their cell table fits in `maxMemory`, or throws
+      static Partition_t::Ranges_t checkMemory(
+        Partition_t::Ranges_t const& ranges,
+        Coord_t quantum, std::size_t maxMemory
+        );
+
+    }; // class SpacePointIndex
+
+    /// @}
+    // END RemoveIsolatedSpacePoints group -------------------------------------
+
+  } // namespace example
+} // namespace lar
+
+
+#endif // LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTINDEX_H
@@ -0,0 +1,173 @@
+/**
+ * @file   SpacePointIndexService.h
+ * @brief  Service sharing spatial indices of space points within an event
+ * @see    SpacePointIndex.h
+ * @ingroup RemoveIsolatedSpacePoints
+ */
+
+#ifndef LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTINDEXSERVICE_H
+#define LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTINDEXSERVICE_H
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndex.h"
+
+// framework libraries
+#include "art/Framework/Services/Registry/ServiceTable.h"
+#include "art/Framework/Services/Registry/ServiceMacros.h" // (for includers)
+#include "art/Framework/Principal/fwd.h" // art::Event
+#include "art/Utilities/ScheduleID.h" // art::ScheduleContext
+#include "canvas/Persistency/Provenance/EventID.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+// C/C++ standard libraries
+#include <map>
+#include <string>
+#include <utility> // std::pair<>
+#include <memory> // std::unique_ptr<>
+#include <mutex>
+#include <cstddef> // std::size_t
+
+
+namespace art { class ActivityRegistry; }
+
+
+namespace lar {
+  namespace example {
+
+    // BEGIN RemoveIsolatedSpacePoints group -----------------------------------
+    /// @ingroup RemoveIsolatedSpacePoints
+    /// @{
+    /**
+     * @brief _art_ service: spatial indices of space points, shared in an event
+     * @see SpacePointIndex
+     *
+     * Many modules may need a spatial index of the same space point
+     * collection: with this service, the index is built the first time it is
+     * requested in an event, and the following requests get the same index.
+     * The indices of an event are discarded at the end of that event.
+     *
+     * Example of use in a module `produce()`:
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     *     art::ServiceHandle<lar::example::SpacePointIndexService> indexSrv;
+     *     lar::example::SpacePointIndex const& index
+     *       = indexSrv->index(event, spacePointLabel);
+     *
+     *     std::vector<size_t> nonIsolated = isolAlg.removeIsolatedPoints(index);
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     *
+     * The indices cover the volume of all the TPCs in the geometry.
+     * All indices share the same cell size, which should be chosen according
+     * to the algorithms using them (see `SpacePointIndex`).
+     *
+     * This is a shared service: the indices are kept separately for each
+     * event, so that events processed at the same time (in different
+     * schedules) never see each other's indices, and the index of an event
+     * stays valid until that event is over. The requests are served one at
+     * a time, and an index is built while holding the lock, so that it is
+     * built only once even if requested by modules running concurrently.
+     *
+     *
+     * Configuration parameters
+     * -------------------------
+     *
+     * * *cellSize* (real, _mandatory_): size of the cells of the index [cm]
+     * * *quantum* (real, default: `0`): if positive, the indices also store
+     *   compact positions with this precision [cm]
+     * * *maxMemory* (integer, default: 1 GiB): largest memory allowed for the
+     *   cell table of each index [bytes]; an index requiring more is not
+     *   built, and an exception is thrown instead (`0`: no limit)
+     *
+     */
+    class SpacePointIndexService {
+
+        public:
+      /// Service configuration
+      struct Config {
+
+        using Name = fhicl::Name;
+        using Comment = fhicl::Comment;
+
+        fhicl::Atom<double> cellSize{
+          Name("cellSize"),
+          Comment("size of the cells of the index [cm]")
+        };
+
+        fhicl::Atom<double> quantum{
+          Name("quantum"),
+          Comment("precision of compact cell coordinates [cm] (0: not used)"),
+          0.0
+        };
+
+        fhicl::Atom<std::size_t> maxMemory{
+          Name("maxMemory"),
+          Comment("largest cell table of an index [bytes] (0: no limit)"),
+          std::size_t(1024) * 1048576
+        };
+
+      }; // Config
+
+      /// Type of configuration parameter (for art description)
+      using Parameters = art::ServiceTable<Config>;
+
+
+      /// Constructor (using a configuration table)
+      SpacePointIndexService
+        (Parameters const& config, art::ActivityRegistry& reg);
+
+
+      /**
+       * @brief Returns the index of the specified space points in the event
+       * @param event the event to read space points from
+       * @param tag the input tag of the `std::vector<recob::SpacePoint>`
+       * @return the index of the space points from `tag` in `event`
+       * @throw art::Exception if the space points are not available
+       * @throw cet::exception (category: `SpacePointIndexService`) if the
+       *        cached index was built from a different data product
+       *
+       * The index is built on the first request in each event.
+       * The returned index is valid until the end of `event`.
+       */
+      SpacePointIndex const& index
+        (art::Event const& event, art::InputTag const& tag);
+
+      /// Returns the size of the cells of the indices [cm]
+      double cellSize() const { return fCellSize; }
+
+
+        private:
+      double fCellSize; ///< size of the cells [cm]
+      double fQuantum; ///< precision of compact positions [cm]
+      std::size_t fMaxMemory; ///< largest cell table of an index [bytes]
+
+      /// An index, with the ID of the data product it was built from
+      struct CachedIndex_t {
+        art::ProductID productID; ///< ID of the indexed data product
+        std::unique_ptr<SpacePointIndex> index; ///< the index
+      }; // CachedIndex_t
+
+      /// Key of the cache: event and encoded input tag
+      using CacheKey_t = std::pair<art::EventID, std::string>;
+
+      /// Indices built in the events being processed
+      std::map<CacheKey_t, CachedIndex_t> indices;
+
+      std::mutex cacheMutex; ///< protects `indices`
+
+      /// Discards the indices of `event` (called at the end of each event)
+      void clear(art::Event const& event, art::ScheduleContext);
+
+    }; // class SpacePointIndexService
+
+    /// @}
+    // END RemoveIsolatedSpacePoints group -------------------------------------
+
+  } // namespace example
+} // namespace lar
+
+
+DECLARE_ART_SERVICE(lar::example::SpacePointIndexService, SHARED)
+
+
+#endif // LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTINDEXSERVICE_H
@@ -0,0 +1,99 @@
+/**
+ * @file   SpacePointIndexService_service.cc
+ * @brief  Service sharing spatial indices of space points within an event
+ * @see    SpacePointIndexService.h
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ */
+
+// our header
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndexService.h"
+
+// LArSoft libraries
+#include "larcore/Geometry/Geometry.h"
+#include "larcore/CoreUtils/ServiceUtil.h" // lar::providerFrom()
+#include "lardataobj/RecoBase/SpacePoint.h"
+
+// framework libraries
+#include "art/Framework/Services/Registry/ActivityRegistry.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h" // art::ValidHandle
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <vector>
+#include <string>
+#include <memory> // std::make_unique()
+#include <mutex>
+
+
+//------------------------------------------------------------------------------
+//--- lar::example::SpacePointIndexService
+//---
+lar::example::SpacePointIndexService::SpacePointIndexService
+  (Parameters const& config, art::ActivityRegistry& reg)
+  : fCellSize(config().cellSize())
+  , fQuantum(config().quantum())
+  , fMaxMemory(config().maxMemory())
+{
+  if (fCellSize <= 0.0) {
+    throw cet::exception("SpacePointIndexService")
+      << "The cell size (" << config().cellSize.name() << ": " << fCellSize
+      << ") must be positive\n";
+  }
+  if (fQuantum < 0.0) {
+    throw cet::exception("SpacePointIndexService")
+      << "The quantum (" << config().quantum.name() << ": " << fQuantum
+      << ") can't be negative\n";
+  }
+
+  reg.sPostProcessEvent.watch(this, &SpacePointIndexService::clear);
+} // lar::example::SpacePointIndexService::SpacePointIndexService()
+
+
+//------------------------------------------------------------------------------
+lar::example::SpacePointIndex const& lar::example::SpacePointIndexService::index
+  (art::Event const& event, art::InputTag const& tag)
+{
+  auto const handle = event.getValidHandle<std::vector<recob::SpacePoint>>(tag);
+
+  std::lock_guard<std::mutex> const lock(cacheMutex);
+
+  CachedIndex_t& cached = indices[{ event.id(), tag.encode() }];
+  if (!cached.index) {
+    auto const* geom = lar::providerFrom<geo::Geometry>();
+    cached.index = std::make_unique<SpacePointIndex>(
+      *handle, SpacePointIndex::detectorVolume(*geom),
+      fCellSize, fQuantum, fMaxMemory
+      );
+    cached.productID = handle.id();
+  } // if new index
+  else if (cached.productID != handle.id()) {
+    throw cet::exception("SpacePointIndexService")
+      << "The index of '" << tag.encode() << "' in " << event.id()
+      << " was built from data product " << cached.productID
+      << ", but " << handle.id() << " was requested\n";
+  }
+  return *(cached.index);
+} // lar::example::SpacePointIndexService::index()
+
+
+//------------------------------------------------------------------------------
+void lar::example::SpacePointIndexService::clear
+  (art::Event const& event, art::ScheduleContext)
+{
+  std::lock_guard<std::mutex> const lock(cacheMutex);
+
+  // the indices of the event are sorted together, from the empty tag on
+  art::EventID const eventID = event.id();
+  auto iIndex = indices.lower_bound({ eventID, std::string() });
+  while ((iIndex != indices.end()) && (iIndex->first.first == eventID))
+    iIndex = indices.erase(iIndex);
+} // lar::example::SpacePointIndexService::clear()
+
+
+//------------------------------------------------------------------------------
+DEFINE_ART_SERVICE(lar::example::SpacePointIndexService)
+
+
+//------------------------------------------------------------------------------
@@ -10,7 +10,7 @@
 
 // LArSoft libraries
 #include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIsolationAlg.h"
-#include "larcorealg/Geometry/GeometryCore.h"
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndex.h"
 
 // infrastructure and utilities
 #include "cetlib_except/exception.h"
@@ -18,6 +18,15 @@
 // C/C++ standard libraries
 #include <stdexcept> // std::runtime_error()
 #include <memory> // std::make_unique()
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+//--- precompiled instantiations (declared in SpacePointIsolationAlg.h)
+//---
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(,
+  lar::example::SpacePointIsolationAlg::Coord_t,
+  std::vector<recob::SpacePoint>::const_iterator);
 
 
 //------------------------------------------------------------------------------
@@ -25,11 +34,41 @@
 //---
 
 
+void lar::example::SpacePointIsolationAlg::setup
+  (geo::GeometryCore const& geometry)
+{
+  geom = &geometry;
+
+  //
+  // the settings depend on the geometry only through the volume it covers:
+  // if that did not change, they are still valid
+  //
+  if (state) {
+    PointIsolationAlg_t::Configuration_t config;
+    fillAlgConfigFromGeometry(config);
+    PointIsolationAlg_t::Configuration_t const& current
+      = state->isolationAlg.configuration();
+    if ((config.rangeX == current.rangeX) && (config.rangeY == current.rangeY)
+      && (config.rangeZ == current.rangeZ))
+    {
+      return;
+    }
+  } // if already set up
+
+  initialize();
+
+} // lar::example::SpacePointIsolationAlg::setup()
+
+
 void lar::example::SpacePointIsolationAlg::initialize() {
 
   PointIsolationAlg_t::Configuration_t config;
 
   config.radius2 = radius2; // square of isolation radius [cm^2]
+  config.tileSize = tileSize;
+  config.quantum = quantum;
+  config.cellBoxes = cellBoxes;
+  config.approximation = approximation;
   fillAlgConfigFromGeometry(config);
 
   // proceed to validate the configuration we are going to use
@@ -41,22 +80,39 @@ void lar::example::SpacePointIsolationAlg::initialize() {
       << "Error in PointIsolationAlg configuration: " << e.what() << "\n";
   }
 
-  if (isolationAlg) isolationAlg->reconfigure(config);
-  else isolationAlg = std::make_unique<PointIsolationAlg_t>(config);
+  // a new state is built rather than the current one being modified,
+  // so that once built it never changes
+  auto newState = std::make_unique<SetupState_t>
+    (SetupState_t{ PointIsolationAlg_t(config), {} });
+
+  // partition settings for the standard input (vector of space points)
+  newState->layout = newState->isolationAlg.preparePartitionLayout
+    <std::vector<recob::SpacePoint>::const_iterator>();
+
+  state = std::move(newState);
 
 } // lar::example::SpacePointIsolationAlg::initialize()
 
 
-void lar::example::SpacePointIsolationAlg::fillAlgConfigFromGeometry
-  (PointIsolationAlg_t::Configuration_t& config)
+std::vector<size_t> lar::example::SpacePointIsolationAlg::removeIsolatedPoints
+  (SpacePointIndex const& index) const
 {
-  // merge the volumes from all TPCs
-  auto iTPC = geom->begin_TPC(), tpcend = geom->end_TPC();
+  if (errorScale <= Coord_t(0))
+    return state->isolationAlg.removeIsolatedPoints
+      (index.partition(), index.begin());
 
-  // a TPC is (also) a bounded box:
-  geo::BoxBoundedGeo box = (geo::BoxBoundedGeo) *iTPC;
+  return state->isolationAlg.removeIsolatedPointsWithRadii(
+    index.partition(), index.begin(), index.end(),
+    [this](recob::SpacePoint const& point){ return pointRadius(point); }
+    );
+} // lar::example::SpacePointIsolationAlg::removeIsolatedPoints(SpacePointIndex)
 
-  while (++iTPC != tpcend) box.ExtendToInclude(*iTPC);
+
+void lar::example::SpacePointIsolationAlg::fillAlgConfigFromGeometry
+  (PointIsolationAlg_t::Configuration_t& config) const
+{
+  // merge the volumes from all TPCs
+  geo::BoxBoundedGeo const box = SpacePointIndex::detectorVolume(*geom);
 
   // convert the box into the configuration structure
   config.rangeX = { box.MinX(), box.MaxX() };
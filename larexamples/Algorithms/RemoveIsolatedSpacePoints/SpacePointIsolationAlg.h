@@ -28,6 +28,8 @@
 #include <vector>
 #include <type_traits> // std::decay_t<>, std::is_base_of<>
 #include <memory> // std::unique_ptr<>
+#include <cmath> // std::sqrt()
+#include <stdexcept> // std::runtime_error
 
 
 // forward declarations
@@ -37,6 +39,8 @@ namespace geo { class GeometryCore; }
 namespace lar {
   namespace example {
 
+    class SpacePointIndex; // from SpacePointIndex.h
+
     // BEGIN RemoveIsolatedSpacePoints group -----------------------------------
     /// @ingroup RemoveIsolatedSpacePoints
     /// @{
@@ -74,8 +78,9 @@ namespace lar {
      *     lar::examples::SpacePointIsolationAlg algo(config);
      *
      *     // set up
-     *     // (might be needed again if geometry changed, e.g. between runs)
-     *     algo.Setup(*geom);
+     *     // (needed again if geometry changed, e.g. between runs; in art,
+     *     // in `beginRun()`)
+     *     algo.setup(*geom);
      *
      *     // execution
      *     std::vector<size_t> nonIsolatedPointIndices
@@ -95,10 +100,42 @@ namespace lar {
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
      *
      *
+     * Thread safety
+     * --------------
+     *
+     * All the settings derived from the configuration and the geometry are
+     * built by `setup()` in a single object which is not modified afterwards
+     * (a new one replaces it on the next set up that changes them).
+     * The execution methods (`removeIsolatedPoints()`,
+     * `countIsolatedPoints()`) are `const` and keep all their working data on
+     * their own stack, so that they can be called concurrently from different
+     * threads, e.g. on different events.
+     * `setup()` must not be called concurrently with them: in _art_, it is
+     * called at the beginning of the run, when no event is being processed.
+     *
+     *
      * Configuration parameters
      * =========================
      *
      * * *radius* (real, mandatory): isolation radius [cm]
+     * * *tileSize* (integer, default: `0`): visit the cells in cubic blocks
+     *   with this number of cells per side, for better cache reuse;
+     *   `0` visits the cells in their natural order
+     * * *quantum* (real, default: `0`): if positive, distances are first
+     *   tested on compact integer coordinates with this precision [cm], and
+     *   recomputed exactly only when close to the isolation radius
+     * * *cellBoxes* (boolean, default: `false`): track the box containing the
+     *   points of each cell, and skip pairs of cells whose boxes are farther
+     *   than the isolation radius (uses more memory)
+     * * *approximation* (real, default: `0`): if positive, relative tolerance
+     *   on the isolation radius: points with a neighbour within the radius are
+     *   always kept, but points with their closest neighbour up to this
+     *   fraction beyond it may be kept too; faster (for online filtering)
+     * * *errorScale* (real, default: `0`): if positive, the isolation radius of
+     *   each space point is increased by this many times its position
+     *   uncertainty (square root of the trace of `ErrXYZ()`); pairs of points
+     *   are compared with the quadratic mean of their two radii (see
+     *   `PointIsolationAlg::removeIsolatedPointsWithRadii()`)
      *
      */
     class SpacePointIsolationAlg {
@@ -107,6 +144,9 @@ namespace lar {
       /// Type of coordinate in recob::SpacePoint (`double` in LArSoft 5)
       using Coord_t = std::decay_t<decltype(recob::SpacePoint().XYZ()[0])>;
 
+      /// Result of `countIsolatedPoints()`
+      using IsolationCount_t = PointIsolationAlg<Coord_t>::IsolationCount_t;
+
 
       /// Algorithm configuration
       struct Config {
@@ -119,6 +159,36 @@ namespace lar {
           Comment("the radius for the isolation [cm]")
         };
 
+        fhicl::Atom<unsigned int> tileSize{
+          Name("tileSize"),
+          Comment("cells per side of the traversal blocks (0: linear order)"),
+          0U
+        };
+
+        fhicl::Atom<double> quantum{
+          Name("quantum"),
+          Comment("precision of compact cell coordinates [cm] (0: not used)"),
+          0.0
+        };
+
+        fhicl::Atom<bool> cellBoxes{
+          Name("cellBoxes"),
+          Comment("skip cells whose points are all farther than the radius"),
+          false
+        };
+
+        fhicl::Atom<double> approximation{
+          Name("approximation"),
+          Comment("relative tolerance on the isolation radius (0: exact)"),
+          0.0
+        };
+
+        fhicl::Atom<double> errorScale{
+          Name("errorScale"),
+          Comment("radius increase per unit of position uncertainty (0: none)"),
+          0.0
+        };
+
       }; // Config
 
 
@@ -133,6 +203,11 @@ namespace lar {
        */
       SpacePointIsolationAlg(Config const& config)
         : radius2(cet::square(config.radius()))
+        , tileSize(config.tileSize())
+        , quantum(config.quantum())
+        , cellBoxes(config.cellBoxes())
+        , approximation(config.approximation())
+        , errorScale(config.errorScale())
         {}
 
       /**
@@ -158,11 +233,16 @@ namespace lar {
        * @brief Sets up the algorithm
        * @param geometry the geometry service provider
        *
-       * Acquires the geometry description.
-       * This method must be called every time the geometry is changed.
+       * Acquires the geometry description, and computes all the settings
+       * derived from it: the volume covered by the partition of the points,
+       * the size of its cells, the dimensions of its grid and the
+       * neighbourhood of a cell.
+       * This method must be called every time the geometry may have changed,
+       * typically at the beginning of each run. If the volume from the
+       * geometry is the same as in the previous call, the settings are kept
+       * and not computed again.
        */
-      void setup(geo::GeometryCore const& geometry)
-        { geom = &geometry; initialize(); }
+      void setup(geo::GeometryCore const& geometry);
 
       /// @}
 
@@ -186,7 +266,14 @@ namespace lar {
             std::is_base_of<recob::SpacePoint, std::decay_t<decltype(*begin)>>::value,
             "iterator does not point to recob::SpacePoint"
             );
-          return isolationAlg->removeIsolatedPoints(begin, end);
+          if (errorScale <= Coord_t(0)) {
+            return state->isolationAlg.removeIsolatedPoints
+              (state->layout, begin, end);
+          }
+          return state->isolationAlg.removeIsolatedPointsWithRadii
+            (begin, end, [this](recob::SpacePoint const& point)
+              { return pointRadius(point); }
+            );
         }
 
 
@@ -201,6 +288,55 @@ namespace lar {
         { return removeIsolatedPoints(points.begin(), points.end()); }
 
 
+      /**
+       * @brief Returns the set of indexed space points that are not isolated
+       * @param index spatial index of the space points
+       * @return a list of indices of non-isolated points in `index.points()`
+       * @see removeIsolatedPoints(PointIter, PointIter) const
+       *
+       * The points are taken from the index, together with their partition,
+       * which is not rebuilt. The volume covered by the index is not required
+       * to match the one from the geometry, but the quantum of this algorithm
+       * is ignored in favour of the one of the index.
+       */
+      std::vector<size_t> removeIsolatedPoints
+        (SpacePointIndex const& index) const;
+
+
+      /**
+       * @brief Counts the isolated space points in a sample, until told to stop
+       * @tparam IndexIter forward iterator to the indices of the sample
+       * @tparam Stop type of the stopping condition
+       * @param points list of the reconstructed space points
+       * @param first iterator to the index of the first point to be tested
+       * @param last iterator after the index of the last point to be tested
+       * @param stop condition to end the test early
+       * @return how many points were tested, and how many were isolated
+       * @throw std::runtime_error if the radius depends on the point
+       *        (`errorScale` configured)
+       * @see PointIsolationAlg::countIsolatedPoints()
+       *
+       * The points `points[index]` are tested in the order of the indices,
+       * against all the points in `points`, and after each of them
+       * `stop(count)` decides whether to go on (see
+       * `PointIsolationAlg::countIsolatedPoints()` for the details).
+       */
+      template <typename IndexIter, typename Stop>
+      IsolationCount_t countIsolatedPoints(
+        std::vector<recob::SpacePoint> const& points,
+        IndexIter first, IndexIter last,
+        Stop stop
+        ) const
+        {
+          if (errorScale > Coord_t(0)) {
+            throw std::runtime_error("SpacePointIsolationAlg:"
+              " isolated points can't be counted with per-point radii");
+          }
+          return state->isolationAlg.countIsolatedPoints
+            (state->layout, points.begin(), points.end(), first, last, stop);
+        }
+
+
 
         private:
       /// Type of isolation algorithm
@@ -210,16 +346,36 @@ namespace lar {
       geo::GeometryCore const* geom = nullptr;
 
       Coord_t radius2; ///< square of isolation radius [cm^2]
-
-      /// the actual generic algorithm
-      std::unique_ptr<PointIsolationAlg_t> isolationAlg;
+      unsigned int tileSize; ///< cells per side of traversal tiles
+      Coord_t quantum; ///< precision of compact coordinates [cm]
+      bool cellBoxes; ///< whether to track the bounding box of each cell
+      Coord_t approximation; ///< relative tolerance on the radius
+      Coord_t errorScale; ///< radius increase per unit of uncertainty
+
+      /// Settings from the configuration and the geometry, built by `setup()`
+      struct SetupState_t {
+        PointIsolationAlg_t isolationAlg; ///< the actual generic algorithm
+        /// settings of the partition for a vector of space points
+        PointIsolationAlg_t::PartitionLayout_t layout;
+      }; // SetupState_t
+
+      /// current settings (never modified, only replaced by `setup()`)
+      std::unique_ptr<SetupState_t const> state;
 
       /// Initialises the algorithm with the current configuration and setup
       void initialize();
 
+      /// Returns the isolation radius of the specified point [cm]
+      Coord_t pointRadius(recob::SpacePoint const& point) const
+        {
+          auto const* err = point.ErrXYZ(); // xx, xy, yy, xz, yz, zz
+          return std::sqrt(radius2)
+            + errorScale * std::sqrt(err[0] + err[2] + err[5]);
+        }
+
       /// Detects the boundaries of the volume to be sorted from the geometry
       void fillAlgConfigFromGeometry
-        (PointIsolationAlg_t::Configuration_t& config);
+        (PointIsolationAlg_t::Configuration_t& config) const;
 
     }; // class SpacePointIsolationAlg
 
@@ -253,7 +409,17 @@ namespace lar {
 } // namespace lar
 
 
+//------------------------------------------------------------------------------
+//--- precompiled instantiations (see PointIsolationAlg.h)
+//---
+#ifndef LAREXAMPLES_POINTISOLATIONALG_HEADERONLY
+
+// compiled in SpacePointIsolationAlg.cxx
+LAREXAMPLES_POINTISOLATIONALG_INSTANTIATE(extern,
+  lar::example::SpacePointIsolationAlg::Coord_t,
+  std::vector<recob::SpacePoint>::const_iterator);
 
+#endif // !LAREXAMPLES_POINTISOLATIONALG_HEADERONLY
 
 
 #endif // LAREXAMPLES_ALGORITHMS_REMOVEISOLATEDSPACEPOINTS_SPACEPOINTISOLATIONALG_H
@@ -9,18 +9,25 @@
 
 // LArSoft libraries
 #include "lardataobj/RecoBase/SpacePoint.h"
+#include "lardataobj/RecoBase/PFParticle.h"
+#include "lardataobj/RecoBase/Hit.h"
 
 // framework libraries
 #include "art/Framework/Core/EDAnalyzer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h" // art::ValidHandle
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Persistency/Common/Assns.h"
 #include "canvas/Utilities/InputTag.h"
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/OptionalAtom.h"
 #include "cetlib_except/exception.h"
 
 // C/C++ standard libraries
+#include <vector>
+#include <string>
+#include <algorithm> // std::count()
 
 
 namespace lar {
@@ -40,6 +47,14 @@ namespace lar {
      * collection, or indirectly as the requirement that the tested collection
      * has the same size as another one (still of `recob::SpacePoint`).
      *
+     * The collection can also be of pointers to `recob::SpacePoint`, or a
+     * mask (`std::vector<bool>`): in the latter case, its size is the number
+     * of elements set to `true`. Clustering output can also be checked, as a
+     * collection of `recob::PFParticle` or as their associations with space
+     * points, whose size is the number of associated pairs. The same holds
+     * for the associations of space points with hits. Finally, a collection
+     * of `recob::Hit` can be checked too.
+     *
      * Configuration parameters
      * =========================
      *
@@ -49,12 +64,24 @@ namespace lar {
      *   the collection
      * * *sameSizeAs* (inputTag): expected number of elements is the same as
      *   this other data product
+     * * *inputType* (string, default: `"spacePoints"`): type of the
+     *   collection: `"spacePoints"` (`std::vector<recob::SpacePoint>`),
+     *   `"pointers"` (`std::vector<art::Ptr<recob::SpacePoint>>`),
+     *   `"mask"` (`std::vector<bool>`), `"particles"`
+     *   (`std::vector<recob::PFParticle>`), `"particleAssns"`
+     *   (`art::Assns<recob::PFParticle, recob::SpacePoint>`), `"hitAssns"`
+     *   (`art::Assns<recob::SpacePoint, recob::Hit>`) or `"hits"`
+     *   (`std::vector<recob::Hit>`)
      *
      */
     class CheckDataProductSize: public art::EDAnalyzer {
 
       using Data_t = recob::SpacePoint;
       using OtherData_t = recob::SpacePoint;
+      using Particle_t = recob::PFParticle;
+      using ParticleAssns_t = art::Assns<Particle_t, Data_t>;
+      using Hit_t = recob::Hit;
+      using HitAssns_t = art::Assns<Data_t, Hit_t>;
 
         public:
 
@@ -78,6 +105,13 @@ namespace lar {
           Comment("label of a data product with the same size as the input")
           };
 
+        fhicl::Atom<std::string> inputType{
+          Name("inputType"),
+          Comment("type of data product (spacePoints, pointers, mask, "
+            "particles, particleAssns, hitAssns or hits)"),
+          "spacePoints"
+          };
+
       }; // Config
 
       using Parameters = art::EDAnalyzer::Table<Config>;
@@ -86,10 +120,28 @@ namespace lar {
       explicit CheckDataProductSize(Parameters const& config)
         : art::EDAnalyzer(config)
         , inputLabel(config().inputLabel())
+        , inputType(config().inputType())
         {
           doCheckExpectedSize = config().expectedSize(expectedSize);
           doCheckSameSize = config().sameSizeAs(sameSizeAs);
-          consumes<std::vector<Data_t>>(inputLabel);
+          if (inputType == "spacePoints")
+            consumes<std::vector<Data_t>>(inputLabel);
+          else if (inputType == "pointers")
+            consumes<std::vector<art::Ptr<Data_t>>>(inputLabel);
+          else if (inputType == "mask")
+            consumes<std::vector<bool>>(inputLabel);
+          else if (inputType == "particles")
+            consumes<std::vector<Particle_t>>(inputLabel);
+          else if (inputType == "particleAssns")
+            consumes<ParticleAssns_t>(inputLabel);
+          else if (inputType == "hitAssns")
+            consumes<HitAssns_t>(inputLabel);
+          else if (inputType == "hits")
+            consumes<std::vector<Hit_t>>(inputLabel);
+          else {
+            throw cet::exception("CheckDataProductSize")
+              << "Unsupported input type: '" << inputType << "'\n";
+          }
         }
 
       virtual void analyze(art::Event const& event) override;
@@ -97,6 +149,7 @@ namespace lar {
 
         private:
       art::InputTag inputLabel; ///< label of the input data product
+      std::string inputType; ///< type of the input data product
 
       bool doCheckExpectedSize; ///< check that the size is the specified one
       bool doCheckSameSize; ///< check that size is the same as another product
@@ -104,6 +157,9 @@ namespace lar {
       size_t expectedSize; ///< expected size of the data product collection
       art::InputTag sameSizeAs; ///< label of the data product with same size
 
+      /// Returns the size of the input data product
+      size_t inputSize(art::Event const& event) const;
+
     }; // class CheckDataProductSize
 
 
@@ -126,13 +182,13 @@ void lar::example::tests::CheckDataProductSize::analyze(art::Event const& event)
   //
   // read the input
   //
-  auto collectionHandle = event.getValidHandle<std::vector<Data_t>>(inputLabel);
+  size_t const size = inputSize(event);
 
   if (doCheckExpectedSize) {
-    if (collectionHandle->size() != expectedSize) {
+    if (size != expectedSize) {
       throw cet::exception("CheckDataProductSize")
         << "Data product '" << inputLabel.encode() << "' has "
-        << collectionHandle->size() << " elements, " << expectedSize
+        << size << " elements, " << expectedSize
         << " were expected!\n";
     }
   } // if doCheckExpectedSize
@@ -140,10 +196,10 @@ void lar::example::tests::CheckDataProductSize::analyze(art::Event const& event)
   if (doCheckSameSize) {
     auto otherCollectionHandle
       = event.getValidHandle<std::vector<OtherData_t>>(sameSizeAs);
-    if (collectionHandle->size() != otherCollectionHandle->size()) {
+    if (size != otherCollectionHandle->size()) {
       throw cet::exception("CheckDataProductSize")
         << "Data product '" << inputLabel.encode() << "' has "
-        << collectionHandle->size() << " elements, " << expectedSize
+        << size << " elements, " << otherCollectionHandle->size()
         << " were expected as in '" << sameSizeAs.encode() << "'!\n";
     }
   } // if doCheckSameSize
@@ -151,6 +207,30 @@ void lar::example::tests::CheckDataProductSize::analyze(art::Event const& event)
 } // lar::example::tests::CheckDataProductSize::analyze()
 
 
+//------------------------------------------------------------------------------
+size_t lar::example::tests::CheckDataProductSize::inputSize
+  (art::Event const& event) const
+{
+  if (inputType == "pointers") {
+    return event.getValidHandle<std::vector<art::Ptr<Data_t>>>(inputLabel)
+      ->size();
+  }
+  if (inputType == "mask") {
+    auto const& mask = *(event.getValidHandle<std::vector<bool>>(inputLabel));
+    return std::count(mask.begin(), mask.end(), true);
+  }
+  if (inputType == "particles")
+    return event.getValidHandle<std::vector<Particle_t>>(inputLabel)->size();
+  if (inputType == "particleAssns")
+    return event.getValidHandle<ParticleAssns_t>(inputLabel)->size();
+  if (inputType == "hitAssns")
+    return event.getValidHandle<HitAssns_t>(inputLabel)->size();
+  if (inputType == "hits")
+    return event.getValidHandle<std::vector<Hit_t>>(inputLabel)->size();
+  return event.getValidHandle<std::vector<Data_t>>(inputLabel)->size();
+} // lar::example::tests::CheckDataProductSize::inputSize()
+
+
 //------------------------------------------------------------------------------
 DEFINE_ART_MODULE(lar::example::tests::CheckDataProductSize)
 
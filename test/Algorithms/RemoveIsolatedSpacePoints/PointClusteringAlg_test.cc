@@ -0,0 +1,247 @@
+/**
+ * @file   PointClusteringAlg_test.cc
+ * @brief  Unit tests for PointClusteringAlg
+ * @see    PointClusteringAlg.h
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ * This test sets up point distributions with known clustering features,
+ * and compares the results of the algorithm with the expected ones, with the
+ * brute-force algorithm and with the isolation algorithm.
+ *
+ * The test is run with no arguments.
+ *
+ * Three tests are run:
+ *
+ * * `PointClusteringTest1`: low multiplicity unit test
+ * * `PointClusteringRandomTest`: random points, in 3D and 2D
+ * * `PointClusteringIsolationTest`: noise compared with isolated points
+ *
+ * See the documentation of the functions for more information.
+ *
+ */
+
+// LArSoft libraries
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointClusteringAlg.h"
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointIsolationAlg.h"
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( PointClusteringAlg_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// C/C++ standard libraries
+#include <array>
+#include <vector>
+#include <random>
+#include <algorithm> // std::sort()
+
+
+// BEGIN RemoveIsolatedSpacePoints group ---------------------------------------
+/// @ingroup RemoveIsolatedSpacePoints
+/// @{
+//------------------------------------------------------------------------------
+//--- Test code
+//---
+/**
+ * @brief Low-multiplicity unit test
+ *
+ * Two groups of points on a line, a border point attached to the first one
+ * and two noise points.
+ * The radius is 1 and a core point needs 3 neighbours (itself included).
+ *
+ * This test uses coordinate type `float`.
+ *
+ */
+void PointClusteringTest1() {
+
+  using Coord_t = float;
+  using PointClusteringAlg_t = lar::example::PointClusteringAlg<Coord_t>;
+  constexpr auto Noise = PointClusteringAlg_t::NoiseLabel;
+
+  using Point_t = std::array<Coord_t, 3U>;
+
+  PointClusteringAlg_t::Configuration_t config;
+  config.epsilon2 = cet::square(1.);
+  config.minPoints = 3;
+  config.rangeX = { -10., +10. };
+  config.rangeY = { -10., +10. };
+  config.rangeZ = { -10., +10. };
+  PointClusteringAlg_t::validateConfiguration(config);
+
+  PointClusteringAlg_t algo(config);
+
+  std::vector<Point_t> const points {
+    {{  8.0, 0., 0. }}, // noise
+    {{ -5.0, 0., 0. }}, // cluster 0 (core)
+    {{ -4.5, 0., 0. }}, // cluster 0 (core)
+    {{ -4.0, 0., 0. }}, // cluster 0 (core)
+    {{ -3.2, 0., 0. }}, // cluster 0 (border: only 2 neighbours)
+    {{  2.0, 0., 0. }}, // cluster 1 (core)
+    {{  2.0, 0.5, 0. }}, // cluster 1 (core)
+    {{  2.0, 0., 0.5 }}, // cluster 1 (core)
+    {{  0.0, 0., 0. }}  // noise (within 2 of cluster 1, but not 1)
+    };
+  std::vector<PointClusteringAlg_t::ClusterLabel_t> const expected
+    { Noise, 0, 0, 0, 0, 1, 1, 1, Noise };
+
+  auto const result = algo.clusterPoints(points);
+  BOOST_CHECK_EQUAL_COLLECTIONS
+    (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+  BOOST_CHECK_EQUAL(PointClusteringAlg_t::countClusters(result), 2U);
+
+  auto const bruteResult
+    = algo.bruteClusterPoints(points.cbegin(), points.cend());
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+    bruteResult.cbegin(), bruteResult.cend(),
+    expected.cbegin(), expected.cend()
+    );
+
+  // no point is noise if a single point is enough
+  config.minPoints = 1;
+  algo.reconfigure(config);
+  auto const singleResult = algo.clusterPoints(points);
+  BOOST_CHECK_EQUAL
+    (std::count(singleResult.cbegin(), singleResult.cend(), Noise), 0);
+  BOOST_CHECK_EQUAL(PointClusteringAlg_t::countClusters(singleResult), 4U);
+
+  // empty input
+  BOOST_CHECK(algo.clusterPoints(std::vector<Point_t>()).empty());
+
+} // PointClusteringTest1()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Compares the algorithm with the brute-force one on random points
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ *
+ * The points are uniformly distributed in a box; a few configurations are
+ * tested, including one with a memory limit which makes the cells larger
+ * than the radius.
+ */
+template <unsigned int Dims, typename Engine>
+void PointClusteringRandomTest(Engine& generator, unsigned int nPoints) {
+
+  using Coord_t = double;
+  using PointClusteringAlg_t
+    = lar::example::PointClusteringAlg<Coord_t, Dims>;
+
+  using Point_t = std::array<Coord_t, Dims>;
+
+  std::uniform_real_distribution<Coord_t> uniform(-1., +1.);
+  std::vector<Point_t> points(nPoints);
+  for (Point_t& point: points)
+    for (Coord_t& coord: point) coord = uniform(generator);
+
+  typename PointClusteringAlg_t::Configuration_t config;
+  config.rangeX = { -1., +1. };
+  config.rangeY = { -1., +1. };
+  if constexpr (Dims == 3U) config.rangeZ = { -1., +1. };
+
+  struct TestConfig_t {
+    Coord_t epsilon;
+    unsigned int minPoints;
+    size_t maxMemory;
+  };
+  std::vector<TestConfig_t> const tests {
+    { 0.05, 2U, 100 * 1048576 },
+    { 0.10, 4U, 100 * 1048576 },
+    { 0.10, 4U, 1024 }, // cells larger than epsilon
+    { 0.20, 10U, 100 * 1048576 }
+    };
+
+  for (TestConfig_t const& test: tests) {
+    config.epsilon2 = cet::square(test.epsilon);
+    config.minPoints = test.minPoints;
+    config.maxMemory = test.maxMemory;
+    PointClusteringAlg_t::validateConfiguration(config);
+    PointClusteringAlg_t const algo(config);
+
+    auto const result = algo.clusterPoints(points);
+    auto const expected
+      = algo.bruteClusterPoints(points.cbegin(), points.cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+  } // for
+
+} // PointClusteringRandomTest()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Compares noise points with the isolated ones from PointIsolationAlg
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ *
+ * With a minimum of 2 points, noise points are exactly the isolated points.
+ */
+template <typename Engine>
+void PointClusteringIsolationTest(Engine& generator, unsigned int nPoints) {
+
+  using Coord_t = double;
+  using PointClusteringAlg_t = lar::example::PointClusteringAlg<Coord_t>;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+
+  using Point_t = std::array<Coord_t, 3U>;
+
+  std::uniform_real_distribution<Coord_t> uniform(-1., +1.);
+  std::vector<Point_t> points(nPoints);
+  for (Point_t& point: points)
+    for (Coord_t& coord: point) coord = uniform(generator);
+
+  constexpr Coord_t radius = 0.05;
+
+  PointClusteringAlg_t::Configuration_t clusterConfig;
+  clusterConfig.rangeX = { -1., +1. };
+  clusterConfig.rangeY = { -1., +1. };
+  clusterConfig.rangeZ = { -1., +1. };
+  clusterConfig.epsilon2 = cet::square(radius);
+  clusterConfig.minPoints = 2;
+
+  PointIsolationAlg_t::Configuration_t isolConfig;
+  isolConfig.rangeX = clusterConfig.rangeX;
+  isolConfig.rangeY = clusterConfig.rangeY;
+  isolConfig.rangeZ = clusterConfig.rangeZ;
+  isolConfig.radius2 = clusterConfig.epsilon2;
+
+  auto const labels = PointClusteringAlg_t(clusterConfig).clusterPoints(points);
+  std::vector<size_t> clustered;
+  for (size_t i = 0; i < labels.size(); ++i)
+    if (labels[i] != PointClusteringAlg_t::NoiseLabel) clustered.push_back(i);
+
+  std::vector<size_t> nonIsolated
+    = PointIsolationAlg_t(isolConfig).removeIsolatedPoints(points);
+  std::sort(nonIsolated.begin(), nonIsolated.end());
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+    clustered.cbegin(), clustered.cend(),
+    nonIsolated.cbegin(), nonIsolated.cend()
+    );
+
+} // PointClusteringIsolationTest()
+
+
+//------------------------------------------------------------------------------
+//--- tests
+//
+BOOST_AUTO_TEST_CASE(PointClusteringAlgTest) {
+  PointClusteringTest1();
+} // PointClusteringAlgTest()
+
+
+BOOST_AUTO_TEST_CASE(PointClusteringAlgRandomTest) {
+  std::default_random_engine generator(12345);
+  PointClusteringRandomTest<3U>(generator, 2000);
+  PointClusteringRandomTest<2U>(generator, 2000);
+} // PointClusteringAlgRandomTest()
+
+
+BOOST_AUTO_TEST_CASE(PointClusteringAlgIsolationTest) {
+  std::default_random_engine generator(54321);
+  PointClusteringIsolationTest(generator, 20000);
+} // PointClusteringAlgIsolationTest()
+
+
+/// @}
+// END RemoveIsolatedSpacePoints group -----------------------------------------
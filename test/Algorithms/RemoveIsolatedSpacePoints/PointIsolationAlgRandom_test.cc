@@ -9,11 +9,23 @@
  * This test populate datasets with random data and tests the isolation
  * algorithm with them.
  *
- * The test accepts one optional argument:
+ * The test accepts two optional arguments:
  *
- *     PointIsolationAlg_test  [seed]
+ *     PointIsolationAlg_test  [seed] [points]
  *
- * to set the random seed to a particular value.
+ * to set the random seed to a particular value, and the number of points in
+ * the large-scale test (100000 by default).
+ *
+ * The large-scale test compares the results with the ones from the parallel
+ * brute-force algorithm, which is fast enough for @f$ 10^{5} @f$ points or
+ * more (using all the available cores).
+ *
+ * The same kind of data is also used to test the queries of `SpacePartition`
+ * (points within a radius and closest points), the processing of many
+ * small sets of points in a batch, points stored as coordinate arrays
+ * (`BulkPositionExtractor`), the processing of a subset of a collection,
+ * partition settings prepared in advance (`preparePartitionLayout()`), and
+ * the concurrent use of the same algorithm from many threads.
  *
  */
 
@@ -34,13 +46,111 @@
 #include <random>
 #include <chrono>
 #include <ratio> // std::milli
+#include <cmath> // std::abs()
 #include <iostream>
-#include <algorithm> // std::sort()
+#include <algorithm> // std::sort(), std::max(), std::includes(), std::shuffle()
+#include <numeric> // std::iota(), std::accumulate()
+#include <stdexcept> // std::runtime_error
+#include <sstream> // std::istringstream
+#include <utility> // std::pair
+#include <iterator> // std::distance(), std::random_access_iterator_tag
+#include <thread>
+#include <cstddef> // std::ptrdiff_t
 
 
 // BEGIN RemoveIsolatedSpacePoints group ---------------------------------------
 /// @ingroup RemoveIsolatedSpacePoints
 /// @{
+//------------------------------------------------------------------------------
+//--- Points stored as one array per coordinate
+//---
+/// Points stored as one vector per coordinate ("structure of arrays")
+struct PointArrays_t {
+  std::vector<double> x, y, z;
+}; // PointArrays_t
+
+
+/// A point in a `PointArrays_t` collection
+struct PointArraysRef_t {
+  PointArrays_t const* arrays = nullptr;
+  std::size_t index = 0;
+}; // PointArraysRef_t
+
+
+/// Random access iterator to the points of a `PointArrays_t` collection
+class PointArraysIter_t {
+    public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = PointArraysRef_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = PointArraysRef_t;
+
+  PointArraysIter_t() = default;
+  PointArraysIter_t(PointArrays_t const& arrays, difference_type index)
+    : arrays(&arrays), index(index) {}
+
+  PointArrays_t const& collection() const { return *arrays; }
+  std::size_t position() const { return index; }
+
+  reference operator* () const { return { arrays, std::size_t(index) }; }
+  reference operator[] (difference_type n) const { return *(*this + n); }
+
+  PointArraysIter_t& operator++ () { ++index; return *this; }
+  PointArraysIter_t operator++ (int) { auto old = *this; ++index; return old; }
+  PointArraysIter_t& operator-- () { --index; return *this; }
+  PointArraysIter_t& operator+= (difference_type n)
+    { index += n; return *this; }
+  PointArraysIter_t operator+ (difference_type n) const
+    { return { *arrays, index + n }; }
+  difference_type operator- (PointArraysIter_t const& other) const
+    { return index - other.index; }
+
+  bool operator== (PointArraysIter_t const& other) const
+    { return index == other.index; }
+  bool operator!= (PointArraysIter_t const& other) const
+    { return index != other.index; }
+  bool operator< (PointArraysIter_t const& other) const
+    { return index < other.index; }
+
+    private:
+  PointArrays_t const* arrays = nullptr;
+  difference_type index = 0;
+}; // PointArraysIter_t
+
+
+PointArraysIter_t begin(PointArrays_t const& points) { return { points, 0 }; }
+PointArraysIter_t end(PointArrays_t const& points)
+  { return { points, std::ptrdiff_t(points.x.size()) }; }
+
+
+namespace lar {
+  namespace example {
+
+    template <>
+    struct PositionExtractor<PointArraysRef_t> {
+      static double x(PointArraysRef_t p) { return p.arrays->x[p.index]; }
+      static double y(PointArraysRef_t p) { return p.arrays->y[p.index]; }
+      static double z(PointArraysRef_t p) { return p.arrays->z[p.index]; }
+    }; // PositionExtractor<PointArraysRef_t>
+
+    template <>
+    struct BulkPositionExtractor<PointArraysIter_t> {
+      static std::array<double const*, 3U> coordinates(PointArraysIter_t it)
+        {
+          PointArrays_t const& arrays = it.collection();
+          return {{
+            arrays.x.data() + it.position(),
+            arrays.y.data() + it.position(),
+            arrays.z.data() + it.position()
+            }};
+        }
+    }; // BulkPositionExtractor<PointArraysIter_t>
+
+  } // namespace example
+} // namespace lar
+
+
 //------------------------------------------------------------------------------
 //--- Test code
 //---
@@ -118,6 +228,20 @@ void PointIsolationTest(
     std::cout << "  brute force: " << elapsed << " ms"
       << std::endl;
 
+    //
+    // run the parallel brute force approach, which must give the same result
+    //
+    timer.restart();
+    auto const parallelExpected
+      = algo.parallelBruteRemoveIsolatedPoints(points.begin(), points.end());
+    elapsed = timer.elapsed();
+    std::cout << "  parallel:    " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+      parallelExpected.cbegin(), parallelExpected.cend(),
+      expected.cbegin(), expected.cend()
+      );
+
     //
     // run the algorithm with the default approach
     //
@@ -134,6 +258,168 @@ void PointIsolationTest(
     BOOST_CHECK_EQUAL_COLLECTIONS
       (actual.cbegin(), actual.cend(), expected.cbegin(), expected.cend());
 
+    //
+    // run the algorithm with the partition settings prepared in advance
+    //
+    using PointIter_t = typename std::vector<Point_t>::const_iterator;
+    auto const layout = algo.template preparePartitionLayout<PointIter_t>();
+    timer.restart();
+    auto prepared
+      = algo.removeIsolatedPoints(layout, points.cbegin(), points.cend());
+    elapsed = timer.elapsed();
+    std::sort(prepared.begin(), prepared.end());
+    std::cout << "  prepared:    " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (prepared.cbegin(), prepared.cend(), expected.cbegin(), expected.cend());
+    BOOST_CHECK_THROW(
+      algo.removeIsolatedPoints(
+        typename PointIsolationAlg_t::PartitionLayout_t(),
+        points.cbegin(), points.cend()
+        ),
+      std::runtime_error
+      );
+
+    //
+    // run the algorithm visiting the cells in tiles
+    //
+    auto tiledConfig = config;
+    tiledConfig.tileSize = 4;
+    algo.reconfigure(tiledConfig);
+    timer.restart();
+    auto tiled = algo.removeIsolatedPoints(points);
+    elapsed = timer.elapsed();
+    std::sort(tiled.begin(), tiled.end());
+    std::cout << "  tiled:       " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (tiled.cbegin(), tiled.cend(), expected.cbegin(), expected.cend());
+
+    //
+    // run the algorithm comparing quantised positions first
+    //
+    auto quantizedConfig = config;
+    quantizedConfig.quantum = radius / 1000;
+    algo.reconfigure(quantizedConfig);
+    timer.restart();
+    auto quantized = algo.removeIsolatedPoints(points);
+    elapsed = timer.elapsed();
+    std::sort(quantized.begin(), quantized.end());
+    std::cout << "  quantised:   " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+      quantized.cbegin(), quantized.cend(), expected.cbegin(), expected.cend()
+      );
+
+    //
+    // run the algorithm skipping far cells by their bounding boxes, with
+    // little memory, so that the cells are larger than the optimal ones
+    //
+    auto boxedConfig = config;
+    boxedConfig.cellBoxes = true;
+    boxedConfig.maxMemory = 1048576;
+    algo.reconfigure(boxedConfig);
+    timer.restart();
+    auto boxed = algo.removeIsolatedPoints(points);
+    elapsed = timer.elapsed();
+    std::sort(boxed.begin(), boxed.end());
+    std::cout << "  cell boxes:  " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (boxed.cbegin(), boxed.cend(), expected.cbegin(), expected.cend());
+
+    //
+    // run the algorithm in approximate mode: the result must include all the
+    // exact non-isolated points, and only points non-isolated within the
+    // tolerated radius
+    //
+    auto approximateConfig = config;
+    approximateConfig.approximation = 0.1;
+    algo.reconfigure(approximateConfig);
+    timer.restart();
+    auto approximate = algo.removeIsolatedPoints(points);
+    elapsed = timer.elapsed();
+    std::sort(approximate.begin(), approximate.end());
+    std::cout << "  approximate: " << elapsed << " ms ("
+      << (approximate.size() - expected.size()) << " more non-isolated)"
+      << std::endl;
+    BOOST_CHECK(std::includes(
+      approximate.cbegin(), approximate.cend(),
+      expected.cbegin(), expected.cend()
+      ));
+
+    auto looseConfig = config;
+    looseConfig.radius2
+      = cet::square(radius * (1 + approximateConfig.approximation));
+    algo.reconfigure(looseConfig);
+    auto looseExpected
+      = algo.bruteRemoveIsolatedPoints(points.begin(), points.end());
+    std::sort(looseExpected.begin(), looseExpected.end());
+    BOOST_CHECK(std::includes(
+      looseExpected.cbegin(), looseExpected.cend(),
+      approximate.cbegin(), approximate.cend()
+      ));
+
+    //
+    // run the algorithm on an existing partition with different cells,
+    // as if it were shared with another algorithm (finer cells, but not
+    // so fine to take too much memory: the smallest radii get larger cells)
+    //
+    algo.reconfigure(config);
+    Coord_t const sharedCellSize = std::max(
+      PointIsolationAlg_t::maximumOptimalCellSize(radius) / 2, Coord_t(0.05)
+      );
+    using SharedRange_t = lar::example::CoordRangeCells<Coord_t>;
+    lar::example::SpacePartition<typename std::vector<Point_t>::const_iterator>
+      sharedPartition(
+        SharedRange_t{ config.rangeX, sharedCellSize },
+        SharedRange_t{ config.rangeY, sharedCellSize },
+        SharedRange_t{ config.rangeZ, sharedCellSize }
+        );
+    sharedPartition.fill(points.cbegin(), points.cend());
+    timer.restart();
+    auto shared = algo.removeIsolatedPoints(sharedPartition, points.cbegin());
+    elapsed = timer.elapsed();
+    std::sort(shared.begin(), shared.end());
+    std::cout << "  shared:      " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (shared.cbegin(), shared.cend(), expected.cbegin(), expected.cend());
+
+    //
+    // run the algorithm with the same radius for all points, given per point
+    //
+    auto const sameRadius = [radius](Point_t const&){ return radius; };
+    timer.restart();
+    auto uniform = algo.removeIsolatedPointsWithRadii
+      (points.cbegin(), points.cend(), sameRadius);
+    elapsed = timer.elapsed();
+    std::sort(uniform.begin(), uniform.end());
+    std::cout << "  same radii:  " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (uniform.cbegin(), uniform.cend(), expected.cbegin(), expected.cend());
+
+    //
+    // run the algorithm with a radius different for each point
+    // (from half to one and a half times the nominal one)
+    //
+    auto const radiusOf
+      = [radius](Point_t const& p){ return radius * (0.5 + std::abs(p[0])); };
+    auto variableExpected = algo.bruteRemoveIsolatedPointsWithRadii
+      (points.cbegin(), points.cend(), radiusOf);
+    timer.restart();
+    auto variable = algo.removeIsolatedPointsWithRadii
+      (points.cbegin(), points.cend(), radiusOf);
+    elapsed = timer.elapsed();
+    std::sort(variable.begin(), variable.end());
+    std::cout << "  point radii: " << elapsed << " ms"
+      << std::endl;
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+      variable.cbegin(), variable.cend(),
+      variableExpected.cbegin(), variableExpected.cend()
+      );
+
   } // for isolation radius
 
   std::cout << std::string(72, '-') << std::endl;
@@ -141,6 +427,575 @@ void PointIsolationTest(
 } // PointIsolationTest()
 
 
+/**
+ * @brief Tests isolation on a large random-distributed set of points
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ * @param radii list of isolation radii to test
+ *
+ * The result of the regular algorithm is compared with the one of the
+ * parallel brute force algorithm.
+ */
+template <typename Engine, typename Coord = float>
+void PointIsolationLargeTest(
+  Engine& generator, unsigned int nPoints, std::vector<Coord> const& radii
+) {
+
+  using Coord_t = Coord;
+
+  //
+  // create the input sample
+  //
+  std::uniform_real_distribution<Coord_t> uniform(-1., +1.);
+  auto randomCoord = std::bind(uniform, generator);
+
+  using Point_t = std::array<Coord_t, 3U>;
+  std::vector<Point_t> points;
+
+  points.reserve(nPoints);
+  for (unsigned int i = 0; i < nPoints; ++i)
+    points.push_back({{ randomCoord(), randomCoord(), randomCoord() }});
+  std::cout
+    << "\n" << std::string(75, '=')
+    << "\nLarge test with " << nPoints << " points"
+    << "\n" << std::string(72, '-')
+    << std::endl;
+
+  //
+  // create the algorithm
+  //
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+
+  typename PointIsolationAlg_t::Configuration_t config;
+  config.rangeX = { -2., +2. };
+  config.rangeY = { -2., +2. };
+  config.rangeZ = { -2., +2. };
+  config.radius2 = 1.;
+  PointIsolationAlg_t algo(config);
+
+  testing::StopWatch<std::chrono::duration<double, std::milli>> timer;
+  for (Coord_t radius: radii) {
+
+    config.radius2 = cet::square(radius);
+    algo.reconfigure(config);
+
+    std::cout << "Isolation radius: " << radius << std::endl;
+
+    timer.restart();
+    auto const expected
+      = algo.parallelBruteRemoveIsolatedPoints(points.begin(), points.end());
+    auto elapsed = timer.elapsed();
+    std::cout << "  parallel brute force: " << elapsed << " ms"
+      << std::endl;
+
+    timer.restart();
+    auto actual = algo.removeIsolatedPoints(points);
+    elapsed = timer.elapsed();
+    std::sort(actual.begin(), actual.end());
+    std::cout << "  regular:              " << elapsed << " ms ("
+      << actual.size() << " non-isolated)" << std::endl;
+
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (actual.cbegin(), actual.cend(), expected.cbegin(), expected.cend());
+
+  } // for isolation radius
+
+  std::cout << std::string(72, '-') << std::endl;
+
+} // PointIsolationLargeTest()
+
+
+/**
+ * @brief Tests the queries of SpacePartition on a random set of points
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ *
+ * The points within a radius from random positions (also outside the volume
+ * of the partition) and the points closest to them are compared with the ones
+ * found by brute force.
+ */
+template <typename Engine>
+void SpacePartitionQueryTest(Engine& generator, unsigned int nPoints) {
+
+  using Coord_t = double;
+  using Point_t = std::array<Coord_t, 3U>;
+  using PointIter_t = std::vector<Point_t>::const_iterator;
+  using Partition_t = lar::example::SpacePartition<PointIter_t>;
+
+  std::uniform_real_distribution<Coord_t> uniform(-1., +1.);
+  std::vector<Point_t> points(nPoints);
+  for (Point_t& point: points)
+    for (Coord_t& coord: point) coord = uniform(generator);
+
+  lar::example::CoordRangeCells<Coord_t> const range { -1., +1., 0.1 };
+  Partition_t partition(range, range, range);
+  partition.fill(points.cbegin(), points.cend());
+
+  constexpr size_t K = 5;
+  std::uniform_real_distribution<Coord_t> queryCoord(-1.5, +1.5);
+  for (unsigned int iQuery = 0; iQuery < 100; ++iQuery) {
+    Partition_t::Position_t const position
+      {{ queryCoord(generator), queryCoord(generator), queryCoord(generator) }};
+    Coord_t const radius = 0.05 + 0.25 * (iQuery % 4);
+
+    std::vector<size_t> expected;
+    std::vector<std::pair<Coord_t, size_t>> byDistance;
+    for (size_t i = 0; i < points.size(); ++i) {
+      Coord_t distance2 = 0.0;
+      for (std::size_t d = 0; d < 3U; ++d)
+        distance2 += (position[d] - points[i][d]) * (position[d] - points[i][d]);
+      if (distance2 <= radius * radius) expected.push_back(i);
+      byDistance.emplace_back(distance2, i);
+    } // for
+    std::sort(byDistance.begin(), byDistance.end());
+
+    std::vector<size_t> found;
+    partition.forEachPointWithin(position, radius,
+      [&points, &found](PointIter_t point)
+        { found.push_back(std::distance(points.cbegin(), point)); }
+      );
+    std::sort(found.begin(), found.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (found.cbegin(), found.cend(), expected.cbegin(), expected.cend());
+
+    // points at the same distance may be found in any order, so only the
+    // distances are compared (with the rounding of a different summation)
+    std::array<Partition_t::NearPoint_t, K> nearest;
+    size_t const nNearest
+      = partition.nearestPoints(position, K, nearest.data());
+    BOOST_CHECK_EQUAL(nNearest, std::min(K, points.size()));
+    for (size_t i = 0; i < nNearest; ++i)
+      BOOST_CHECK_CLOSE(nearest[i].distance2, byDistance[i].first, 1e-9);
+  } // for queries
+
+  // fewer points than requested
+  Partition_t smallPartition(range, range, range);
+  smallPartition.fill(points.cbegin(), points.cbegin() + 2);
+  std::array<Partition_t::NearPoint_t, K> nearest;
+  BOOST_CHECK_EQUAL
+    (smallPartition.nearestPoints({{ 5.0, 5.0, 5.0 }}, K, nearest.data()), 2U);
+
+} // SpacePartitionQueryTest()
+
+
+//------------------------------------------------------------------------------
+/// Returns `nPoints` points uniformly distributed in the [ -1, +1 ] cube
+template <typename Engine>
+std::vector<std::array<double, 3U>> MakeUnitCubeSample
+  (Engine& generator, unsigned int nPoints)
+{
+  std::uniform_real_distribution<double> uniform(-1., +1.);
+  std::vector<std::array<double, 3U>> points(nPoints);
+  for (std::array<double, 3U>& point: points)
+    for (double& coord: point) coord = uniform(generator);
+  return points;
+} // MakeUnitCubeSample()
+
+
+/// Returns an isolation configuration covering the [ -1, +1 ] cube
+lar::example::PointIsolationAlg<double>::Configuration_t UnitCubeConfiguration
+  (double radius)
+{
+  lar::example::PointIsolationAlg<double>::Configuration_t config;
+  config.rangeX = { -1., +1. };
+  config.rangeY = { -1., +1. };
+  config.rangeZ = { -1., +1. };
+  config.radius2 = cet::square(radius);
+  return config;
+} // UnitCubeConfiguration()
+
+
+/**
+ * @brief Calls `f(config)` without and with the optional partition features
+ * @param config base configuration of the algorithm
+ * @param f callable taking a validated configuration
+ *
+ * The optional features are quantised positions and cell bounding boxes.
+ */
+template <typename F>
+void ForEachFeatureConfig
+  (lar::example::PointIsolationAlg<double>::Configuration_t config, F f)
+{
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<double>;
+  for (unsigned int features = 0; features < 2; ++features) {
+    config.quantum = (features == 1)? 0.001: 0.0;
+    config.cellBoxes = (features == 1);
+    PointIsolationAlg_t::validateConfiguration(config);
+    f(config);
+  } // for features
+} // ForEachFeatureConfig()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Compares the batch processing with the one of each single set
+ * @param generator engine used to create the random input sample
+ * @param nSets number of sets of points
+ *
+ * The sets have random sizes (including empty ones) and are processed with
+ * one and more threads, with and without the optional features of the
+ * partition; the results must be the same as processing each set alone.
+ * A set with a point out of the volume must make the batch throw.
+ */
+template <typename Engine>
+void PointIsolationBatchTest(Engine& generator, unsigned int nSets) {
+
+  using Coord_t = double;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+  using Point_t = std::array<Coord_t, 3U>;
+  using PointIter_t = std::vector<Point_t>::const_iterator;
+
+  //
+  // all the sets are stored in a single collection
+  //
+  std::uniform_int_distribution<unsigned int> setSize(0, 500);
+  std::vector<unsigned int> sizes(nSets);
+  for (unsigned int& size: sizes) size = setSize(generator);
+  std::vector<Point_t> const points = MakeUnitCubeSample
+    (generator, std::accumulate(sizes.begin(), sizes.end(), 0U));
+  std::vector<std::pair<PointIter_t, PointIter_t>> pointSets;
+  PointIter_t setBegin = points.cbegin();
+  for (unsigned int size: sizes) {
+    pointSets.emplace_back(setBegin, setBegin + size);
+    setBegin += size;
+  } // for
+
+  auto const config = UnitCubeConfiguration(0.2);
+
+  ForEachFeatureConfig(config,
+    [&pointSets](PointIsolationAlg_t::Configuration_t const& config)
+    {
+      PointIsolationAlg_t const algo(config);
+      for (unsigned int nThreads: { 1U, 4U }) {
+        auto const results
+          = algo.removeIsolatedPointsInBatch(pointSets, nThreads);
+        BOOST_CHECK_EQUAL(results.size(), pointSets.size());
+        for (size_t iSet = 0; iSet < pointSets.size(); ++iSet) {
+          std::vector<size_t> const expected = algo.removeIsolatedPoints
+            (pointSets[iSet].first, pointSets[iSet].second);
+          BOOST_CHECK_EQUAL_COLLECTIONS(
+            results[iSet].cbegin(), results[iSet].cend(),
+            expected.cbegin(), expected.cend()
+            );
+        } // for sets
+      } // for threads
+    });
+
+  // no set
+  BOOST_CHECK(PointIsolationAlg_t(config).removeIsolatedPointsInBatch
+    (std::vector<std::pair<PointIter_t, PointIter_t>>()).empty());
+
+  // a point out of the volume
+  std::vector<Point_t> const outOfVolume
+    { {{ 0.0, 0.0, 0.0 }}, {{ 2.0, 0.0, 0.0 }} };
+  pointSets[nSets / 2] = { outOfVolume.cbegin(), outOfVolume.cend() };
+  BOOST_CHECK_THROW(
+    PointIsolationAlg_t(config).removeIsolatedPointsInBatch(pointSets, 4U),
+    std::runtime_error
+    );
+
+} // PointIsolationBatchTest()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Compares points stored as coordinate arrays with the usual ones
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ *
+ * The same points are stored both as a vector of points and as one vector per
+ * coordinate (`PointArrays_t`, with support for `BulkPositionExtractor`).
+ * The partition, the isolation algorithm (also with quantised positions and
+ * bounding boxes) and the parallel brute force algorithm must give the same
+ * results with both.
+ */
+template <typename Engine>
+void PointIsolationArraysTest(Engine& generator, unsigned int nPoints) {
+
+  using Coord_t = double;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+  using Point_t = std::array<Coord_t, 3U>;
+
+  static_assert
+    (lar::example::details::hasBulkPositions<PointArraysIter_t>);
+  static_assert(!lar::example::details::hasBulkPositions
+    <std::vector<Point_t>::const_iterator>);
+
+  std::vector<Point_t> const points = MakeUnitCubeSample(generator, nPoints);
+  PointArrays_t arrays;
+  for (Point_t const& point: points) {
+    arrays.x.push_back(point[0]);
+    arrays.y.push_back(point[1]);
+    arrays.z.push_back(point[2]);
+  } // for
+
+  //
+  // partition content
+  //
+  lar::example::CoordRangeCells<Coord_t> const range { -1., +1., 0.05 };
+  lar::example::SpacePartition<std::vector<Point_t>::const_iterator>
+    partition(range, range, range);
+  partition.fill(points.cbegin(), points.cend());
+  lar::example::SpacePartition<PointArraysIter_t>
+    arrayPartition(range, range, range);
+  arrayPartition.fill(begin(arrays), end(arrays));
+
+  for (std::size_t iCell = 0; iCell < partition.indexManager().size(); ++iCell)
+  {
+    auto const& cell = partition[iCell];
+    auto const& arrayCell = arrayPartition[iCell];
+    BOOST_CHECK_EQUAL(arrayPartition.isOccupied(iCell), !cell.empty());
+    BOOST_CHECK_EQUAL(arrayCell.size(), cell.size());
+    for (std::size_t i = 0; i < std::min(cell.size(), arrayCell.size()); ++i) {
+      BOOST_CHECK_EQUAL(
+        std::distance(begin(arrays), arrayCell[i]),
+        std::distance(points.cbegin(), cell[i])
+        );
+    } // for
+  } // for cells
+
+  //
+  // isolation
+  //
+  for (Coord_t radius: { 0.02, 0.05, 0.1 }) {
+    auto const config = UnitCubeConfiguration(radius);
+    ForEachFeatureConfig(config,
+      [&points, &arrays](PointIsolationAlg_t::Configuration_t const& config)
+      {
+        PointIsolationAlg_t const algo(config);
+        std::vector<size_t> const expected = algo.removeIsolatedPoints(points);
+        std::vector<size_t> const result
+          = algo.removeIsolatedPoints(begin(arrays), end(arrays));
+        BOOST_CHECK_EQUAL_COLLECTIONS
+          (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+      });
+
+    PointIsolationAlg_t const algo(config);
+    std::vector<size_t> const expected
+      = algo.parallelBruteRemoveIsolatedPoints(points.cbegin(), points.cend());
+    std::vector<size_t> const result
+      = algo.parallelBruteRemoveIsolatedPoints(begin(arrays), end(arrays));
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+  } // for radii
+
+  // a point out of the volume
+  arrays.y[nPoints / 2] = 2.0;
+  lar::example::SpacePartition<PointArraysIter_t>
+    outOfVolumePartition(range, range, range);
+  BOOST_CHECK_THROW(
+    outOfVolumePartition.fill(begin(arrays), end(arrays)),
+    std::runtime_error
+    );
+
+} // PointIsolationArraysTest()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Compares the isolation on a subset with the one on a copy of it
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ *
+ * About a third of the points is selected, both as a list of indices (in
+ * random order) and as a mask. The non-isolated points of the subset must be
+ * the ones found in a copy of the selected points, with the indices relative
+ * to the whole collection.
+ */
+template <typename Engine>
+void PointIsolationSubsetTest(Engine& generator, unsigned int nPoints) {
+
+  using Coord_t = double;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+  using Point_t = std::array<Coord_t, 3U>;
+
+  std::vector<Point_t> const points = MakeUnitCubeSample(generator, nPoints);
+
+  std::bernoulli_distribution select(0.3);
+  std::vector<bool> mask(nPoints);
+  std::vector<size_t> subset;
+  for (size_t i = 0; i < nPoints; ++i) {
+    mask[i] = select(generator);
+    if (mask[i]) subset.push_back(i);
+  } // for
+  std::shuffle(subset.begin(), subset.end(), generator);
+
+  std::vector<Point_t> subsetPoints;
+  for (size_t index: subset) subsetPoints.push_back(points[index]);
+
+  for (Coord_t radius: { 0.02, 0.05, 0.1 }) {
+    ForEachFeatureConfig(UnitCubeConfiguration(radius),
+      [&](PointIsolationAlg_t::Configuration_t const& config)
+      {
+        PointIsolationAlg_t const algo(config);
+
+        std::vector<size_t> expected;
+        for (size_t i: algo.removeIsolatedPoints(subsetPoints))
+          expected.push_back(subset[i]);
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<size_t> result = algo.removeIsolatedPoints(points, subset);
+        std::sort(result.begin(), result.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS
+          (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+
+        std::vector<size_t> maskResult
+          = algo.removeIsolatedPoints(points, mask);
+        std::sort(maskResult.begin(), maskResult.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+          maskResult.cbegin(), maskResult.cend(),
+          expected.cbegin(), expected.cend()
+          );
+      });
+  } // for radii
+
+  // empty subset
+  PointIsolationAlg_t const algo(UnitCubeConfiguration(0.1));
+  BOOST_CHECK(algo.removeIsolatedPoints(points, std::vector<size_t>()).empty());
+  BOOST_CHECK(
+    algo.removeIsolatedPoints(points, std::vector<bool>(nPoints, false)).empty()
+    );
+
+  // mask with the wrong size
+  BOOST_CHECK_THROW(
+    algo.removeIsolatedPoints(points, std::vector<bool>(nPoints + 1, true)),
+    std::runtime_error
+    );
+
+} // PointIsolationSubsetTest()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Counts the isolated points in random samples
+ * @param generator engine used to create the random input sample
+ * @param nPoints points in the input sample
+ *
+ * The number of isolated points in a random sample, and in the whole
+ * collection, must match the result of `removeIsolatedPoints()`, with and
+ * without a prepared layout. The count must also stop when requested.
+ */
+template <typename Engine>
+void PointIsolationCountTest(Engine& generator, unsigned int nPoints) {
+
+  using Coord_t = double;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+  using Point_t = std::array<Coord_t, 3U>;
+  using PointIter_t = std::vector<Point_t>::const_iterator;
+  using Count_t = PointIsolationAlg_t::IsolationCount_t;
+
+  std::vector<Point_t> const points = MakeUnitCubeSample(generator, nPoints);
+
+  std::vector<size_t> all(nPoints);
+  std::iota(all.begin(), all.end(), size_t(0));
+  std::shuffle(all.begin(), all.end(), generator);
+  std::vector<size_t> const sample(all.begin(), all.begin() + nPoints / 20);
+
+  auto const never = [](Count_t const&){ return false; };
+
+  for (Coord_t radius: { 0.02, 0.05, 0.1 }) {
+    ForEachFeatureConfig(UnitCubeConfiguration(radius),
+      [&](PointIsolationAlg_t::Configuration_t const& config)
+      {
+        PointIsolationAlg_t const algo(config);
+        auto const layout = algo.preparePartitionLayout<PointIter_t>();
+
+        std::vector<bool> isolated(nPoints, true);
+        for (size_t i: algo.removeIsolatedPoints(points)) isolated[i] = false;
+        size_t const nIsolated
+          = std::count(isolated.begin(), isolated.end(), true);
+        size_t nSampleIsolated = 0;
+        for (size_t i: sample) if (isolated[i]) ++nSampleIsolated;
+
+        Count_t const allCount = algo.countIsolatedPoints
+          (points.cbegin(), points.cend(), all.cbegin(), all.cend(), never);
+        BOOST_CHECK_EQUAL(allCount.tested, nPoints);
+        BOOST_CHECK_EQUAL(allCount.isolated, nIsolated);
+
+        Count_t const sampleCount = algo.countIsolatedPoints(
+          layout, points.cbegin(), points.cend(),
+          sample.cbegin(), sample.cend(), never
+          );
+        BOOST_CHECK_EQUAL(sampleCount.tested, sample.size());
+        BOOST_CHECK_EQUAL(sampleCount.isolated, nSampleIsolated);
+
+        // stop after the first 10 points
+        size_t nFirstIsolated = 0;
+        for (size_t i = 0; i < 10; ++i)
+          if (isolated[sample[i]]) ++nFirstIsolated;
+        Count_t const firstCount = algo.countIsolatedPoints(
+          points.cbegin(), points.cend(), sample.cbegin(), sample.cend(),
+          [](Count_t const& count){ return count.tested >= 10; }
+          );
+        BOOST_CHECK_EQUAL(firstCount.tested, 10U);
+        BOOST_CHECK_EQUAL(firstCount.isolated, nFirstIsolated);
+      });
+  } // for radii
+
+} // PointIsolationCountTest()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Runs the same algorithm object from many threads at the same time
+ * @param generator engine used to create the random input samples
+ * @param nPoints points in each input sample
+ * @param nThreads number of concurrent threads
+ *
+ * Each thread processes its own sample a few times, with a layout shared by
+ * all threads, as different events would be processed concurrently in a
+ * framework. The results must be the same as from a single thread.
+ */
+template <typename Engine>
+void PointIsolationConcurrentTest
+  (Engine& generator, unsigned int nPoints, unsigned int nThreads)
+{
+  using Coord_t = double;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+  using Point_t = std::array<Coord_t, 3U>;
+  using PointIter_t = std::vector<Point_t>::const_iterator;
+
+  std::vector<std::vector<Point_t>> samples;
+  for (unsigned int iThread = 0; iThread < nThreads; ++iThread)
+    samples.push_back(MakeUnitCubeSample(generator, nPoints));
+
+  auto config = UnitCubeConfiguration(0.05);
+  config.quantum = 0.0001;
+  PointIsolationAlg_t::validateConfiguration(config);
+  PointIsolationAlg_t const algo(config);
+  auto const layout = algo.preparePartitionLayout<PointIter_t>();
+
+  std::vector<std::vector<size_t>> expected;
+  for (std::vector<Point_t> const& points: samples)
+    expected.push_back(algo.removeIsolatedPoints(points));
+
+  constexpr unsigned int nRepetitions = 5;
+  std::vector<unsigned int> nMismatches(nThreads, 0U);
+  std::vector<std::thread> workers;
+  for (unsigned int iThread = 0; iThread < nThreads; ++iThread) {
+    workers.emplace_back([&, iThread]
+      {
+        std::vector<Point_t> const& points = samples[iThread];
+        for (unsigned int i = 0; i < nRepetitions; ++i) {
+          if (algo.removeIsolatedPoints(points) != expected[iThread])
+            ++nMismatches[iThread];
+          if (algo.removeIsolatedPoints(layout, points.cbegin(), points.cend())
+            != expected[iThread]
+            )
+          {
+            ++nMismatches[iThread];
+          }
+        } // for
+      });
+  } // for
+  for (std::thread& worker: workers) worker.join();
+
+  for (unsigned int iThread = 0; iThread < nThreads; ++iThread)
+    BOOST_CHECK_EQUAL(nMismatches[iThread], 0U);
+
+} // PointIsolationConcurrentTest()
+
+
 //------------------------------------------------------------------------------
 //--- tests
 //
@@ -180,9 +1035,64 @@ BOOST_FIXTURE_TEST_CASE(PointIsolationTestCase, ArgsFixture) {
   for (unsigned int nPoints: DataSizes)
     PointIsolationTest(generator, nPoints, Radii);
 
+  //
+  // large-scale test
+  //
+  unsigned int nLargePoints = 100000;
+  if (argc > 2) {
+    std::istringstream sstr;
+    sstr.str(argv[2]);
+    sstr >> nLargePoints;
+    if (!sstr) {
+      throw std::runtime_error
+        ("Invalid number of points specified: " + std::string(argv[2]));
+    }
+  } // if number of points specified
+
+  // with 10^5 points, about 25% of the points are isolated at the smallest
+  // radius, and less than 0.1% at the largest one
+  std::vector<float> const LargeRadii { 0.03, 0.1 };
+  PointIsolationLargeTest(generator, nLargePoints, LargeRadii);
+
 } // PointIsolationTestCase()
 
 
+BOOST_AUTO_TEST_CASE(SpacePartitionQueryTestCase) {
+  std::default_random_engine generator(12345);
+  SpacePartitionQueryTest(generator, 10000);
+} // SpacePartitionQueryTestCase()
+
+
+BOOST_AUTO_TEST_CASE(PointIsolationBatchTestCase) {
+  std::default_random_engine generator(23456);
+  PointIsolationBatchTest(generator, 200);
+} // PointIsolationBatchTestCase()
+
+
+BOOST_AUTO_TEST_CASE(PointIsolationArraysTestCase) {
+  std::default_random_engine generator(34567);
+  PointIsolationArraysTest(generator, 20000);
+} // PointIsolationArraysTestCase()
+
+
+BOOST_AUTO_TEST_CASE(PointIsolationSubsetTestCase) {
+  std::default_random_engine generator(45678);
+  PointIsolationSubsetTest(generator, 20000);
+} // PointIsolationSubsetTestCase()
+
+
+BOOST_AUTO_TEST_CASE(PointIsolationCountTestCase) {
+  std::default_random_engine generator(67890);
+  PointIsolationCountTest(generator, 20000);
+} // PointIsolationCountTestCase()
+
+
+BOOST_AUTO_TEST_CASE(PointIsolationConcurrentTestCase) {
+  std::default_random_engine generator(56789);
+  PointIsolationConcurrentTest(generator, 20000, 8);
+} // PointIsolationConcurrentTestCase()
+
+
 /// @}
 // END RemoveIsolatedSpacePoints group -----------------------------------------
 
@@ -14,7 +14,7 @@
  *
  * Usage:
  *
- *     PointIsolationAlg_test NumberOfPoints[+|-] IsolationRadius
+ *     PointIsolationAlg_test [--counters] NumberOfPoints[+|-] IsolationRadius [Approximation]
  *
  * where NumberOfPoints is an approximation of the number of points to be
  * generated on a grid and processed.
@@ -25,6 +25,17 @@
  * The points are places in a simple grid, with a distance of 1 (arbitrary unit)
  * one from the next on each direction.
  * The IsolationRadius parameter is measured in the same unit.
+ * If an Approximation is specified, the algorithm is run a second time in
+ * approximate mode with that relative tolerance on the radius, and the
+ * throughput of both modes and the fraction of points on which they disagree
+ * are reported.
+ *
+ * With the `--counters` option, the hardware performance counters (cycles,
+ * instructions, L1 data cache and last level cache read misses, branch
+ * misses) are read (Linux `perf_event_open()`) while the partition is built
+ * and while it is scanned, and reported per point. Counters which are not
+ * available (e.g. in unprivileged containers, or not supported by the CPU)
+ * are reported as such, and the test proceeds.
  *
  * On configuration failure, the test returns with exit code 1.
  * On test failure, the test returns with exit code 2.
@@ -37,9 +48,25 @@
 // C/C++ standard libraries
 #include <cmath> // std::pow(), std::ceil(), std::floor()
 #include <stdexcept> // std::logic_error
+#include <algorithm> // std::sort(), std::set_symmetric_difference()
+#include <iterator> // std::back_inserter()
 #include <chrono>
 #include <sstream>
 #include <iostream>
+#include <iomanip> // std::setw()
+#include <array>
+#include <string>
+#include <cstring> // std::strerror()
+#include <cerrno>
+#include <cstdint> // std::uint64_t
+
+// system libraries
+#ifdef __linux__
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif // __linux__
 
 
 // BEGIN RemoveIsolatedSpacePoints group ---------------------------------------
@@ -72,6 +99,175 @@ std::vector<Point> createPointsInCube(unsigned int pointsPerSide) {
 } // createPointsInCube()
 
 
+//------------------------------------------------------------------------------
+/**
+ * @brief Reads some hardware performance counters of this process
+ *
+ * Each counter is opened independently, so that the ones available are read
+ * even if others are not. Counters are read between `start()` and `stop()`,
+ * user space only, and scaled for the time they were actually counting when
+ * the kernel had to multiplex them.
+ * On platforms other than Linux no counter is ever available.
+ */
+class PerfCounters {
+    public:
+  static constexpr std::size_t NCounters = 5;
+
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(PerfCounters const&) = delete;
+  PerfCounters& operator= (PerfCounters const&) = delete;
+
+  /// Returns whether at least one of the counters is available
+  bool available() const;
+
+  /// Resets and starts all the available counters
+  void start();
+
+  /// Stops all the counters and records their values
+  void stop();
+
+  /// Prints the recorded values, divided by the specified number of points
+  void print
+    (std::string const& phase, std::size_t nPoints, std::ostream& out) const;
+
+    private:
+  struct Counter_t {
+    char const* name; ///< name of the counter
+    int fd = -1; ///< file descriptor of the counter (`-1`: not available)
+    int error = 0; ///< error code from opening the counter
+    double value = 0.0; ///< last recorded value
+  }; // Counter_t
+
+  std::array<Counter_t, NCounters> counters;
+
+}; // class PerfCounters
+
+
+#ifdef __linux__
+
+PerfCounters::PerfCounters() {
+
+  auto cacheConfig = [](std::uint64_t cache){
+    return cache
+      | (std::uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8)
+      | (std::uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+  };
+
+  struct EventSpec_t {
+    char const* name;
+    std::uint32_t type;
+    std::uint64_t config;
+  };
+  std::array<EventSpec_t, NCounters> const specs {{
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "L1D misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D) },
+    { "LLC misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_LL) },
+    { "branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+  }};
+
+  for (std::size_t i = 0; i < NCounters; ++i) {
+    Counter_t& counter = counters[i];
+    counter.name = specs[i].name;
+
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = specs[i].type;
+    attr.config = specs[i].config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; // allowed with stricter `perf_event_paranoid`
+    attr.exclude_hv = 1;
+    attr.read_format
+      = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // this process (and its threads created from now on), any CPU
+    attr.inherit = 1;
+    counter.fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (counter.fd < 0) counter.error = errno;
+  } // for
+
+} // PerfCounters::PerfCounters()
+
+
+PerfCounters::~PerfCounters() {
+  for (Counter_t const& counter: counters)
+    if (counter.fd >= 0) close(counter.fd);
+} // PerfCounters::~PerfCounters()
+
+
+void PerfCounters::start() {
+  for (Counter_t& counter: counters) {
+    counter.value = 0.0;
+    if (counter.fd < 0) continue;
+    ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+  } // for
+} // PerfCounters::start()
+
+
+void PerfCounters::stop() {
+  for (Counter_t& counter: counters) {
+    if (counter.fd < 0) continue;
+    ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    std::uint64_t data[3] = { 0, 0, 0 }; // value, time enabled, time running
+    if (read(counter.fd, data, sizeof(data)) != sizeof(data)) {
+      counter.value = -1.0; // reading failed
+      continue;
+    }
+    counter.value = (data[2] == 0)
+      ? 0.0: double(data[0]) * double(data[1]) / double(data[2]);
+  } // for
+} // PerfCounters::stop()
+
+#else // !__linux__
+
+PerfCounters::PerfCounters() {
+  char const* names[NCounters] = {
+    "cycles", "instructions", "L1D misses", "LLC misses", "branch misses"
+    };
+  for (std::size_t i = 0; i < NCounters; ++i) {
+    counters[i].name = names[i];
+    counters[i].error = ENOSYS;
+  }
+} // PerfCounters::PerfCounters()
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::start() {}
+
+void PerfCounters::stop() {}
+
+#endif // __linux__
+
+
+bool PerfCounters::available() const {
+  for (Counter_t const& counter: counters)
+    if (counter.fd >= 0) return true;
+  return false;
+} // PerfCounters::available()
+
+
+void PerfCounters::print
+  (std::string const& phase, std::size_t nPoints, std::ostream& out) const
+{
+  out << "  " << phase << ":";
+  for (Counter_t const& counter: counters) {
+    out << "\n    " << std::setw(14) << counter.name << ": ";
+    if (counter.fd < 0) {
+      out << "not available (" << std::strerror(counter.error) << ")";
+    }
+    else if (counter.value < 0.0) out << "could not be read";
+    else {
+      out << (counter.value / nPoints) << " per point";
+    }
+  } // for
+  out << std::endl;
+} // PerfCounters::print()
+
+
 //------------------------------------------------------------------------------
 template <typename T>
 void PrintConfiguration(
@@ -88,11 +284,79 @@ void PrintConfiguration(
 } // PrintConfiguration()
 
 
+//------------------------------------------------------------------------------
+/**
+ * @brief Reads hardware counters while building and scanning a partition
+ * @tparam T type of the coordinates
+ * @param points the input points
+ * @param algo the configured algorithm
+ * @param expected number of non-isolated points expected
+ *
+ * The two phases are run separately: the partition is built with the cell
+ * size the algorithm would choose with no memory limit, then the algorithm
+ * scans it.
+ */
+template <typename T>
+void CounterTest(
+  std::vector<std::array<T, 3U>> const& points,
+  lar::example::PointIsolationAlg<T> const& algo,
+  std::size_t expected
+) {
+  using Coord_t = T;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+  using Partition_t = lar::example::SpacePartition
+    <typename std::vector<std::array<T, 3U>>::const_iterator>;
+
+  PerfCounters counters;
+  if (!counters.available()) {
+    std::cout << "Hardware performance counters not available, skipped:\n";
+    counters.print("counters", points.size(), std::cout);
+    return;
+  }
+
+  auto const& config = algo.configuration();
+  Coord_t const cellSize
+    = PointIsolationAlg_t::maximumOptimalCellSize(std::sqrt(config.radius2));
+  typename Partition_t::Ranges_t const ranges {{
+    { config.rangeX.lower, config.rangeX.upper, cellSize },
+    { config.rangeY.lower, config.rangeY.upper, cellSize },
+    { config.rangeZ.lower, config.rangeZ.upper, cellSize }
+    }};
+
+  std::cout << "Hardware performance counters (cell size: " << cellSize
+    << "):\n";
+
+  counters.start();
+  Partition_t partition(ranges);
+  if (config.quantum > Coord_t(0)) partition.enableQuantization(config.quantum);
+  if (config.cellBoxes) partition.enableBoundingBoxes();
+  partition.fill(points.cbegin(), points.cend());
+  counters.stop();
+  counters.print("build", points.size(), std::cout);
+
+  counters.start();
+  std::vector<size_t> const result
+    = algo.removeIsolatedPoints(partition, points.cbegin());
+  counters.stop();
+  counters.print("scan", points.size(), std::cout);
+
+  if (result.size() != expected) {
+    throw std::logic_error(
+      "Expected " + std::to_string(expected) + " non-isolated points, found "
+      + std::to_string(result.size()) + " with a prebuilt partition."
+      );
+  }
+
+} // CounterTest()
+
+
 //------------------------------------------------------------------------------
 template <typename T>
 void StressTest(
   unsigned int pointsPerSide,
-  typename lar::example::PointIsolationAlg<T>::Configuration_t const& config
+  typename lar::example::PointIsolationAlg<T>::Configuration_t const& config,
+  T approximation = T(0),
+  bool useCounters = false
 ) {
 
   using Coord_t = T;
@@ -136,6 +400,10 @@ void StressTest(
     << " (" << (elapsed_init.count()*1000.) << " ms for initialization)"
     << std::endl;
 
+  std::cout << "  throughput: "
+    << (points.size() / elapsed_run.count() / 1e6) << " Mpoints/s"
+    << std::endl;
+
   if (result.size() != expected) {
     throw std::logic_error(
       "Expected " + std::to_string(expected) + " non-isolated points, found "
@@ -143,6 +411,42 @@ void StressTest(
       );
   }
 
+  if (useCounters) CounterTest(points, algo, expected);
+
+  if (approximation <= T(0)) return;
+
+  //
+  // approximate mode: compare with the exact result
+  //
+  auto approximateConfig = config;
+  approximateConfig.approximation = approximation;
+  PointIsolationAlg_t::validateConfiguration(approximateConfig);
+  algo.reconfigure(approximateConfig);
+  start_run_time = std::chrono::high_resolution_clock::now();
+  std::vector<size_t> approximate = algo.removeIsolatedPoints(points);
+  stop_run_time = std::chrono::high_resolution_clock::now();
+
+  auto elapsed_approx
+    = std::chrono::duration_cast<std::chrono::duration<float>>
+    (stop_run_time - start_run_time); // seconds
+
+  std::sort(result.begin(), result.end());
+  std::sort(approximate.begin(), approximate.end());
+  std::vector<size_t> disagreements;
+  std::set_symmetric_difference(
+    result.cbegin(), result.cend(), approximate.cbegin(), approximate.cend(),
+    std::back_inserter(disagreements)
+    );
+
+  std::cout << "Approximate mode (tolerance: " << approximation << "): found "
+    << approximate.size() << "/" << points.size()
+    << " non-isolated points in " << (elapsed_approx.count()*1000.) << " ms"
+    << "\n  throughput: "
+    << (points.size() / elapsed_approx.count() / 1e6) << " Mpoints/s"
+    << "\n  disagreement with exact mode: " << disagreements.size()
+    << " points (" << (100.0 * disagreements.size() / points.size()) << "%)"
+    << std::endl;
+
 } // StressTest()
 
 
@@ -155,9 +459,16 @@ int main(int argc, char** argv) {
   //
   // argument parsing
   //
-  if (argc != 3) {
-    std::cerr << "Usage:  " << argv[0]
-      << "  NumberOfPoints[+|-] IsolationRadius"
+  char const* programName = argv[0];
+  bool const useCounters = (argc > 1) && (std::string(argv[1]) == "--counters");
+  if (useCounters) { // skip the option
+    --argc;
+    ++argv;
+  }
+
+  if ((argc != 3) && (argc != 4)) {
+    std::cerr << "Usage:  " << programName
+      << "  [--counters] NumberOfPoints[+|-] IsolationRadius [Approximation]"
       << std::endl;
     return 1;
   }
@@ -199,6 +510,18 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  Coord_t approximation = 0.0;
+  if (argc > 3) {
+    sstr.clear();
+    sstr.str(argv[3]);
+    sstr >> approximation;
+    if (!sstr) {
+      std::cerr << "Error: expected approximation as third argument, got '"
+        << argv[3] << "' instead." << std::endl;
+      return 1;
+    }
+  } // if approximation
+
 
   //
   // prepare the configuration
@@ -229,7 +552,7 @@ int main(int argc, char** argv) {
   config.rangeZ = config.rangeX;
 
   try {
-    StressTest<Coord_t>(pointsPerSide, config);
+    StressTest<Coord_t>(pointsPerSide, config, approximation, useCounters);
   }
   catch (std::logic_error const& e) {
     std::cerr << "Test failure!\n" << e.what() << std::endl;
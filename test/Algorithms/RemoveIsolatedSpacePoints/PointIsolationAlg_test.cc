@@ -12,17 +12,20 @@
  *
  * The test is run with no arguments.
  *
- * Two tests are run:
+ * Four tests are run:
  *
  * * `PointIsolationTest1`: low multiplicity unit tests
  * * `PointIsolationTest2`: larger scale test
+ * * `PointIsolationArenaTest`: use of a custom allocator
+ * * `PointIsolation2DTest`: isolation in two dimensions
  *
- * See the documentation of the two functions for more information.
+ * See the documentation of the functions for more information.
  *
  */
 
 // LArSoft libraries
 #include "larexamples/Algorithms/RemoveIsolatedSpacePoints/PointIsolationAlg.h"
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/ArenaAllocator.h"
 
 // Boost libraries
 #define BOOST_TEST_MODULE ( PointIsolationAlg_test )
@@ -255,6 +258,111 @@ void PointIsolationTest2(unsigned int levels) {
 } // PointIsolationTest2()
 
 
+//------------------------------------------------------------------------------
+/**
+ * @brief Tests the algorithm with the memory served by an arena
+ * @param levels number of shells in the star (0 is only its centre)
+ *
+ * The test uses a star-distributed set of points, as produced by
+ * `CreateStarOfPoints()`, and compares the results of the algorithm using
+ * the standard allocator and an `ArenaAllocator`.
+ * The arena is reset after each execution, as it would be after each event:
+ * after the first execution, no more memory is expected to be needed.
+ *
+ * This test uses coordinate type `double`.
+ *
+ */
+void PointIsolationArenaTest(unsigned int levels) {
+
+  using Coord_t = double;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t>;
+
+  using Point_t = std::array<Coord_t, 3U>;
+  using PointIter_t = std::vector<Point_t>::const_iterator;
+
+  std::vector<Point_t> const points = CreateStarOfPoints<Coord_t>(levels);
+
+  PointIsolationAlg_t::Configuration_t config;
+  config.radius2 = cet::square(0.3);
+  config.rangeX = { -2., +2. };
+  config.rangeY = { -2., +2. };
+  config.rangeZ = { -2., +2. };
+  PointIsolationAlg_t algo(config);
+
+  std::vector<size_t> expected
+    = algo.removeIsolatedPoints(points.cbegin(), points.cend());
+  std::sort(expected.begin(), expected.end());
+
+  lar::example::MonotonicArena arena(4096);
+  lar::example::ArenaAllocator<PointIter_t> const alloc(arena);
+
+  std::size_t firstCapacity = 0;
+  for (unsigned int iEvent = 0; iEvent < 3; ++iEvent) {
+
+    std::vector<size_t> result
+      = algo.removeIsolatedPoints(points.cbegin(), points.cend(), alloc);
+    std::sort(result.begin(), result.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS
+      (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+
+    BOOST_CHECK_GT(arena.capacity(), 0U);
+    if (iEvent == 0) firstCapacity = arena.capacity();
+    else BOOST_CHECK_EQUAL(arena.capacity(), firstCapacity);
+
+    arena.reset();
+  } // for
+
+} // PointIsolationArenaTest()
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Tests the algorithm in two dimensions
+ *
+ * A few points are placed on a line in the plane, with increasing spacing,
+ * and the isolation is tested with an isolation radius which includes only
+ * some of the spacings. The result is also compared with the brute force one.
+ *
+ * This test uses coordinate type `float`.
+ *
+ */
+void PointIsolation2DTest() {
+
+  using Coord_t = float;
+  using PointIsolationAlg_t = lar::example::PointIsolationAlg<Coord_t, 2U>;
+
+  using Point_t = std::array<Coord_t, 2U>;
+
+  PointIsolationAlg_t::Configuration_t config;
+  config.radius2 = cet::square(1.5);
+  config.rangeX = { -10., +10. };
+  config.rangeY = { -10., +10. };
+  PointIsolationAlg_t algo(config);
+
+  // spacing:         1.0           1.0           2.0           4.0
+  std::vector<Point_t> const points {
+    {{ -4., 0. }}, {{ -3., 0. }}, {{ -2., 0. }}, {{  0., 0. }}, {{  4., 0. }},
+    // these are isolated in 3D but not in the projection on the plane
+    {{  4., 1. }}
+    };
+  std::vector<size_t> const expected { 0U, 1U, 2U, 4U, 5U };
+
+  std::vector<size_t> result = algo.removeIsolatedPoints(points);
+  std::sort(result.begin(), result.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS
+    (result.cbegin(), result.cend(), expected.cbegin(), expected.cend());
+
+  std::vector<size_t> bruteResult
+    = algo.bruteRemoveIsolatedPoints(points.cbegin(), points.cend());
+  std::sort(bruteResult.begin(), bruteResult.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+    bruteResult.cbegin(), bruteResult.cend(),
+    expected.cbegin(), expected.cend()
+    );
+
+} // PointIsolation2DTest()
+
+
 //------------------------------------------------------------------------------
 //--- tests
 //
@@ -268,6 +376,16 @@ BOOST_AUTO_TEST_CASE(PointIsolationAlgVerificationTest) {
 } // PointIsolationAlgVerificationTest()
 
 
+BOOST_AUTO_TEST_CASE(PointIsolationAlgArenaTest) {
+  PointIsolationArenaTest(5);
+} // PointIsolationAlgArenaTest()
+
+
+BOOST_AUTO_TEST_CASE(PointIsolationAlg2DTest) {
+  PointIsolation2DTest();
+} // PointIsolationAlg2DTest()
+
+
 /// @}
 // END RemoveIsolatedSpacePoints group -----------------------------------------
 
@@ -10,16 +10,23 @@
 // LArSoft libraries
 #include "SpacePointTestUtils.h"
 #include "lardataobj/RecoBase/SpacePoint.h"
+#include "lardataobj/RecoBase/Hit.h"
 #include "larcore/Geometry/Geometry.h"
+#include "larcorealg/Geometry/TPCGeo.h"
+#include "larcorealg/Geometry/PlaneGeo.h"
 
 // framework libraries
 #include "art/Framework/Core/EDProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art/Framework/Principal/Event.h"
+#include "art/Persistency/Common/PtrMaker.h"
+#include "canvas/Persistency/Common/Assns.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "fhiclcpp/types/Atom.h"
+#include "cetlib_except/exception.h"
 
 // C/C++ standard libraries
+#include <vector>
 #include <memory> // std::make_unique()
 
 
@@ -38,12 +45,25 @@ namespace lar {
        * parameter, in a cubic grid. Each TPC is independently filled,
        * so that the TPC centre hosts a space point.
        *
-       * The space points are not associated to anything.
+       * The space points are not associated to anything, unless `makeHits`
+       * is set: in that case, a collection of hits is also added, with one
+       * hit per space point, and each space point is associated with its hit.
+       * The hits are not where the space points project: the hits of each TPC
+       * are distributed in turn among its planes, and on each plane they are
+       * laid on a regular grid, every `hitWireSpacing` wires and every
+       * `hitTickSpacing` ticks, so that which hits are isolated is easy to
+       * predict.
        *
        * Configuration parameters
        * =========================
        *
        * * *spacing* (real, _mandatory_): spacing between the points [cm]
+       * * *makeHits* (boolean, default: `false`): also create one hit per
+       *   space point, and their associations
+       * * *hitWireSpacing* (integer, default: `10`): distance between hits on
+       *   the same plane, in wires
+       * * *hitTickSpacing* (real, default: `50`): distance between hits on the
+       *   same plane, in ticks
        *
        */
       class SpacePointMaker: public art::EDProducer {
@@ -60,6 +80,24 @@ namespace lar {
             Comment("spacing between points [cm]")
             };
 
+          fhicl::Atom<bool> makeHits{
+            Name("makeHits"),
+            Comment("also create a hit per space point, and associate them"),
+            false
+            };
+
+          fhicl::Atom<unsigned int> hitWireSpacing{
+            Name("hitWireSpacing"),
+            Comment("distance between hits on the same plane [wires]"),
+            10U
+            };
+
+          fhicl::Atom<double> hitTickSpacing{
+            Name("hitTickSpacing"),
+            Comment("distance between hits on the same plane [ticks]"),
+            50.0
+            };
+
         }; // Config
 
         using Parameters = art::EDProducer::Table<Config>;
@@ -73,6 +111,16 @@ namespace lar {
           private:
 
         double spacing; ///< step size [cm]
+        bool makeHits; ///< whether to create hits and associations
+        unsigned int hitWireSpacing; ///< hit step on the same plane [wires]
+        double hitTickSpacing; ///< hit step on the same plane [ticks]
+
+        /// Adds to `hits` one hit for each of `nHits` space points of `TPC`
+        void fillHits(
+          std::vector<recob::Hit>& hits,
+          geo::GeometryCore const& geom, geo::TPCGeo const& TPC,
+          size_t nHits
+          ) const;
 
       }; // class SpacePointMaker
 
@@ -92,8 +140,22 @@ namespace lar {
 lar::example::tests::SpacePointMaker::SpacePointMaker(Parameters const& config)
   : EDProducer{config}
   , spacing(config().spacing())
+  , makeHits(config().makeHits())
+  , hitWireSpacing(config().hitWireSpacing())
+  , hitTickSpacing(config().hitTickSpacing())
 {
+  if (makeHits && ((hitWireSpacing == 0) || (hitTickSpacing <= 0.0))) {
+    throw cet::exception("SpacePointMaker")
+      << "Hit spacing (" << config().hitWireSpacing.name() << ": "
+      << hitWireSpacing << ", " << config().hitTickSpacing.name() << ": "
+      << hitTickSpacing << ") must be positive\n";
+  }
+
   produces<std::vector<recob::SpacePoint>>();
+  if (makeHits) {
+    produces<std::vector<recob::Hit>>();
+    produces<art::Assns<recob::SpacePoint, recob::Hit>>();
+  }
 } // lar::example::tests::SpacePointMaker::SpacePointMaker()
 
 
@@ -104,8 +166,9 @@ void lar::example::tests::SpacePointMaker::produce(art::Event& event) {
   // set up
   //
 
-  // container for the data product
+  // containers for the data products
   auto spacePoints = std::make_unique<std::vector<recob::SpacePoint>>();
+  auto hits = std::make_unique<std::vector<recob::Hit>>();
 
   // acquire the geometry information
   auto const* geom = lar::providerFrom<geo::Geometry>();
@@ -117,7 +180,9 @@ void lar::example::tests::SpacePointMaker::produce(art::Event& event) {
   // fill each TPC independently
   for (auto const& TPC: geom->IterateTPCs()) {
 
-    FillSpacePointGrid(*spacePoints, TPC, spacing);
+    unsigned int const nPoints = FillSpacePointGrid(*spacePoints, TPC, spacing);
+
+    if (makeHits) fillHits(*hits, *geom, TPC, nPoints);
 
   } // for TPC
 
@@ -128,11 +193,73 @@ void lar::example::tests::SpacePointMaker::produce(art::Event& event) {
     << "Created " << spacePoints->size() << " space points using spacing "
     << spacing << " cm";
 
+  if (makeHits) {
+    // space point and hit with the same index are associated
+    auto pointToHits
+      = std::make_unique<art::Assns<recob::SpacePoint, recob::Hit>>();
+    art::PtrMaker<recob::SpacePoint> makePointPtr(event);
+    art::PtrMaker<recob::Hit> makeHitPtr(event);
+    for (size_t i = 0; i < hits->size(); ++i)
+      pointToHits->addSingle(makePointPtr(i), makeHitPtr(i));
+
+    mf::LogInfo("SpacePointMaker")
+      << "Created " << hits->size() << " hits associated to the space points";
+
+    event.put(std::move(hits));
+    event.put(std::move(pointToHits));
+  } // if hits
+
   event.put(std::move(spacePoints));
 
 } // lar::example::tests::SpacePointMaker::produce()
 
 
+//------------------------------------------------------------------------------
+void lar::example::tests::SpacePointMaker::fillHits(
+  std::vector<recob::Hit>& hits,
+  geo::GeometryCore const& geom, geo::TPCGeo const& TPC,
+  size_t nHits
+) const {
+
+  unsigned int const nPlanes = TPC.Nplanes();
+  hits.reserve(hits.size() + nHits);
+  for (size_t iHit = 0; iHit < nHits; ++iHit) {
+
+    // hits go to the planes in turn, and fill their grid row by row
+    geo::PlaneGeo const& plane = TPC.Plane(iHit % nPlanes);
+    size_t const iPlaneHit = iHit / nPlanes;
+    size_t const nColumns = (plane.Nwires() - 1) / hitWireSpacing + 1;
+
+    geo::WireID const wireID
+      (plane.ID(), (iPlaneHit % nColumns) * hitWireSpacing);
+    float const peakTime = (iPlaneHit / nColumns) * hitTickSpacing;
+    raw::ChannelID_t const channel = geom.PlaneWireToChannel(wireID);
+
+    hits.emplace_back(
+      channel,                                   // channel
+      raw::TDCtick_t(peakTime - 5.0),            // start tick
+      raw::TDCtick_t(peakTime + 5.0),            // end tick
+      peakTime,                                  // peak time
+      1.0,                                       // peak time uncertainty
+      2.0,                                       // RMS
+      100.0,                                     // peak amplitude
+      1.0,                                       // peak amplitude uncertainty
+      500.0,                                     // summed ADC
+      500.0,                                     // integral
+      1.0,                                       // integral uncertainty
+      1,                                         // multiplicity
+      0,                                         // local index
+      1.0,                                       // goodness of fit
+      0,                                         // degrees of freedom
+      geom.View(channel),                        // view
+      geom.SignalType(channel),                  // signal type
+      wireID                                     // wire ID
+      );
+  } // for
+
+} // lar::example::tests::SpacePointMaker::fillHits()
+
+
 //------------------------------------------------------------------------------
 DEFINE_ART_MODULE(lar::example::tests::SpacePointMaker)
 
@@ -12,13 +12,79 @@
 
 // C/C++ standard libraries
 #include <utility> // std::pair<>
-#include <cmath> // std::sqrt()
+#include <cmath> // std::sqrt(), std::abs(), std::sin(), std::cos()
+#include <random>
+#include <algorithm> // std::min(), std::max()
+#include <thread>
+#include <atomic>
+#include <exception> // std::exception_ptr, std::current_exception(), ...
 
 
 // function prototype declarations (implementation below)
 std::pair<int, int> ComputeRangeIndices
   (double min, double max, double stepSize);
 
+/// Returns the ID for the next space point in the collection
+int NextSpacePointID(std::vector<recob::SpacePoint> const& spacePoints);
+
+/// Returns whether the point is inside the box (borders included)
+bool IsInBox(
+  geo::BoxBoundedGeo const& box,
+  lar::example::tests::Vector3D_t const& point
+  );
+
+/// Returns a unit vector orthogonal to the unit vector `dir`
+lar::example::tests::Vector3D_t OrthogonalDirection
+  (lar::example::tests::Vector3D_t const& dir);
+
+/// Returns the cross product of `a` and `b`
+lar::example::tests::Vector3D_t CrossProduct(
+  lar::example::tests::Vector3D_t const& a,
+  lar::example::tests::Vector3D_t const& b
+  );
+
+
+/// A piece of a synthetic event, filled independently of the others
+struct SyntheticChunk_t {
+
+  /// Type of object the chunk is part of
+  enum class Kind_t { Track, Shower, Noise, Stray };
+
+  Kind_t kind = Kind_t::Noise; ///< type of object
+  lar::example::tests::Vector3D_t start; ///< track start or shower vertex
+  lar::example::tests::Vector3D_t dir; ///< track direction or shower axis
+  lar::example::tests::Vector3D_t normal; ///< where the track bends to
+  double curvature = 0.0; ///< track curvature [1/cm]
+  size_t firstStep = 0; ///< index of the first track step of the chunk
+  size_t first = 0; ///< position of the first point in the collection
+  size_t nPoints = 0; ///< number of points to be generated
+  /// seed of the random generator of the chunk
+  lar::example::tests::SyntheticEngine_t::result_type seed = 0;
+
+}; // SyntheticChunk_t
+
+/// Splits `nPoints` points of `object` into chunks, assigning them positions
+/// from `nextSlot` on and seeds from `engine`
+void AddSyntheticChunks(
+  std::vector<SyntheticChunk_t>& chunks,
+  SyntheticChunk_t const& object, size_t nPoints, size_t& nextSlot,
+  lar::example::tests::SyntheticEngine_t& engine
+  );
+
+/// Fills the points of `chunk` from its position in the collection on,
+/// with IDs from `firstID` on; returns how many were filled
+size_t FillSyntheticChunk(
+  std::vector<recob::SpacePoint>& spacePoints,
+  geo::BoxBoundedGeo const& box,
+  lar::example::tests::SyntheticEventConfig_t const& config,
+  SyntheticChunk_t const& chunk,
+  int firstID
+  );
+
+/// Calls `op(iChunk)` for all the chunks, from up to `nThreads` threads
+template <typename Op>
+void RunSyntheticChunks(size_t nChunks, unsigned int nThreads, Op op);
+
 
 //------------------------------------------------------------------------------
 recob::SpacePoint lar::example::tests::MakeSpacePoint
@@ -47,15 +113,25 @@ unsigned int lar::example::tests::FillSpacePointGrid(
   auto const indicesY = ComputeRangeIndices(box.MinY(), box.MaxY(), stepSize);
   auto const indicesZ = ComputeRangeIndices(box.MinZ(), box.MaxZ(), stepSize);
 
-  int ID = spacePoints.empty()? 1: spacePoints.back().ID() + 1;
+  auto const rangeSize = [](std::pair<int, int> const& indices)
+    { return size_t(std::max(indices.second - indices.first + 1, 0)); };
+  size_t const nY = rangeSize(indicesY);
+  size_t const nZ = rangeSize(indicesZ);
+  size_t const nPoints = rangeSize(indicesX) * nY * nZ;
+
+  int const firstID = NextSpacePointID(spacePoints);
   size_t const origNPoints = spacePoints.size();
   double const error = stepSize / std::sqrt(12.);
 
+  // the size of the grid is known: allocate it once, and fill it by index
+  spacePoints.resize(origNPoints + nPoints);
+
   // fill the grid;
   // we don't use an increment (point[0] += stepping) to avoid rounding errors
   std::array<double, 3> const center
     {{ box.CenterX(), box.CenterY(), box.CenterZ() }};
   std::array<double, 3> point;
+  size_t iPoint = 0;
   for (int ix = indicesX.first; ix <= indicesX.second; ++ix) {
     point[0] = center[0] + ix * stepSize;
 
@@ -65,16 +141,385 @@ unsigned int lar::example::tests::FillSpacePointGrid(
       for (int iz = indicesZ.first; iz <= indicesZ.second; ++iz) {
         point[2] = center[2] + iz * stepSize;
 
-        spacePoints.push_back(MakeSpacePoint(ID++, point.data(), error));
+        spacePoints[origNPoints + iPoint]
+          = MakeSpacePoint(firstID + int(iPoint), point.data(), error);
+        ++iPoint;
 
       } // for z
     } // for y
   } // for x
 
-  return spacePoints.size() - origNPoints;
+  return nPoints;
 } // lar::example::tests::FillSpacePointGrid()
 
 
+//------------------------------------------------------------------------------
+auto lar::example::tests::RandomDirection(SyntheticEngine_t& engine)
+  -> Vector3D_t
+{
+  // a gaussian vector has uniformly distributed direction
+  std::normal_distribution<double> gaus;
+  Vector3D_t dir;
+  double norm2 = 0.;
+  do {
+    norm2 = 0.;
+    for (double& c: dir) {
+      c = gaus(engine);
+      norm2 += c * c;
+    }
+  } while (norm2 == 0.);
+  double const norm = std::sqrt(norm2);
+  for (double& c: dir) c /= norm;
+  return dir;
+} // lar::example::tests::RandomDirection()
+
+
+//------------------------------------------------------------------------------
+auto lar::example::tests::RandomPosition
+  (geo::BoxBoundedGeo const& box, SyntheticEngine_t& engine) -> Vector3D_t
+{
+  using uniform_t = std::uniform_real_distribution<double>;
+  return {{
+    uniform_t(box.MinX(), box.MaxX())(engine),
+    uniform_t(box.MinY(), box.MaxY())(engine),
+    uniform_t(box.MinZ(), box.MaxZ())(engine)
+    }};
+} // lar::example::tests::RandomPosition()
+
+
+//------------------------------------------------------------------------------
+unsigned int lar::example::tests::FillSyntheticEvent(
+  std::vector<recob::SpacePoint>& spacePoints,
+  geo::BoxBoundedGeo const& box,
+  SyntheticEventConfig_t const& config,
+  SyntheticEngine_t::result_type seed,
+  unsigned int nThreads /* = 1 */
+) {
+  using Kind_t = SyntheticChunk_t::Kind_t;
+
+  SyntheticEngine_t engine(seed);
+
+  int const firstID = NextSpacePointID(spacePoints);
+  size_t const origNPoints = spacePoints.size();
+
+  //
+  // plan of tracks and showers: all the random choices of the objects are
+  // made here, and each chunk is given its own seed
+  //
+  std::vector<SyntheticChunk_t> chunks;
+  size_t nextSlot = origNPoints;
+
+  auto const poisson = [&engine](double mean)
+    {
+      return (mean > 0.0)
+        ? std::poisson_distribution<size_t>(mean)(engine): size_t(0);
+    };
+  std::uniform_real_distribution<double> uniform;
+
+  size_t const nTracks = poisson(config.tracks);
+  size_t const nCurvedTracks = poisson(config.curvedTracks);
+  for (size_t iTrack = 0; iTrack < nTracks + nCurvedTracks; ++iTrack) {
+    SyntheticChunk_t track;
+    track.kind = Kind_t::Track;
+    track.start = RandomPosition(box, engine);
+    track.dir = RandomDirection(engine);
+    double const length = config.maxTrackLength * uniform(engine);
+    if (iTrack >= nTracks) {
+      // bend in a random plane containing the direction
+      Vector3D_t const u = OrthogonalDirection(track.dir);
+      Vector3D_t const v = CrossProduct(track.dir, u);
+      std::normal_distribution<double> gaus;
+      double a = 0.0, b = 0.0;
+      do { a = gaus(engine); b = gaus(engine); } while (a == 0.0 && b == 0.0);
+      double const norm = std::sqrt(a * a + b * b);
+      for (unsigned int i = 0; i < 3; ++i)
+        track.normal[i] = (a * u[i] + b * v[i]) / norm;
+      track.curvature = uniform(engine) / config.minCurvatureRadius;
+    } // if curved
+    size_t const nSteps = (size_t) (length / config.trackStep) + 1;
+    AddSyntheticChunks(chunks, track, nSteps, nextSlot, engine);
+  } // for tracks
+
+  size_t const nShowers = poisson(config.showers);
+  for (size_t iShower = 0; iShower < nShowers; ++iShower) {
+    SyntheticChunk_t shower;
+    shower.kind = Kind_t::Shower;
+    shower.start = RandomPosition(box, engine);
+    shower.dir = RandomDirection(engine);
+    AddSyntheticChunks
+      (chunks, shower, poisson(config.showerPoints), nextSlot, engine);
+  } // for showers
+
+  //
+  // preallocation: all the slots of tracks and showers, and an estimation of
+  // the noise and strays that will follow
+  //
+  double const backgroundRatio = (config.noiseFraction + config.strayFraction)
+    / (1.0 - config.noiseFraction - config.strayFraction);
+  size_t const nSignalSlots = nextSlot - origNPoints;
+  spacePoints.reserve(
+    nextSlot + size_t(1.1 * backgroundRatio * nSignalSlots) + 1024U
+    );
+  spacePoints.resize(nextSlot);
+
+  //
+  // parallel filling of tracks and showers; each chunk leaves its points at
+  // the start of its slots, and the points out of the box are not filled
+  //
+  std::vector<size_t> nFilled(chunks.size(), 0U);
+  RunSyntheticChunks(chunks.size(), nThreads, [&](size_t iChunk)
+    {
+      nFilled[iChunk]
+        = FillSyntheticChunk(spacePoints, box, config, chunks[iChunk], 0);
+    });
+
+  //
+  // compaction of the filled points, with their final ID
+  //
+  size_t nextPoint = origNPoints;
+  int nextID = firstID;
+  for (size_t iChunk = 0; iChunk < chunks.size(); ++iChunk) {
+    size_t const first = chunks[iChunk].first;
+    for (size_t i = first; i < first + nFilled[iChunk]; ++i) {
+      recob::SpacePoint const& point = spacePoints[i];
+      spacePoints[nextPoint++] = recob::SpacePoint
+        (point.XYZ(), point.ErrXYZ(), point.Chisq(), nextID++);
+    } // for
+  } // for chunks
+  size_t const nSignal = nextPoint - origNPoints;
+
+  //
+  // noise and strays, in numbers depending on the signal points, are always
+  // filled completely, directly with their final ID
+  //
+  chunks.clear();
+  nextSlot = nextPoint;
+  double const signalScale
+    = nSignal / (1.0 - config.noiseFraction - config.strayFraction);
+
+  SyntheticChunk_t noise;
+  noise.kind = Kind_t::Noise;
+  AddSyntheticChunks(chunks, noise,
+    poisson(config.noiseFraction * signalScale), nextSlot, engine);
+
+  SyntheticChunk_t stray;
+  stray.kind = Kind_t::Stray;
+  AddSyntheticChunks(chunks, stray,
+    poisson(config.strayFraction * signalScale), nextSlot, engine);
+
+  spacePoints.resize(nextSlot);
+
+  RunSyntheticChunks(chunks.size(), nThreads, [&](size_t iChunk)
+    {
+      SyntheticChunk_t const& chunk = chunks[iChunk];
+      FillSyntheticChunk(
+        spacePoints, box, config, chunk,
+        nextID + int(chunk.first - nextPoint)
+        );
+    });
+
+  return spacePoints.size() - origNPoints;
+} // lar::example::tests::FillSyntheticEvent()
+
+
+//------------------------------------------------------------------------------
+void AddSyntheticChunks(
+  std::vector<SyntheticChunk_t>& chunks,
+  SyntheticChunk_t const& object, size_t nPoints, size_t& nextSlot,
+  lar::example::tests::SyntheticEngine_t& engine
+) {
+  using lar::example::tests::SyntheticChunkSize;
+
+  for (size_t firstStep = 0; firstStep < nPoints;
+    firstStep += SyntheticChunkSize
+  ) {
+    SyntheticChunk_t chunk = object;
+    chunk.firstStep = firstStep;
+    chunk.first = nextSlot;
+    chunk.nPoints = std::min<size_t>(SyntheticChunkSize, nPoints - firstStep);
+    chunk.seed = engine();
+    chunks.push_back(chunk);
+    nextSlot += chunk.nPoints;
+  } // for
+} // AddSyntheticChunks()
+
+
+//------------------------------------------------------------------------------
+size_t FillSyntheticChunk(
+  std::vector<recob::SpacePoint>& spacePoints,
+  geo::BoxBoundedGeo const& box,
+  lar::example::tests::SyntheticEventConfig_t const& config,
+  SyntheticChunk_t const& chunk,
+  int firstID
+) {
+  using lar::example::tests::Vector3D_t;
+  using lar::example::tests::MakeSpacePoint;
+  using Kind_t = SyntheticChunk_t::Kind_t;
+
+  lar::example::tests::SyntheticEngine_t engine(chunk.seed);
+  std::normal_distribution<double> gaus;
+
+  auto outputPoint = spacePoints.begin() + chunk.first;
+  int ID = firstID;
+  Vector3D_t point;
+
+  switch (chunk.kind) {
+
+    case Kind_t::Track: {
+      double const k = chunk.curvature;
+      for (size_t iStep = 0; iStep < chunk.nPoints; ++iStep) {
+        // we don't use an increment to avoid rounding errors
+        double const t = (chunk.firstStep + iStep) * config.trackStep;
+        // arc of circle, reducing to a straight line with no curvature
+        double const along = (k > 0.0)? std::sin(k * t) / k: t;
+        double const across = (k > 0.0)? (1.0 - std::cos(k * t)) / k: 0.0;
+        for (unsigned int i = 0; i < 3; ++i) {
+          point[i] = chunk.start[i] + along * chunk.dir[i]
+            + across * chunk.normal[i]
+            + ((config.jitter > 0.)? config.jitter * gaus(engine): 0.);
+        }
+        if (!IsInBox(box, point)) continue;
+        *(outputPoint++) = MakeSpacePoint(ID++, point.data(), config.jitter);
+      } // for
+      break;
+    } // track
+
+    case Kind_t::Shower: {
+      std::exponential_distribution<double> depth(1. / config.showerLength);
+      // two unit vectors orthogonal to the axis (and to each other)
+      Vector3D_t const u = OrthogonalDirection(chunk.dir);
+      Vector3D_t const v = CrossProduct(chunk.dir, u);
+      for (size_t iPoint = 0; iPoint < chunk.nPoints; ++iPoint) {
+        double const t = depth(engine);
+        double const spread
+          = config.showerWidth * (0.2 + t / config.showerLength);
+        double const a = spread * gaus(engine);
+        double const b = spread * gaus(engine);
+        for (unsigned int i = 0; i < 3; ++i)
+          point[i] = chunk.start[i] + t * chunk.dir[i] + a * u[i] + b * v[i];
+        if (!IsInBox(box, point)) continue;
+        *(outputPoint++) = MakeSpacePoint(ID++, point.data(), spread / 10.);
+      } // for
+      break;
+    } // shower
+
+    case Kind_t::Noise:
+      for (size_t iPoint = 0; iPoint < chunk.nPoints; ++iPoint) {
+        point = lar::example::tests::RandomPosition(box, engine);
+        *(outputPoint++)
+          = MakeSpacePoint(ID++, point.data(), config.trackStep);
+      } // for
+      break;
+
+    case Kind_t::Stray: {
+      // a point in the box, moved out of it on one of the coordinates
+      std::uniform_int_distribution<unsigned int> pickDim(0U, 2U);
+      std::bernoulli_distribution above;
+      std::uniform_real_distribution<double> uniform;
+      double const lower[3] = { box.MinX(), box.MinY(), box.MinZ() };
+      double const upper[3] = { box.MaxX(), box.MaxY(), box.MaxZ() };
+      for (size_t iPoint = 0; iPoint < chunk.nPoints; ++iPoint) {
+        point = lar::example::tests::RandomPosition(box, engine);
+        unsigned int const dim = pickDim(engine);
+        double const offset = config.strayMargin * (1.0 - uniform(engine));
+        point[dim] = above(engine)? upper[dim] + offset: lower[dim] - offset;
+        *(outputPoint++)
+          = MakeSpacePoint(ID++, point.data(), config.trackStep);
+      } // for
+      break;
+    } // stray
+
+  } // switch
+
+  return ID - firstID;
+} // FillSyntheticChunk()
+
+
+//------------------------------------------------------------------------------
+template <typename Op>
+void RunSyntheticChunks(size_t nChunks, unsigned int nThreads, Op op) {
+
+  if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+  nThreads
+    = std::max(1U, (unsigned int) std::min<size_t>(nThreads, nChunks));
+
+  //
+  // the chunks are handed out one at a time
+  //
+  std::atomic<size_t> nextChunk{ 0 };
+  std::vector<std::exception_ptr> errors(nThreads);
+  auto processChunks = [&](unsigned int iThread)
+    {
+      try {
+        for (size_t iChunk = nextChunk++; iChunk < nChunks;
+          iChunk = nextChunk++
+        ) {
+          op(iChunk);
+        }
+      }
+      catch (...) {
+        errors[iThread] = std::current_exception();
+        nextChunk = nChunks; // stop all the threads
+      }
+    };
+
+  std::vector<std::thread> workers;
+  workers.reserve(nThreads - 1);
+  for (unsigned int iThread = 1; iThread < nThreads; ++iThread)
+    workers.emplace_back(processChunks, iThread);
+  processChunks(0);
+  for (std::thread& worker: workers) worker.join();
+
+  for (std::exception_ptr const& error: errors)
+    if (error) std::rethrow_exception(error);
+
+} // RunSyntheticChunks()
+
+
+//------------------------------------------------------------------------------
+int NextSpacePointID(std::vector<recob::SpacePoint> const& spacePoints)
+  { return spacePoints.empty()? 1: spacePoints.back().ID() + 1; }
+
+
+//------------------------------------------------------------------------------
+bool IsInBox(
+  geo::BoxBoundedGeo const& box,
+  lar::example::tests::Vector3D_t const& point
+) {
+  return (point[0] >= box.MinX()) && (point[0] <= box.MaxX())
+    && (point[1] >= box.MinY()) && (point[1] <= box.MaxY())
+    && (point[2] >= box.MinZ()) && (point[2] <= box.MaxZ());
+} // IsInBox()
+
+
+//------------------------------------------------------------------------------
+lar::example::tests::Vector3D_t OrthogonalDirection
+  (lar::example::tests::Vector3D_t const& dir)
+{
+  // cross product with the axis least aligned with the direction
+  lar::example::tests::Vector3D_t const ref = (std::abs(dir[0]) < 0.9)
+    ? lar::example::tests::Vector3D_t{{ 1., 0., 0. }}
+    : lar::example::tests::Vector3D_t{{ 0., 1., 0. }};
+  lar::example::tests::Vector3D_t u = CrossProduct(dir, ref);
+  double const norm = std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+  for (double& c: u) c /= norm;
+  return u;
+} // OrthogonalDirection()
+
+
+//------------------------------------------------------------------------------
+lar::example::tests::Vector3D_t CrossProduct(
+  lar::example::tests::Vector3D_t const& a,
+  lar::example::tests::Vector3D_t const& b
+) {
+  return {{
+    a[1] * b[2] - a[2] * b[1],
+    a[2] * b[0] - a[0] * b[2],
+    a[0] * b[1] - a[1] * b[0]
+    }};
+} // CrossProduct()
+
+
 //------------------------------------------------------------------------------
 std::pair<int, int> ComputeRangeIndices
   (double min, double max, double stepSize)
@@ -10,6 +10,8 @@
  *
  * * MakeSpacePoint(): helper to create a new space point
  * * FillSpacePointGrid(): helper to create a grid of space points
+ * * FillSyntheticEvent(): helper to create space points from synthetic
+ *   tracks, showers and noise
  *
  */
 
@@ -22,6 +24,8 @@
 
 // C/C++ standard libraries
 #include <vector>
+#include <array>
+#include <random>
 
 
 namespace lar {
@@ -65,6 +69,101 @@ namespace lar {
         double stepSize
         );
 
+
+      /// Random engine used by the synthetic space point generators
+      using SyntheticEngine_t = std::mt19937_64;
+
+      /// Type of a position or direction in space
+      using Vector3D_t = std::array<double, 3U>;
+
+      /// Returns a random direction, uniformly distributed in space
+      Vector3D_t RandomDirection(SyntheticEngine_t& engine);
+
+      /// Returns a random position, uniformly distributed in the box
+      Vector3D_t RandomPosition
+        (geo::BoxBoundedGeo const& box, SyntheticEngine_t& engine);
+
+
+      /// Content of a synthetic event (see `FillSyntheticEvent()`)
+      struct SyntheticEventConfig_t {
+
+        double tracks = 5.0; ///< average number of straight tracks
+        double curvedTracks = 0.0; ///< average number of curved tracks
+        double trackStep = 0.3; ///< distance between track points [cm]
+        double maxTrackLength = 300.0; ///< maximum length of a track [cm]
+        /// smallest radius of curvature of the curved tracks [cm]
+        double minCurvatureRadius = 100.0;
+        double jitter = 0.05; ///< smearing of the track points [cm]
+
+        double showers = 1.0; ///< average number of showers
+        double showerPoints = 2000.0; ///< average number of points per shower
+        double showerLength = 14.0; ///< average longitudinal extent [cm]
+        double showerWidth = 4.0; ///< transverse spread [cm]
+
+        double noiseFraction = 0.1; ///< average fraction of noise points
+        double strayFraction = 0.0; ///< average fraction of stray points
+        double strayMargin = 10.0; ///< largest distance of strays from box [cm]
+
+      }; // SyntheticEventConfig_t
+
+      /// Number of points filled as a single unit by `FillSyntheticEvent()`
+      constexpr unsigned int SyntheticChunkSize = 16384U;
+
+      /**
+       * @brief Creates the space points of a synthetic event
+       * @param spacePoints the container to be filled
+       * @param box the volume the points must be in
+       * @param config content of the event
+       * @param seed seed of the random generation
+       * @param nThreads number of threads to use (`0`: one per hardware core)
+       * @return the number of space points added
+       *
+       * The event is made of:
+       *
+       * * straight tracks (on average `config.tracks` of them), starting at a
+       *   random point of `box` with random direction, and with a length
+       *   uniformly distributed up to `config.maxTrackLength`; a space point
+       *   is put every `config.trackStep`, smeared by `config.jitter`;
+       * * curved tracks (on average `config.curvedTracks`), like the straight
+       *   ones but bent on an arc of circle in a random plane, with curvature
+       *   uniformly distributed up to `1 / config.minCurvatureRadius`;
+       * * electromagnetic-like showers (on average `config.showers`), from a
+       *   random point of `box` with random direction; the number of points of
+       *   each shower follows a Poisson distribution with mean
+       *   `config.showerPoints`; the distance of the points from the vertex
+       *   along the axis is exponentially distributed with mean
+       *   `config.showerLength`, and the distance from the axis is gaussian,
+       *   with a spread growing from a fifth of `config.showerWidth` at the
+       *   vertex by `config.showerWidth` every `config.showerLength`;
+       * * noise points, uniformly distributed in `box`, such that on average
+       *   `config.noiseFraction` of all the points are noise;
+       * * stray points, out of `box` by up to `config.strayMargin` on one
+       *   coordinate, such that on average `config.strayFraction` of all the
+       *   points are strays.
+       *
+       * Track and shower points out of `box` are discarded. Stray points are
+       * never in `box`: they are meant to exercise code that must cope with
+       * points out of the expected volume (the isolation algorithms reject
+       * them).
+       *
+       * The collection is resized once for all the tracks and showers, and
+       * once more for noise and strays, and the points are filled in chunks of
+       * up to `SyntheticChunkSize` points, distributed among `nThreads`
+       * threads. Each chunk has its own random generator, seeded from `seed`
+       * while planning the event, so that the result depends only on `seed`
+       * and `config`, and not on the number of threads.
+       * The IDs follow the ones in the collection, as in
+       * `FillSpacePointGrid()`. The uncertainty of the track points is
+       * `config.jitter`, the one of noise and strays `config.trackStep`.
+       */
+      unsigned int FillSyntheticEvent(
+        std::vector<recob::SpacePoint>& spacePoints,
+        geo::BoxBoundedGeo const& box,
+        SyntheticEventConfig_t const& config,
+        SyntheticEngine_t::result_type seed,
+        unsigned int nThreads = 1
+        );
+
       /// @}
       // END RemoveIsolatedSpacePoints group -----------------------------------
 
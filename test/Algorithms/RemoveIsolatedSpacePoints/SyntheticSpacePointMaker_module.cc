@@ -0,0 +1,360 @@
+/**
+ * @file   SyntheticSpacePointMaker_module.cc
+ * @brief  Module creating space points from synthetic events, for benchmarks
+ * @ingroup RemoveIsolatedSpacePoints
+ *
+ */
+
+// LArSoft libraries
+#include "SpacePointTestUtils.h"
+#include "larexamples/Algorithms/RemoveIsolatedSpacePoints/SpacePointIndex.h"
+#include "lardataobj/RecoBase/SpacePoint.h"
+#include "larcore/Geometry/Geometry.h"
+
+// framework libraries
+#include "art/Framework/Core/SharedProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "fhiclcpp/types/Atom.h"
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <random>
+#include <memory> // std::make_unique()
+
+
+namespace lar {
+  namespace example {
+    namespace tests {
+
+      // BEGIN RemoveIsolatedSpacePoints group ---------------------------------
+      /// @ingroup RemoveIsolatedSpacePoints
+      /// @{
+      /**
+       * @brief  Creates a collection of space points with a synthetic topology
+       *
+       * A collection of space points is added to the event, made of:
+       *
+       * * straight tracks, starting at a random point of the detector with
+       *   random direction and a length uniformly distributed up to
+       *   `maxTrackLength`, with a space point every `trackStep`, each
+       *   smeared by `jitter`;
+       * * curved tracks, like the straight ones but bent on an arc of circle
+       *   with radius not smaller than `minCurvatureRadius`;
+       * * electromagnetic-like showers, starting at a random point with
+       *   random direction; the number of points in each shower follows a
+       *   Poisson distribution with mean `showerPoints`, and the points are
+       *   spread along the axis with exponential profile (`showerLength`)
+       *   and around it with a gaussian one (`showerWidth`);
+       * * uniform noise, whose amount is such that on average a fraction
+       *   `noiseFraction` of all the points of the event is noise;
+       * * stray points just out of the detector (up to `strayMargin`), whose
+       *   amount is such that on average a fraction `strayFraction` of all
+       *   the points of the event is stray.
+       *
+       * The number of tracks and of showers in each event follows a Poisson
+       * distribution with mean `tracks`, `curvedTracks` and `showers`
+       * respectively. Track and shower points out of the detector (the box
+       * including all the TPCs) are discarded.
+       * See `FillSyntheticEvent()` for the details.
+       *
+       * The random generator is seeded on each event from `seed` and the event
+       * ID, so that the content of an event does not depend on which other
+       * events are processed, nor on their order, nor on the number of
+       * threads used to create it (`threads`).
+       *
+       * This is a shared module: since the content of an event depends only
+       * on the configuration and on the event ID, several events may be
+       * created at the same time.
+       *
+       * The space points are not associated to anything.
+       *
+       * Configuration parameters
+       * =========================
+       *
+       * * *tracks* (real, default: `5`): average number of straight tracks
+       *   per event
+       * * *curvedTracks* (real, default: `0`): average number of curved tracks
+       *   per event
+       * * *trackStep* (real, default: `0.3`): distance between track space
+       *   points [cm]
+       * * *maxTrackLength* (real, default: `300`): maximum length of a
+       *   track [cm]
+       * * *minCurvatureRadius* (real, default: `100`): smallest radius of
+       *   curvature of the curved tracks [cm]
+       * * *showers* (real, default: `1`): average number of showers per event
+       * * *showerPoints* (real, default: `2000`): average number of space
+       *   points in a shower
+       * * *showerLength* (real, default: `14`): average longitudinal extent of
+       *   the showers [cm]
+       * * *showerWidth* (real, default: `4`): transverse spread of the showers
+       *   [cm]
+       * * *noiseFraction* (real, default: `0.1`): average fraction of noise
+       *   points in the event (`0` to less than `1`)
+       * * *strayFraction* (real, default: `0`): average fraction of stray
+       *   points in the event (together with `noiseFraction`, less than `1`)
+       * * *strayMargin* (real, default: `10`): largest distance of the stray
+       *   points from the detector [cm]
+       * * *jitter* (real, default: `0.05`): smearing of the track points [cm]
+       * * *seed* (integer, default: `0`): seed of the random generator
+       * * *threads* (integer, default: `1`): number of threads filling the
+       *   points (`0`: one per hardware core)
+       *
+       */
+      class SyntheticSpacePointMaker: public art::SharedProducer {
+
+          public:
+
+        struct Config {
+
+          using Name    = fhicl::Name;
+          using Comment = fhicl::Comment;
+
+          fhicl::Atom<double> tracks{
+            Name("tracks"),
+            Comment("average number of straight tracks per event"),
+            5.0
+            };
+
+          fhicl::Atom<double> curvedTracks{
+            Name("curvedTracks"),
+            Comment("average number of curved tracks per event"),
+            0.0
+            };
+
+          fhicl::Atom<double> trackStep{
+            Name("trackStep"),
+            Comment("distance between track space points [cm]"),
+            0.3
+            };
+
+          fhicl::Atom<double> maxTrackLength{
+            Name("maxTrackLength"),
+            Comment("maximum length of a track [cm]"),
+            300.0
+            };
+
+          fhicl::Atom<double> minCurvatureRadius{
+            Name("minCurvatureRadius"),
+            Comment("smallest radius of curvature of the curved tracks [cm]"),
+            100.0
+            };
+
+          fhicl::Atom<double> showers{
+            Name("showers"),
+            Comment("average number of showers per event"),
+            1.0
+            };
+
+          fhicl::Atom<double> showerPoints{
+            Name("showerPoints"),
+            Comment("average number of space points in a shower"),
+            2000.0
+            };
+
+          fhicl::Atom<double> showerLength{
+            Name("showerLength"),
+            Comment("average longitudinal extent of the showers [cm]"),
+            14.0
+            };
+
+          fhicl::Atom<double> showerWidth{
+            Name("showerWidth"),
+            Comment("transverse spread of the showers [cm]"),
+            4.0
+            };
+
+          fhicl::Atom<double> noiseFraction{
+            Name("noiseFraction"),
+            Comment("average fraction of noise points in the event"),
+            0.1
+            };
+
+          fhicl::Atom<double> strayFraction{
+            Name("strayFraction"),
+            Comment("average fraction of points out of the detector"),
+            0.0
+            };
+
+          fhicl::Atom<double> strayMargin{
+            Name("strayMargin"),
+            Comment("largest distance of the stray points from the detector"),
+            10.0
+            };
+
+          fhicl::Atom<double> jitter{
+            Name("jitter"),
+            Comment("smearing of the track points [cm]"),
+            0.05
+            };
+
+          fhicl::Atom<unsigned int> seed{
+            Name("seed"),
+            Comment("seed of the random generator"),
+            0U
+            };
+
+          fhicl::Atom<unsigned int> threads{
+            Name("threads"),
+            Comment("number of threads filling the points (0: all cores)"),
+            1U
+            };
+
+        }; // Config
+
+        using Parameters = art::SharedProducer::Table<Config>;
+
+        /// Constructor; see the class documentation for the configuration
+        explicit SyntheticSpacePointMaker
+          (Parameters const& config, art::ProcessingFrame const&);
+
+        /// Create and add the points of a new synthetic event
+        virtual void produce
+          (art::Event& event, art::ProcessingFrame const&) override;
+
+          private:
+
+        SyntheticEventConfig_t eventConfig; ///< content of the events
+        unsigned int seed; ///< seed of the random generator
+        unsigned int nThreads; ///< number of threads filling the points
+
+      }; // class SyntheticSpacePointMaker
+
+      /// @}
+      // END RemoveIsolatedSpacePoints group -----------------------------------
+
+
+    } // namespace tests
+  } // namespace example
+} // namespace lar
+
+
+//------------------------------------------------------------------------------
+//--- module implementation
+//---
+
+lar::example::tests::SyntheticSpacePointMaker::SyntheticSpacePointMaker
+  (Parameters const& config, art::ProcessingFrame const&)
+  : SharedProducer{config}
+  , seed(config().seed())
+  , nThreads(config().threads())
+{
+  eventConfig.tracks = config().tracks();
+  eventConfig.curvedTracks = config().curvedTracks();
+  eventConfig.trackStep = config().trackStep();
+  eventConfig.maxTrackLength = config().maxTrackLength();
+  eventConfig.minCurvatureRadius = config().minCurvatureRadius();
+  eventConfig.jitter = config().jitter();
+  eventConfig.showers = config().showers();
+  eventConfig.showerPoints = config().showerPoints();
+  eventConfig.showerLength = config().showerLength();
+  eventConfig.showerWidth = config().showerWidth();
+  eventConfig.noiseFraction = config().noiseFraction();
+  eventConfig.strayFraction = config().strayFraction();
+  eventConfig.strayMargin = config().strayMargin();
+
+  if ((eventConfig.tracks < 0.0) || (eventConfig.curvedTracks < 0.0)
+    || (eventConfig.showers < 0.0) || (eventConfig.showerPoints < 0.0)
+  ) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Average numbers of tracks (" << config().tracks.name() << ": "
+      << eventConfig.tracks << ", " << config().curvedTracks.name() << ": "
+      << eventConfig.curvedTracks << "), of showers ("
+      << config().showers.name() << ": " << eventConfig.showers
+      << ") and of shower points (" << config().showerPoints.name() << ": "
+      << eventConfig.showerPoints << ") can't be negative\n";
+  }
+  if (eventConfig.maxTrackLength < 0.0) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Maximum track length (" << config().maxTrackLength.name() << ": "
+      << eventConfig.maxTrackLength << ") can't be negative\n";
+  }
+  if (eventConfig.jitter < 0.0) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Track point smearing (" << config().jitter.name() << ": "
+      << eventConfig.jitter << ") can't be negative\n";
+  }
+  if ((eventConfig.noiseFraction < 0.0) || (eventConfig.strayFraction < 0.0)
+    || (eventConfig.noiseFraction + eventConfig.strayFraction >= 1.0)
+  ) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Noise fraction (" << config().noiseFraction.name() << ": "
+      << eventConfig.noiseFraction << ") and stray fraction ("
+      << config().strayFraction.name() << ": " << eventConfig.strayFraction
+      << ") must be non-negative, and their sum smaller than 1\n";
+  }
+  if (eventConfig.trackStep <= 0.0) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Track step (" << config().trackStep.name() << ": "
+      << eventConfig.trackStep << ") must be positive\n";
+  }
+  if ((eventConfig.curvedTracks > 0.0)
+    && (eventConfig.minCurvatureRadius <= 0.0)
+  ) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Minimum curvature radius (" << config().minCurvatureRadius.name()
+      << ": " << eventConfig.minCurvatureRadius << ") must be positive\n";
+  }
+  if ((eventConfig.showerLength <= 0.0) || (eventConfig.showerWidth <= 0.0)) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Shower length (" << eventConfig.showerLength << ") and width ("
+      << eventConfig.showerWidth << ") must be positive\n";
+  }
+  if ((eventConfig.strayFraction > 0.0) && (eventConfig.strayMargin <= 0.0)) {
+    throw cet::exception("SyntheticSpacePointMaker")
+      << "Stray margin (" << config().strayMargin.name() << ": "
+      << eventConfig.strayMargin << ") must be positive\n";
+  }
+
+  produces<std::vector<recob::SpacePoint>>();
+
+  // the configuration is not modified while processing events
+  async<art::InEvent>();
+
+} // lar::example::tests::SyntheticSpacePointMaker::SyntheticSpacePointMaker()
+
+
+//------------------------------------------------------------------------------
+void lar::example::tests::SyntheticSpacePointMaker::produce
+  (art::Event& event, art::ProcessingFrame const&)
+{
+
+  //
+  // set up
+  //
+
+  // container for the data product
+  auto spacePoints = std::make_unique<std::vector<recob::SpacePoint>>();
+
+  // acquire the geometry information
+  auto const* geom = lar::providerFrom<geo::Geometry>();
+  geo::BoxBoundedGeo const volume = SpacePointIndex::detectorVolume(*geom);
+
+  // the sequence of random numbers depends only on the seed and the event
+  std::seed_seq seeds{
+    seed, event.run(), event.subRun(), event.event()
+    };
+  SyntheticEngine_t engine(seeds);
+
+  //
+  // creation of the points
+  //
+  unsigned int const nPoints = FillSyntheticEvent
+    (*spacePoints, volume, eventConfig, engine(), nThreads);
+
+  //
+  // result storage
+  //
+  mf::LogInfo("SyntheticSpacePointMaker")
+    << "Created " << nPoints << " space points";
+
+  event.put(std::move(spacePoints));
+
+} // lar::example::tests::SyntheticSpacePointMaker::produce()
+
+
+//------------------------------------------------------------------------------
+DEFINE_ART_MODULE(lar::example::tests::SyntheticSpacePointMaker)
+
+//------------------------------------------------------------------------------